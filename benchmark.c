@@ -0,0 +1,48 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+#include <sys/time.h>
+#include <string.h>
+#include <dirent.h>
+
+#include "headers/TSPUTILS.h"
+#include "headers/TOURHASH.h"
+#include "headers/TRACE.h"
+#include "headers/RUNCONTROL.h"
+#include "headers/NEIGHBORS.h"
+#include "headers/MATCHING.h"
+#include "headers/CONSTRUCT.h"
+#include "headers/WARMSTART.h"
+#include "headers/LK.h"
+#include "headers/VNS.h"
+#include "headers/BACKBONE.h"
+#include "headers/MERGE.h"
+#include "headers/GPX.h"
+#include "headers/EAX.h"
+#include "headers/SA2OPT.h"
+#include "headers/SOLVERS.h"
+#include "headers/STATS.h"
+#include "headers/BATCH.h"
+#include "headers/BENCHMARK.h"
+
+// Usage: TSP_Benchmark [instance folder] [budget in seconds ...]
+int main(int argc, char *argv[]) {
+    const char *instanceFolder = argc > 1 ? argv[1] : "input_problems/";
+    double budgets[BENCHMARK_MAX_BUDGETS] = {0.1, 1.0, 5.0};
+    int numBudgets = 3;
+
+    if (argc > 2) {
+        numBudgets = 0;
+        for (int i = 2; i < argc && numBudgets < BENCHMARK_MAX_BUDGETS; i++) {
+            double budget = atof(argv[i]);
+            if (budget <= 0.0) {
+                printf("Invalid time budget: %s\n", argv[i]);
+                return 1;
+            }
+            budgets[numBudgets++] = budget;
+        }
+    }
+
+    return runBenchmark(instanceFolder, budgets, numBudgets, 1);
+}
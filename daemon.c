@@ -0,0 +1,39 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+#include <sys/time.h>
+#include <string.h>
+#include <dirent.h>
+
+#include "headers/TSPUTILS.h"
+#include "headers/TOURHASH.h"
+#include "headers/TRACE.h"
+#include "headers/RUNCONTROL.h"
+#include "headers/NEIGHBORS.h"
+#include "headers/MATCHING.h"
+#include "headers/CONSTRUCT.h"
+#include "headers/WARMSTART.h"
+#include "headers/LK.h"
+#include "headers/VNS.h"
+#include "headers/BACKBONE.h"
+#include "headers/MERGE.h"
+#include "headers/GPX.h"
+#include "headers/EAX.h"
+#include "headers/SA2OPT.h"
+#include "headers/SOLVERS.h"
+#include "headers/STATS.h"
+#include "headers/BATCH.h"
+#include "headers/DAEMON.h"
+
+// Usage: TSP_Daemon [socket path] [worker threads] [cached instances]
+int main(int argc, char *argv[]) {
+    const char *socketPath = argc > 1 ? argv[1] : "/tmp/tsp_solver.sock";
+    if (argc > 2) {
+        daemonWorkers = atoi(argv[2]);
+    }
+    if (argc > 3) {
+        daemonCacheSize = atoi(argv[3]);
+    }
+    return runDaemon(socketPath);
+}
@@ -0,0 +1,199 @@
+// BACKBONE.h - The header file for backbone problem reduction
+// Edges that all elite tours agree on (the backbone) are fixed. Every maximal path of
+// fixed edges is contracted to its two end cities joined by one fixed super-edge, the
+// smaller instance is searched with moves that never remove a fixed edge, and the
+// result is expanded back into a tour of the full instance.
+
+#ifndef BACKBONE_H
+#define BACKBONE_H
+
+#define BACKBONE_ELITES 10    // Elite tours a genetic algorithm hands to the reduction
+
+struct ReducedProblem {
+    struct Graph graph;        // Kept cities: ends of contracted paths and free cities
+    int original[MAX_NODES];   // City of the full instance behind each reduced city
+    int partner[MAX_NODES];    // Other end of the super-edge, -1 for a free city
+    int innerStart[MAX_NODES]; // Inner cities of the contracted path in pathCities ...
+    int innerCount[MAX_NODES];
+    bool innerForward[MAX_NODES]; // ... listed from this end (true) or from the partner
+    int pathCities[MAX_NODES];
+};
+
+// Marks in fixed[v][s] whether the edge from v to its s-th neighbor in the first elite
+// tour is in every elite tour. adj receives the neighbors in the first elite tour.
+// Returns the number of fixed edges.
+int findBackbone(int (*elites)[MAX_NODES], int numElites, int numNodes, int (*adj)[2], bool (*fixed)[2]) {
+    int other[MAX_NODES][2];
+    for (int i = 0; i < numNodes; i++) {
+        int v = elites[0][i];
+        adj[v][0] = elites[0][(i - 1 + numNodes) % numNodes];
+        adj[v][1] = elites[0][(i + 1) % numNodes];
+        fixed[v][0] = true;
+        fixed[v][1] = true;
+    }
+    for (int e = 1; e < numElites; e++) {
+        for (int i = 0; i < numNodes; i++) {
+            int v = elites[e][i];
+            other[v][0] = elites[e][(i - 1 + numNodes) % numNodes];
+            other[v][1] = elites[e][(i + 1) % numNodes];
+        }
+        for (int v = 0; v < numNodes; v++) {
+            for (int s = 0; s < 2; s++) {
+                fixed[v][s] = fixed[v][s] && (other[v][0] == adj[v][s] || other[v][1] == adj[v][s]);
+            }
+        }
+    }
+
+    int count = 0;
+    for (int v = 0; v < numNodes; v++) {
+        count += fixed[v][0] + fixed[v][1];
+    }
+    return count / 2;
+}
+
+// Contracts every path of fixed edges. reducedIndex[v] receives the reduced city of v,
+// or -1 for the inner cities of a path.
+void buildReducedProblem(struct Graph *graph, int (*adj)[2], bool (*fixed)[2], struct ReducedProblem *reduced, int *reducedIndex) {
+    int n = graph->numNodes;
+    int m = 0;
+    for (int v = 0; v < n; v++) {
+        reducedIndex[v] = -1;
+    }
+    for (int v = 0; v < n; v++) {
+        if (fixed[v][0] + fixed[v][1] < 2) {
+            reducedIndex[v] = m;
+            reduced->original[m] = v;
+            reduced->graph.nodes[m] = graph->nodes[v];
+            reduced->partner[m] = -1;
+            reduced->innerCount[m] = 0;
+            m++;
+        }
+    }
+    reduced->graph.numNodes = m;
+
+    // Walk every path from its end with the lower reduced index
+    int stored = 0;
+    for (int r = 0; r < m; r++) {
+        int v = reduced->original[r];
+        int s = fixed[v][0] ? 0 : (fixed[v][1] ? 1 : -1);
+        if (s < 0 || reduced->partner[r] >= 0) {
+            continue;
+        }
+        int start = stored;
+        int prev = v, curr = adj[v][s];
+        while (reducedIndex[curr] < 0) {
+            reduced->pathCities[stored++] = curr;
+            int next = adj[curr][0] != prev ? adj[curr][0] : adj[curr][1];
+            prev = curr;
+            curr = next;
+        }
+        int q = reducedIndex[curr];
+        reduced->partner[r] = q;
+        reduced->partner[q] = r;
+        reduced->innerStart[r] = reduced->innerStart[q] = start;
+        reduced->innerCount[r] = reduced->innerCount[q] = stored - start;
+        reduced->innerForward[r] = true;
+        reduced->innerForward[q] = false;
+    }
+}
+
+// Writes the full tour behind a tour of the reduced instance
+void expandReducedTour(struct ReducedProblem *reduced, int *reducedTour, int *tour) {
+    int m = reduced->graph.numNodes;
+    int size = 0;
+    for (int i = 0; i < m; i++) {
+        int r = reducedTour[i];
+        int q = reducedTour[(i + 1) % m];
+        tour[size++] = reduced->original[r];
+        // With two reduced cities both tour edges join them, the path is walked once
+        if (reduced->partner[r] == q && (m > 2 || i == 0)) {
+            int start = reduced->innerStart[r];
+            int count = reduced->innerCount[r];
+            for (int k = 0; k < count; k++) {
+                tour[size++] = reduced->pathCities[start + (reduced->innerForward[r] ? k : count - 1 - k)];
+            }
+        }
+    }
+}
+
+// Iterated local search on the reduced instance: localized shakes repaired by the
+// candidate 2-opt / Or-opt descent, kept when shorter. Fixed edges are never removed.
+void searchReducedProblem(struct ReducedProblem *reduced, int *tour, int trials, struct Rng *rng) {
+    struct Graph *graph = &reduced->graph;
+    int m = graph->numNodes;
+    if (m < 8) {
+        return;
+    }
+
+    struct SpatialGrid *grid = malloc(sizeof(struct SpatialGrid));
+    struct CandidateList *candidates = malloc(sizeof(struct CandidateList));
+    buildSpatialGrid(graph, grid);
+    buildCandidateList(graph, grid, candidates, 8);
+    candidates->fixedPartner = reduced->partner;
+    free(grid);
+
+    int pos[MAX_NODES], all[MAX_NODES];
+    int trialTour[MAX_NODES], trialPos[MAX_NODES];
+    for (int i = 0; i < m; i++) {
+        pos[tour[i]] = i;
+        all[i] = tour[i];
+    }
+    neighborLocalSearch(graph, tour, pos, candidates, all, m, true, NULL, NULL);
+
+    for (int t = 0; t < trials; t++) {
+        memcpy(trialTour, tour, m * sizeof(int));
+        memcpy(trialPos, pos, m * sizeof(int));
+        bool known;
+        double delta = localizedShake(graph, trialTour, trialPos, candidates, 1 + rngInt(rng, 3), VNS_GENERAL, rng, NULL, NULL, &known);
+        if (delta < -1e-9) {
+            memcpy(tour, trialTour, m * sizeof(int));
+            memcpy(pos, trialPos, m * sizeof(int));
+        }
+    }
+    free(candidates);
+}
+
+// Fixes the backbone of the elite tours, searches the reduced instance starting from
+// the first elite with 'trials' shake + repair trials (0 = 50 per reduced city) and
+// writes the expanded result to tour, which is never longer than the first elite.
+// Returns the number of cities of the reduced instance.
+int backboneIntensify(struct Graph *graph, int (*elites)[MAX_NODES], int numElites, int *tour, int trials, unsigned long long seed) {
+    int n = graph->numNodes;
+    memcpy(tour, elites[0], n * sizeof(int));
+
+    int (*adj)[2] = malloc(MAX_NODES * sizeof(*adj));
+    bool (*fixed)[2] = malloc(MAX_NODES * sizeof(*fixed));
+    int fixedEdges = findBackbone(elites, numElites, n, adj, fixed);
+    if (fixedEdges >= n) {
+        // All elites are the same tour
+        free(fixed);
+        free(adj);
+        return 0;
+    }
+
+    struct ReducedProblem *reduced = malloc(sizeof(struct ReducedProblem));
+    int reducedIndex[MAX_NODES];
+    buildReducedProblem(graph, adj, fixed, reduced, reducedIndex);
+    int m = reduced->graph.numNodes;
+
+    // The first elite contains every fixed path, so its reduced order keeps path ends adjacent
+    int reducedTour[MAX_NODES];
+    int size = 0;
+    for (int i = 0; i < n; i++) {
+        if (reducedIndex[elites[0][i]] >= 0) {
+            reducedTour[size++] = reducedIndex[elites[0][i]];
+        }
+    }
+
+    struct Rng rng;
+    rngSeed(&rng, seed);
+    searchReducedProblem(reduced, reducedTour, trials > 0 ? trials : 50 * m, &rng);
+    expandReducedTour(reduced, reducedTour, tour);
+
+    free(reduced);
+    free(fixed);
+    free(adj);
+    return m;
+}
+
+#endif
@@ -0,0 +1,408 @@
+// BATCH.h - The header file for the parallel batch mode
+// Every (instance, algorithm, seed) triple is a job. Instances are read and preprocessed
+// (renumbering, MST, start tour) once and shared read-only by their jobs. Jobs are
+// dealt largest instance first to per-worker work-stealing deques: a worker takes its
+// own jobs from the bottom and, once it runs dry, steals from the top of the others.
+// Every worker owns one context per solver, set up once and reused for all its jobs.
+// With several seeds the runs of every (instance, algorithm) pair are summarized
+// (STATS.h) in results/summary.csv, and results/runs.csv records the seed, length and
+// time of every run, so any run can be replayed by setting its seed in the context.
+// The convergence trace (TRACE.h) of every job goes next to its results file.
+
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+
+#define BATCH_MAX_INSTANCES 64
+#define BATCH_MAX_WORKERS 64
+
+int batchWorkers = 0;   // Worker threads of the batch scheduler (0 = one per online core)
+int batchSeeds = 1;     // Runs per (instance, algorithm)
+unsigned long long batchBaseSeed = 1;   // Run s = 0, 1, ... of every pair gets seed batchBaseSeed + s
+int batchSolverThreads = 1;   // Threads of each parallel solver inside a job (0 = one per online core)
+bool batchWarmStart = false;  // Start every job from the tour of its results file, when it has one
+
+struct BatchInstance {
+    char path[PATH_MAX];
+    struct Graph inputGraph;   // As read, used for the results file
+    struct Graph graph;        // Renumbered, seen by the solvers
+    struct CityOrder order;
+    int mstParent[MAX_NODES];
+    double mstLength;
+    double mstTime;
+    int startTour[MAX_NODES];
+};
+
+struct BatchJob {
+    int numNodes;   // Size of the instance, the priority of the job
+    int instance;
+    int algorithm;
+    unsigned long long seed;
+    double tourLength;      // Results of the run
+    double executionTime;
+};
+
+// Chase-Lev work-stealing deque of job indices. The owner pushes and pops at the bottom,
+// thieves take from the top; the two only race for the last job, settled by a CAS on
+// top. Jobs are all pushed before the workers start, so the buffer never grows.
+struct WorkDeque {
+    atomic_long top;
+    atomic_long bottom;
+    long capacity;
+    int *slots;
+};
+
+#define DEQUE_EMPTY -1
+#define DEQUE_ABORT -2   // Lost a race with another thread, worth retrying
+
+void dequeInit(struct WorkDeque *deque, long capacity) {
+    atomic_init(&deque->top, 0);
+    atomic_init(&deque->bottom, 0);
+    deque->capacity = capacity > 0 ? capacity : 1;
+    deque->slots = malloc(deque->capacity * sizeof(int));
+}
+
+void dequePush(struct WorkDeque *deque, int job) {
+    long b = atomic_load_explicit(&deque->bottom, memory_order_relaxed);
+    deque->slots[b % deque->capacity] = job;
+    atomic_store_explicit(&deque->bottom, b + 1, memory_order_release);
+}
+
+int dequePop(struct WorkDeque *deque) {
+    long b = atomic_load_explicit(&deque->bottom, memory_order_relaxed) - 1;
+    atomic_store_explicit(&deque->bottom, b, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    long t = atomic_load_explicit(&deque->top, memory_order_relaxed);
+    if (t > b) {
+        atomic_store_explicit(&deque->bottom, b + 1, memory_order_relaxed);
+        return DEQUE_EMPTY;
+    }
+    int job = deque->slots[b % deque->capacity];
+    if (t == b) {
+        // Last job: a thief may be taking it too
+        if (!atomic_compare_exchange_strong_explicit(&deque->top, &t, t + 1, memory_order_seq_cst, memory_order_relaxed)) {
+            job = DEQUE_EMPTY;
+        }
+        atomic_store_explicit(&deque->bottom, b + 1, memory_order_relaxed);
+    }
+    return job;
+}
+
+int dequeSteal(struct WorkDeque *deque) {
+    long t = atomic_load_explicit(&deque->top, memory_order_acquire);
+    atomic_thread_fence(memory_order_seq_cst);
+    long b = atomic_load_explicit(&deque->bottom, memory_order_acquire);
+    if (t >= b) {
+        return DEQUE_EMPTY;
+    }
+    int job = deque->slots[t % deque->capacity];
+    if (!atomic_compare_exchange_strong_explicit(&deque->top, &t, t + 1, memory_order_seq_cst, memory_order_relaxed)) {
+        return DEQUE_ABORT;
+    }
+    return job;
+}
+
+struct Batch {
+    struct BatchInstance *instances;
+    int numInstances;
+    struct BatchJob *jobs;
+    int numJobs;
+    int numWorkers;
+    struct WorkDeque deques[BATCH_MAX_WORKERS];
+    atomic_int completed;
+};
+
+struct BatchWorker {
+    struct Batch *batch;
+    int id;
+    void *contexts[NUM_SOLVERS];   // One per solver (SOLVERS.h)
+    struct Trace *trace;           // Shared by the contexts: a worker runs one job at a time
+};
+
+void batchWorkerInit(struct BatchWorker *worker, struct Batch *batch, int id) {
+    worker->batch = batch;
+    worker->id = id;
+    for (int s = 0; s < NUM_SOLVERS; s++) {
+        worker->contexts[s] = solvers[s].create();
+    }
+    worker->trace = malloc(sizeof(struct Trace));
+}
+
+void batchWorkerFree(struct BatchWorker *worker) {
+    for (int s = 0; s < NUM_SOLVERS; s++) {
+        solvers[s].destroy(worker->contexts[s]);
+    }
+    free(worker->trace);
+}
+
+void runBatchJob(struct BatchWorker *worker, struct BatchJob *job) {
+    struct Batch *batch = worker->batch;
+    struct BatchInstance *instance = &batch->instances[job->instance];
+    struct Graph *graph = &instance->graph;
+    const struct Solver *solver = &solvers[job->algorithm];
+    const char *algorithm = solver->name;
+    int tour[MAX_NODES], outputTour[MAX_NODES];
+
+    // With several seeds every seed gets its own results folder
+    char outputFolder[32];
+    if (batchSeeds > 1) {
+        snprintf(outputFolder, sizeof(outputFolder), "results/seed%llu", job->seed);
+    } else {
+        snprintf(outputFolder, sizeof(outputFolder), "results");
+    }
+    char resultsFile[100];
+    resultsFilename(resultsFile, sizeof(resultsFile), outputFolder, algorithm, instance->path);
+
+    // Only this job writes its results file, so it can be read here without a lock
+    if (!batchWarmStart || !loadTourFile(graph, resultsFile, tour)) {
+        memcpy(tour, instance->startTour, graph->numNodes * sizeof(int));
+    }
+
+    struct SolverSettings settings;
+    solverSettingsInit(&settings);
+    settings.seed = job->seed;
+    settings.threads = batchSolverThreads;   // The jobs already keep every core busy
+    settings.trace = worker->trace;
+    solver->configure(worker->contexts[job->algorithm], &settings);
+
+    struct PerfRun perf;
+    perfRunBegin(&perf);
+    struct timeval start, end;
+    gettimeofday(&start, NULL);
+    solver->solve(worker->contexts[job->algorithm], graph, tour);
+    gettimeofday(&end, NULL);
+    perfRunEnd(&perf);
+
+    double executionTime = (end.tv_sec - start.tv_sec) + (end.tv_usec - start.tv_usec) / 1000000.0;
+    double finalTourLength = calculateTourLength(graph, tour);
+    job->tourLength = finalTourLength;
+    job->executionTime = executionTime;
+
+    mapTour(instance->order.original, graph->numNodes, tour, outputTour);
+    writeOutput(&instance->inputGraph, outputTour, finalTourLength, instance->mstLength, instance->mstTime, executionTime,
+                algorithm, instance->path, outputFolder);
+    writeTrace(worker->trace, algorithm, instance->path, outputFolder);
+    appendPerfCounters(resultsFile, "solver", &perf);
+
+    int done = atomic_fetch_add(&batch->completed, 1) + 1;
+    printf("[%d/%d] %s on %s (seed %llu) completed in %.6f seconds\n", done, batch->numJobs, algorithm, instance->path, job->seed,
+           executionTime);
+}
+
+void *batchWorkerThread(void *arg) {
+    struct BatchWorker *worker = arg;
+    struct Batch *batch = worker->batch;
+    for (;;) {
+        int job = dequePop(&batch->deques[worker->id]);
+        // Own deque is empty: steal, visiting the others from the next worker on
+        for (int v = 1; job < 0 && v < batch->numWorkers; v++) {
+            struct WorkDeque *victim = &batch->deques[(worker->id + v) % batch->numWorkers];
+            do {
+                job = dequeSteal(victim);
+            } while (job == DEQUE_ABORT);
+        }
+        if (job < 0) {
+            // No job spawns new jobs, so empty deques everywhere means the batch is done
+            return NULL;
+        }
+        runBatchJob(worker, &batch->jobs[job]);
+    }
+}
+
+// Preprocesses an instance whose inputGraph is set: the work every job on it would
+// otherwise repeat
+void preprocessBatchInstance(struct BatchInstance *instance) {
+    instance->graph = instance->inputGraph;
+    renumberGraph(&instance->graph, &instance->order);
+
+    struct timeval mstStart, mstEnd;
+    gettimeofday(&mstStart, NULL);
+    instance->mstLength = calculateMSTTree(&instance->graph, instance->mstParent);
+    gettimeofday(&mstEnd, NULL);
+    instance->mstTime = (mstEnd.tv_sec - mstStart.tv_sec) + (mstEnd.tv_usec - mstStart.tv_usec) / 1000000.0;
+
+    // Every algorithm starts from the same constructed tour
+    constructTour(&instance->graph, startMethod, instance->mstParent, &instance->order, instance->startTour);
+}
+
+// Reads and preprocesses one instance. Returns false if it cannot be read.
+bool prepareBatchInstance(struct BatchInstance *instance) {
+    if (!loadInput(&instance->inputGraph, instance->path)) {
+        return false;
+    }
+    preprocessBatchInstance(instance);
+    return true;
+}
+
+// Largest instance first
+int compareBatchJobs(const void *a, const void *b) {
+    const struct BatchJob *ja = a, *jb = b;
+    if (ja->numNodes != jb->numNodes) {
+        return jb->numNodes - ja->numNodes;
+    }
+    if (ja->instance != jb->instance) {
+        return ja->instance - jb->instance;
+    }
+    if (ja->algorithm != jb->algorithm) {
+        return ja->algorithm - jb->algorithm;
+    }
+    return (ja->seed > jb->seed) - (ja->seed < jb->seed);
+}
+
+// Writes every run to results/runs.csv and the distribution of every (instance,
+// algorithm) pair to results/summary.csv, and prints the summaries. The jobs are
+// sorted, so the runs of a pair are contiguous.
+void writeBatchStatistics(struct Batch *batch) {
+    FILE *runs = fopen("results/runs.csv", "w");
+    FILE *summary = fopen("results/summary.csv", "w");
+    if (runs == NULL || summary == NULL) {
+        printf("Failed to open the statistics files.\n");
+        if (runs != NULL) {
+            fclose(runs);
+        }
+        if (summary != NULL) {
+            fclose(summary);
+        }
+        return;
+    }
+    fprintf(runs, "instance,algorithm,seed,tour_length,execution_time\n");
+    fprintf(summary, "instance,algorithm,runs,best_seed");
+    writeSummaryHeader(summary, "length");
+    writeSummaryHeader(summary, "time");
+    fprintf(summary, "\n");
+
+    printf("\n%-24s %-8s %5s %14s %14s %12s %14s %10s\n", "Instance", "Solver", "Runs", "Min", "Mean", "Std", "Median",
+           "Mean time");
+    double *lengths = malloc(batch->numJobs * sizeof(double));
+    double *times = malloc(batch->numJobs * sizeof(double));
+    for (int first = 0; first < batch->numJobs;) {
+        struct BatchJob *head = &batch->jobs[first];
+        const char *path = batch->instances[head->instance].path;
+        const char *name = strrchr(path, '/') != NULL ? strrchr(path, '/') + 1 : path;
+        const char *algorithm = solvers[head->algorithm].name;
+
+        int count = 0;
+        unsigned long long bestSeed = head->seed;
+        double bestLength = head->tourLength;
+        for (int j = first; j < batch->numJobs && batch->jobs[j].instance == head->instance &&
+                            batch->jobs[j].algorithm == head->algorithm; j++) {
+            struct BatchJob *job = &batch->jobs[j];
+            lengths[count] = job->tourLength;
+            times[count] = job->executionTime;
+            count++;
+            if (job->tourLength < bestLength) {
+                bestLength = job->tourLength;
+                bestSeed = job->seed;
+            }
+            fprintf(runs, "%s,%s,%llu,%lf,%lf\n", name, algorithm, job->seed, job->tourLength, job->executionTime);
+        }
+
+        struct SampleSummary lengthSummary, timeSummary;
+        summarizeSamples(lengths, count, &lengthSummary);
+        summarizeSamples(times, count, &timeSummary);
+        fprintf(summary, "%s,%s,%d,%llu", name, algorithm, count, bestSeed);
+        writeSummaryColumns(summary, &lengthSummary);
+        writeSummaryColumns(summary, &timeSummary);
+        fprintf(summary, "\n");
+        printf("%-24s %-8s %5d %14.2f %14.2f %12.2f %14.2f %10.4f\n", name, algorithm, count, lengthSummary.min, lengthSummary.mean,
+               lengthSummary.stdDev, lengthSummary.median, timeSummary.mean);
+        first += count;
+    }
+    free(times);
+    free(lengths);
+    fclose(summary);
+    fclose(runs);
+}
+
+// Runs every algorithm on every .tsp file of instanceFolder. Returns 1 if the folder
+// cannot be opened.
+int runBatch(const char *instanceFolder) {
+    DIR *dp = opendir(instanceFolder);
+    if (dp == NULL) {
+        perror("Failed to open input_problems folder");
+        return 1;
+    }
+    struct Batch *batch = malloc(sizeof(struct Batch));
+    batch->instances = malloc(BATCH_MAX_INSTANCES * sizeof(struct BatchInstance));
+    batch->numInstances = 0;
+    struct dirent *entry;
+    while ((entry = readdir(dp)) && batch->numInstances < BATCH_MAX_INSTANCES) {
+        if (strstr(entry->d_name, ".tsp")) {
+            struct BatchInstance *instance = &batch->instances[batch->numInstances];
+            int length = snprintf(instance->path, sizeof(instance->path), "%s%s", instanceFolder, entry->d_name);
+            if (length >= (int) sizeof(instance->path)) {
+                printf("Skipping %s%s: the path is too long\n", instanceFolder, entry->d_name);
+                continue;
+            }
+            if (!prepareBatchInstance(instance)) {
+                printf("Skipping %s: it cannot be read or has no cities\n", instance->path);
+                continue;
+            }
+            batch->numInstances++;
+            printf("Loaded instance: %s (%d nodes)\n", instance->path, instance->graph.numNodes);
+        }
+    }
+    closedir(dp);
+
+    int seeds = batchSeeds > 0 ? batchSeeds : 1;
+    batch->numJobs = 0;
+    batch->jobs = malloc((size_t) batch->numInstances * NUM_SOLVERS * seeds * sizeof(struct BatchJob));
+    for (int i = 0; i < batch->numInstances; i++) {
+        for (int a = 0; a < NUM_SOLVERS; a++) {
+            for (int s = 0; s < seeds; s++) {
+                struct BatchJob *job = &batch->jobs[batch->numJobs++];
+                job->numNodes = batch->instances[i].graph.numNodes;
+                job->instance = i;
+                job->algorithm = a;
+                job->seed = batchBaseSeed + (unsigned long long) s;
+            }
+        }
+    }
+    qsort(batch->jobs, batch->numJobs, sizeof(struct BatchJob), compareBatchJobs);
+
+    int numWorkers = batchWorkers > 0 ? batchWorkers : availableCores();
+    if (numWorkers > BATCH_MAX_WORKERS) {
+        numWorkers = BATCH_MAX_WORKERS;
+    }
+    batch->numWorkers = numWorkers;
+    for (int w = 0; w < numWorkers; w++) {
+        dequeInit(&batch->deques[w], batch->numJobs / numWorkers + 1);
+    }
+    // Deal largest first; the owner pops from the bottom, so the largest go in last
+    for (int j = batch->numJobs - 1; j >= 0; j--) {
+        dequePush(&batch->deques[j % numWorkers], j);
+    }
+    atomic_init(&batch->completed, 0);
+
+#ifdef _WIN32
+    mkdir("results");
+#else
+    mkdir("results", 0755);
+#endif
+
+    pthread_t threads[BATCH_MAX_WORKERS];
+    struct BatchWorker *workers = malloc(numWorkers * sizeof(struct BatchWorker));
+    for (int w = 0; w < numWorkers; w++) {
+        batchWorkerInit(&workers[w], batch, w);
+        pthread_create(&threads[w], NULL, batchWorkerThread, &workers[w]);
+    }
+    for (int w = 0; w < numWorkers; w++) {
+        pthread_join(threads[w], NULL);
+    }
+
+    writeBatchStatistics(batch);
+
+    for (int w = 0; w < numWorkers; w++) {
+        batchWorkerFree(&workers[w]);
+        free(batch->deques[w].slots);
+    }
+    free(workers);
+    free(batch->jobs);
+    free(batch->instances);
+    free(batch);
+    return 0;
+}
+
+#endif
@@ -0,0 +1,282 @@
+// BENCHMARK.h - The header file for the benchmark against known optimal tour lengths
+// Every solver runs on every instance once per time budget. Lengths are measured the
+// TSPLIB way (every edge rounded to the nearest integer), so that they compare with the
+// published optima; instances without one get theirs from Held-Karp when small enough.
+// The time to target of a solver is the earliest point, over the runs of all budgets,
+// at which its convergence trace (TRACE.h) came within 5%, 2% or 1% of the optimum.
+// Everything is written to results/benchmark.json.
+
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#define BENCHMARK_MAX_BUDGETS 16
+#define HELD_KARP_MAX_NODES 16
+#define BENCHMARK_NUM_TARGETS 3
+
+const double benchmarkTargets[BENCHMARK_NUM_TARGETS] = {5.0, 2.0, 1.0};   // Gaps in percent
+
+struct KnownOptimum {
+    const char *name;
+    long optimum;
+};
+
+// Published optima of the TSPLIB instances in input_problems/
+const struct KnownOptimum knownOptima[] = {
+    {"a280", 2579},     {"berlin52", 7542}, {"ch130", 6110},    {"ch150", 6528},    {"eil51", 426},
+    {"eil76", 538},     {"kroA150", 26524}, {"kroB100", 22141}, {"kroB200", 29437}, {"lin105", 14379},
+    {"lin318", 42029},  {"nrw1379", 56638}, {"pr1002", 259045}, {"pr226", 80369},   {"pr264", 49135},
+    {"pr299", 48191},   {"pr439", 107217},  {"rat783", 8806},   {"rat99", 1211},
+};
+#define NUM_KNOWN_OPTIMA (int) (sizeof(knownOptima) / sizeof(knownOptima[0]))
+
+struct BenchmarkRun {
+    int algorithm;
+    double budget;
+    long length;
+    double gap;            // Percent above the optimum
+    double executionTime;
+    double targetTime[BENCHMARK_NUM_TARGETS];   // Seconds to reach each target (-1 = never)
+};
+
+// TSPLIB EUC_2D distance: the Euclidean distance rounded to the nearest integer
+long tsplibDistance(struct Node a, struct Node b) {
+    return (long) (calculateDistance(a, b) + 0.5);
+}
+
+long tsplibTourLength(struct Graph *graph, int *tour) {
+    long length = 0;
+    for (int i = 0; i < graph->numNodes; i++) {
+        length += tsplibDistance(graph->nodes[tour[i]], graph->nodes[tour[(i + 1) % graph->numNodes]]);
+    }
+    return length;
+}
+
+// Optimal tour length by Held-Karp dynamic programming over subsets, O(2^n n^2).
+// cost[S][j] is the shortest path from city 0 through the cities of S ending at j.
+long heldKarpOptimum(struct Graph *graph) {
+    int n = graph->numNodes;
+    if (n < 2) {
+        return 0;
+    }
+    int m = n - 1;   // City 0 is the fixed start, bit j - 1 stands for city j
+    long *cost = malloc(((size_t) 1 << m) * m * sizeof(long));
+    for (int set = 1; set < 1 << m; set++) {
+        for (int j = 0; j < m; j++) {
+            long *entry = &cost[(size_t) set * m + j];
+            *entry = LONG_MAX;
+            if (!(set & 1 << j)) {
+                continue;
+            }
+            int rest = set & ~(1 << j);
+            if (rest == 0) {
+                *entry = tsplibDistance(graph->nodes[0], graph->nodes[j + 1]);
+                continue;
+            }
+            for (int k = 0; k < m; k++) {
+                long prev = (rest & 1 << k) ? cost[(size_t) rest * m + k] : LONG_MAX;
+                if (prev != LONG_MAX) {
+                    long length = prev + tsplibDistance(graph->nodes[k + 1], graph->nodes[j + 1]);
+                    if (length < *entry) {
+                        *entry = length;
+                    }
+                }
+            }
+        }
+    }
+    long best = LONG_MAX;
+    int full = (1 << m) - 1;
+    for (int j = 0; j < m; j++) {
+        long length = cost[(size_t) full * m + j] + tsplibDistance(graph->nodes[j + 1], graph->nodes[0]);
+        if (length < best) {
+            best = length;
+        }
+    }
+    free(cost);
+    return best;
+}
+
+// Optimal length of the instance, or -1 if neither known nor computable. source
+// receives where it came from.
+long instanceOptimum(const char *name, struct Graph *graph, const char **source) {
+    for (int i = 0; i < NUM_KNOWN_OPTIMA; i++) {
+        if (strcmp(knownOptima[i].name, name) == 0) {
+            *source = "tsplib";
+            return knownOptima[i].optimum;
+        }
+    }
+    if (graph->numNodes <= HELD_KARP_MAX_NODES) {
+        *source = "held-karp";
+        return heldKarpOptimum(graph);
+    }
+    *source = "unknown";
+    return -1;
+}
+
+int compareBatchInstances(const void *a, const void *b) {
+    const struct BatchInstance *ia = a, *ib = b;
+    if (ia->graph.numNodes != ib->graph.numNodes) {
+        return ia->graph.numNodes - ib->graph.numNodes;
+    }
+    return strcmp(ia->path, ib->path);
+}
+
+// Runs algorithm on the instance from its start tour within budget seconds (> 0)
+void runBenchmarkJob(struct BatchWorker *worker, struct BatchInstance *instance, long optimum, int algorithm, double budget,
+                     unsigned long long seed, struct BenchmarkRun *run) {
+    struct Graph *graph = &instance->graph;
+    int tour[MAX_NODES];
+    memcpy(tour, instance->startTour, graph->numNodes * sizeof(int));
+
+    // The budget decides when the solvers stop, not their iteration limits. Single-threaded
+    // solvers, so that times compare across machines with different core counts.
+    struct SolverSettings settings;
+    solverSettingsInit(&settings);
+    settings.seed = seed;
+    settings.timeLimit = budget;
+    settings.threads = 1;
+    settings.trace = worker->trace;
+    solvers[algorithm].configure(worker->contexts[algorithm], &settings);
+
+    double start = currentTimeSeconds();
+    solvers[algorithm].solve(worker->contexts[algorithm], graph, tour);
+    run->executionTime = currentTimeSeconds() - start;
+    run->algorithm = algorithm;
+    run->budget = budget;
+    run->length = tsplibTourLength(graph, tour);
+    run->gap = optimum > 0 ? 100.0 * (run->length - optimum) / optimum : 0.0;
+
+    // The trace has unrounded lengths, a hair off the TSPLIB ones: a run that ends within
+    // a target its trace never reached reached it at the end at the latest
+    struct TraceEvent *events = malloc(TRACE_CAPACITY * sizeof(struct TraceEvent));
+    int numEvents = traceEvents(worker->trace, events);
+    for (int t = 0; t < BENCHMARK_NUM_TARGETS; t++) {
+        run->targetTime[t] = -1.0;
+        if (optimum <= 0) {
+            continue;
+        }
+        double targetLength = optimum * (1.0 + benchmarkTargets[t] / 100.0);
+        for (int e = 0; e < numEvents; e++) {
+            if (events[e].length <= targetLength) {
+                run->targetTime[t] = events[e].time;
+                break;
+            }
+        }
+        if (run->targetTime[t] < 0.0 && run->gap <= benchmarkTargets[t]) {
+            run->targetTime[t] = run->executionTime;
+        }
+    }
+    free(events);
+}
+
+// Runs the benchmark on every .tsp file of instanceFolder. Returns 1 if the folder or the
+// results file cannot be opened.
+int runBenchmark(const char *instanceFolder, const double *budgets, int numBudgets, unsigned long long seed) {
+    DIR *dp = opendir(instanceFolder);
+    if (dp == NULL) {
+        perror("Failed to open the instance folder");
+        return 1;
+    }
+    struct BatchInstance *instances = malloc(BATCH_MAX_INSTANCES * sizeof(struct BatchInstance));
+    int numInstances = 0;
+    struct dirent *entry;
+    while ((entry = readdir(dp)) && numInstances < BATCH_MAX_INSTANCES) {
+        if (strstr(entry->d_name, ".tsp")) {
+            struct BatchInstance *instance = &instances[numInstances];
+            int length = snprintf(instance->path, sizeof(instance->path), "%s%s", instanceFolder, entry->d_name);
+            if (length >= (int) sizeof(instance->path)) {
+                printf("Skipping %s%s: the path is too long\n", instanceFolder, entry->d_name);
+                continue;
+            }
+            if (!prepareBatchInstance(instance)) {
+                printf("Skipping %s: it cannot be read or has no cities\n", instance->path);
+                continue;
+            }
+            numInstances++;
+        }
+    }
+    closedir(dp);
+    qsort(instances, numInstances, sizeof(struct BatchInstance), compareBatchInstances);
+
+#ifdef _WIN32
+    mkdir("results");
+#else
+    mkdir("results", 0755);
+#endif
+    FILE *file = fopen("results/benchmark.json", "w");
+    if (file == NULL) {
+        printf("Failed to open the benchmark results file.\n");
+        free(instances);
+        return 1;
+    }
+
+    struct BatchWorker *worker = malloc(sizeof(struct BatchWorker));
+    batchWorkerInit(worker, NULL, 0);
+
+    fprintf(file, "{\n  \"seed\": %llu,\n  \"budgets\": [", seed);
+    for (int b = 0; b < numBudgets; b++) {
+        fprintf(file, "%s%g", b > 0 ? ", " : "", budgets[b]);
+    }
+    fprintf(file, "],\n  \"targets\": [%g, %g, %g],\n  \"instances\": [", benchmarkTargets[0], benchmarkTargets[1], benchmarkTargets[2]);
+
+    printf("\n%-10s %6s %8s %-7s %9s %10s %8s %9s", "Instance", "Nodes", "Optimum", "Solver", "Budget", "Length", "Gap %", "Time");
+    printf("\n");
+    struct BenchmarkRun runs[NUM_SOLVERS * BENCHMARK_MAX_BUDGETS];
+    for (int i = 0; i < numInstances; i++) {
+        struct BatchInstance *instance = &instances[i];
+        char name[MAX_FILENAME_LENGTH];
+        instanceName(instance->path, name, sizeof(name));
+        const char *source;
+        long optimum = instanceOptimum(name, &instance->graph, &source);
+
+        int numRuns = 0;
+        for (int a = 0; a < NUM_SOLVERS; a++) {
+            for (int b = 0; b < numBudgets; b++) {
+                struct BenchmarkRun *run = &runs[numRuns++];
+                runBenchmarkJob(worker, instance, optimum, a, budgets[b], seed, run);
+                printf("%-10s %6d %8ld %-7s %9.2f %10ld %8.3f %9.4f\n", name, instance->graph.numNodes, optimum, solvers[a].name,
+                       budgets[b], run->length, run->gap, run->executionTime);
+            }
+        }
+
+        fprintf(file, "%s\n    {\"name\": \"%s\", \"nodes\": %d, \"optimum\": %ld, \"optimumSource\": \"%s\",\n", i > 0 ? "," : "", name,
+                instance->graph.numNodes, optimum, source);
+        fprintf(file, "     \"runs\": [");
+        for (int r = 0; r < numRuns; r++) {
+            struct BenchmarkRun *run = &runs[r];
+            fprintf(file, "%s\n       {\"algorithm\": \"%s\", \"budget\": %g, \"length\": %ld, \"gap\": %.6f, \"time\": %.6f}",
+                    r > 0 ? "," : "", solvers[run->algorithm].name, run->budget, run->length, run->gap, run->executionTime);
+        }
+        fprintf(file, "],\n     \"timeToTarget\": [");
+        for (int a = 0; a < NUM_SOLVERS; a++) {
+            fprintf(file, "%s\n       {\"algorithm\": \"%s\"", a > 0 ? "," : "", solvers[a].name);
+            for (int t = 0; t < BENCHMARK_NUM_TARGETS; t++) {
+                // Earliest over the runs; null if none reached the target
+                double best = -1.0;
+                for (int r = 0; r < numRuns; r++) {
+                    double time = runs[r].targetTime[t];
+                    if (runs[r].algorithm == a && time >= 0.0 && (best < 0.0 || time < best)) {
+                        best = time;
+                    }
+                }
+                if (best < 0.0) {
+                    fprintf(file, ", \"gap%g\": null", benchmarkTargets[t]);
+                } else {
+                    fprintf(file, ", \"gap%g\": %.6f", benchmarkTargets[t], best);
+                }
+            }
+            fprintf(file, "}");
+        }
+        fprintf(file, "]}");
+        fflush(file);
+    }
+    fprintf(file, "\n  ]\n}\n");
+    fclose(file);
+    printf("\nSummary written to results/benchmark.json\n");
+
+    batchWorkerFree(worker);
+    free(worker);
+    free(instances);
+    return 0;
+}
+
+#endif
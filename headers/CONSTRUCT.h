@@ -0,0 +1,482 @@
+// CONSTRUCT.h - The header file for tour construction heuristics
+// contains randomized nearest neighbor, greedy edge matching, space-filling curve, MST
+// doubling, Christofides and polished random tours. Every builder draws from its own
+// Rng, so several tours can be built in parallel and each one can be rebuilt from its
+// seed.
+// constructTour builds the start tour that main.c hands to the solvers.
+
+#ifndef CONSTRUCT_H
+#define CONSTRUCT_H
+
+#define HILBERT_ORDER 16 // The curve visits a 2^16 x 2^16 grid
+
+// Start tour methods
+#define START_INPUT_ORDER 0         // Cities in the order of the input file
+#define START_NEAREST_NEIGHBOR 1    // Nearest neighbor on the spatial grid
+#define START_GREEDY_EDGE 2         // Greedy edge matching on the candidate graph
+#define START_SPACE_FILLING_CURVE 3 // Hilbert curve order
+#define START_MST_DOUBLING 4        // Preorder walk of the MST (doubled tree, shortcut)
+#define START_CHRISTOFIDES 5        // MST plus a matching of its odd vertices, Euler tour shortcut
+
+int startMethod = START_GREEDY_EDGE;
+bool renumberCities = true;   // Store the cities in Hilbert curve order before solving
+
+// Position of cell (x, y) along the Hilbert curve of a 2^order x 2^order grid
+unsigned long long hilbertIndex(unsigned int x, unsigned int y, int order) {
+    unsigned long long d = 0;
+    for (unsigned int s = 1u << (order - 1); s > 0; s >>= 1) {
+        unsigned int rx = (x & s) > 0;
+        unsigned int ry = (y & s) > 0;
+        d += (unsigned long long) s * s * ((3 * rx) ^ ry);
+        // Rotate the quadrant so the sub-curve has the canonical orientation
+        if (ry == 0) {
+            if (rx == 1) {
+                x = s - 1 - (x & (s - 1));
+                y = s - 1 - (y & (s - 1));
+            }
+            unsigned int temp = x;
+            x = y;
+            y = temp;
+        }
+        x &= s - 1;
+        y &= s - 1;
+    }
+    return d;
+}
+
+struct CurveKey {
+    unsigned long long key;
+    int city;
+};
+
+int compareCurveKeys(const void *a, const void *b) {
+    unsigned long long ka = ((const struct CurveKey *) a)->key;
+    unsigned long long kb = ((const struct CurveKey *) b)->key;
+    return (ka > kb) - (ka < kb);
+}
+
+// Orders the cities along a Hilbert curve laid over their bounding box. With jitter > 0
+// every city is shifted by up to jitter times the average spacing in each direction
+// first, so repeated calls give different, still local, orders; the box grows by that
+// much on every side to hold the shifted cities.
+void spaceFillingCurveTour(struct Graph *graph, double jitter, struct Rng *rng, int *tour) {
+    int n = graph->numNodes;
+    double minX = DBL_MAX, minY = DBL_MAX, maxX = -DBL_MAX, maxY = -DBL_MAX;
+    for (int i = 0; i < n; i++) {
+        minX = fmin(minX, graph->nodes[i].x);
+        minY = fmin(minY, graph->nodes[i].y);
+        maxX = fmax(maxX, graph->nodes[i].x);
+        maxY = fmax(maxY, graph->nodes[i].y);
+    }
+    double side = fmax(fmax(maxX - minX, maxY - minY), 1e-9);
+    double spacing = side / sqrt((double) n);
+    double margin = jitter * spacing;
+    double scale = ((double) (1u << HILBERT_ORDER) - 1.0) / (side + 2.0 * margin);
+
+    struct CurveKey keys[MAX_NODES];
+    for (int i = 0; i < n; i++) {
+        double x = graph->nodes[i].x - minX + margin;
+        double y = graph->nodes[i].y - minY + margin;
+        if (jitter > 0.0) {
+            x += (rngDouble(rng) * 2.0 - 1.0) * margin;
+            y += (rngDouble(rng) * 2.0 - 1.0) * margin;
+        }
+        keys[i].key = hilbertIndex((unsigned int) (x * scale), (unsigned int) (y * scale), HILBERT_ORDER);
+        keys[i].city = i;
+    }
+    qsort(keys, n, sizeof(struct CurveKey), compareCurveKeys);
+
+    // Start the cycle at a random point of the curve
+    int offset = rng != NULL ? rngInt(rng, n) : 0;
+    for (int i = 0; i < n; i++) {
+        tour[i] = keys[(i + offset) % n].city;
+    }
+}
+
+// Map between the city indices the solvers see and the order of the input file
+struct CityOrder {
+    int original[MAX_NODES];   // Input index of every internal city
+    int internal[MAX_NODES];   // Internal index of every input city
+};
+
+// Renumbers the cities of graph along the Hilbert curve when renumberCities is set (the
+// order is the identity otherwise), so cities that are close in the plane, and in a
+// good tour, are also close in memory. Node ids move with their cities.
+void renumberGraph(struct Graph *graph, struct CityOrder *order) {
+    int n = graph->numNodes;
+    if (renumberCities && n > 2) {
+        spaceFillingCurveTour(graph, 0.0, NULL, order->original);
+    } else {
+        for (int i = 0; i < n; i++) {
+            order->original[i] = i;
+        }
+    }
+
+    struct Node *nodes = malloc(n * sizeof(struct Node));
+    memcpy(nodes, graph->nodes, n * sizeof(struct Node));
+    for (int i = 0; i < n; i++) {
+        graph->nodes[i] = nodes[order->original[i]];
+        order->internal[order->original[i]] = i;
+    }
+    free(nodes);
+}
+
+// Translates a tour between internal and input indices (map is order->original to go
+// back to the input, order->internal to go from it)
+void mapTour(const int *map, int numNodes, const int *tour, int *result) {
+    for (int i = 0; i < numNodes; i++) {
+        result[i] = map[tour[i]];
+    }
+}
+
+// True if tour holds every city 0 .. numNodes - 1 exactly once
+bool isTourPermutation(const int *tour, int numNodes) {
+    bool *seen = calloc(numNodes > 0 ? numNodes : 1, sizeof(bool));
+    bool valid = true;
+    for (int i = 0; i < numNodes && valid; i++) {
+        valid = tour[i] >= 0 && tour[i] < numNodes && !seen[tour[i]];
+        if (valid) {
+            seen[tour[i]] = true;
+        }
+    }
+    free(seen);
+    return valid;
+}
+
+// Nearest neighbor tour from a random start. With probability 'greed' the nearest
+// unvisited city is taken, otherwise the second or third nearest. The grid is consumed
+// (visited cities are removed from it), so pass a private copy.
+void randomizedNearestNeighborTour(struct Graph *graph, struct SpatialGrid *grid, double greed, struct Rng *rng, int *tour) {
+    int n = graph->numNodes;
+    int curr = rngInt(rng, n);
+    tour[0] = curr;
+    gridRemove(grid, curr);
+
+    for (int i = 1; i < n; i++) {
+        int nearest[3];
+        double dist[3];
+        int found = gridNearest(grid, graph, graph->nodes[curr].x, graph->nodes[curr].y, -1, 3, nearest, dist);
+        int pick = 0;
+        if (found > 1 && rngDouble(rng) >= greed) {
+            pick = 1 + rngInt(rng, found - 1);
+        }
+        curr = nearest[pick];
+        tour[i] = curr;
+        gridRemove(grid, curr);
+    }
+}
+
+struct CandidateEdge {
+    double length;
+    int a;
+    int b;
+};
+
+int compareCandidateEdges(const void *a, const void *b) {
+    double la = ((const struct CandidateEdge *) a)->length;
+    double lb = ((const struct CandidateEdge *) b)->length;
+    return (la > lb) - (la < lb);
+}
+
+// Greedy edge matching: take candidate edges shortest first (lengths scaled by a random
+// factor in [1, 1 + noise) for diversity) as long as no city gets a third edge and no
+// cycle closes, then join the remaining path fragments end to end, nearest end first.
+void greedyEdgeTour(struct Graph *graph, struct CandidateList *candidates, double noise, struct Rng *rng, int *tour) {
+    int n = graph->numNodes;
+    int numEdges = 0;
+    struct CandidateEdge *edges = malloc(n * candidates->count * sizeof(struct CandidateEdge));
+    for (int a = 0; a < n; a++) {
+        for (int m = 0; m < candidates->count; m++) {
+            int b = candidates->neighbors[a][m];
+            // Each edge once: from its lower end, or from the end that has the other as a candidate
+            bool mutual = false;
+            for (int r = 0; r < candidates->count; r++) {
+                mutual = mutual || candidates->neighbors[b][r] == a;
+            }
+            if (a < b || !mutual) {
+                double factor = noise > 0.0 ? 1.0 + noise * rngDouble(rng) : 1.0;
+                edges[numEdges].length = calculateDistance(graph->nodes[a], graph->nodes[b]) * factor;
+                edges[numEdges].a = a;
+                edges[numEdges].b = b;
+                numEdges++;
+            }
+        }
+    }
+    qsort(edges, numEdges, sizeof(struct CandidateEdge), compareCandidateEdges);
+
+    // Fragments are paths, so two free cities are in the same fragment exactly when
+    // they are its two ends
+    int adj[MAX_NODES][2];
+    int degree[MAX_NODES];
+    int otherEnd[MAX_NODES];
+    for (int v = 0; v < n; v++) {
+        degree[v] = 0;
+        otherEnd[v] = v;
+    }
+
+    int taken = 0;
+    for (int e = 0; e < numEdges && taken < n - 1; e++) {
+        int a = edges[e].a, b = edges[e].b;
+        if (degree[a] < 2 && degree[b] < 2 && otherEnd[a] != b) {
+            int endA = otherEnd[a], endB = otherEnd[b];
+            adj[a][degree[a]++] = b;
+            adj[b][degree[b]++] = a;
+            otherEnd[endA] = endB;
+            otherEnd[endB] = endA;
+            taken++;
+        }
+    }
+    free(edges);
+
+    // Join the fragments into one path: from its free end, go to the nearest free end
+    // of another fragment
+    int ends[MAX_NODES];
+    int numEnds = 0;
+    for (int v = 0; v < n; v++) {
+        if (degree[v] < 2) {
+            ends[numEnds++] = v;
+        }
+    }
+    int start = ends[0];
+    while (taken < n - 1) {
+        int end = otherEnd[start];
+        int best = -1;
+        double bestDist = DBL_MAX;
+        for (int e = 0; e < numEnds; e++) {
+            int v = ends[e];
+            if (degree[v] < 2 && v != start && v != end) {
+                double d = calculateDistance(graph->nodes[end], graph->nodes[v]);
+                if (d < bestDist) {
+                    bestDist = d;
+                    best = v;
+                }
+            }
+        }
+        int farEnd = otherEnd[best];
+        adj[end][degree[end]++] = best;
+        adj[best][degree[best]++] = end;
+        otherEnd[start] = farEnd;
+        otherEnd[farEnd] = start;
+        taken++;
+    }
+
+    // Walk the Hamiltonian path from one end
+    int prev = -1, curr = start;
+    for (int i = 0; i < n; i++) {
+        tour[i] = curr;
+        int next = -1;
+        for (int s = 0; s < degree[curr]; s++) {
+            if (adj[curr][s] != prev) {
+                next = adj[curr][s];
+                break;
+            }
+        }
+        prev = curr;
+        curr = next;
+    }
+}
+
+// Uniformly random permutation of the cities
+void randomTour(int numNodes, struct Rng *rng, int *tour) {
+    for (int i = 0; i < numNodes; i++) {
+        tour[i] = i;
+    }
+    for (int i = numNodes - 1; i > 0; i--) {
+        int j = rngInt(rng, i + 1);
+        int temp = tour[i];
+        tour[i] = tour[j];
+        tour[j] = temp;
+    }
+}
+
+// Walks the MST depth first from city 0 and lists every city when it is first reached:
+// the Euler tour of the doubled tree with repeated cities shortcut, at most twice the
+// MST weight. parent is the tree as filled in by calculateMSTTree.
+void mstDoublingTour(struct Graph *graph, int *parent, int *tour) {
+    int n = graph->numNodes;
+    int childStart[MAX_NODES + 1], children[MAX_NODES];
+    for (int v = 0; v <= n; v++) {
+        childStart[v] = 0;
+    }
+    for (int v = 0; v < n; v++) {
+        if (parent[v] >= 0) {
+            childStart[parent[v] + 1]++;
+        }
+    }
+    for (int v = 0; v < n; v++) {
+        childStart[v + 1] += childStart[v];
+    }
+    int fill[MAX_NODES];
+    for (int v = 0; v < n; v++) {
+        fill[v] = childStart[v];
+    }
+    for (int v = 0; v < n; v++) {
+        if (parent[v] >= 0) {
+            children[fill[parent[v]]++] = v;
+        }
+    }
+
+    int stack[MAX_NODES];
+    int top = 0, size = 0;
+    stack[top++] = 0;
+    while (top > 0) {
+        int v = stack[--top];
+        tour[size++] = v;
+        for (int c = childStart[v + 1] - 1; c >= childStart[v]; c--) {
+            stack[top++] = children[c];
+        }
+    }
+}
+
+// Christofides: adds a minimum-weight perfect matching of the odd-degree MST vertices
+// to the tree, walks an Euler tour of the resulting multigraph and skips cities already
+// visited. The 1.5 bound holds for an exact matching on the complete graph; the matching
+// here is restricted to candidate edges (see MATCHING.h). parent is the tree as filled
+// in by calculateMSTTree.
+void christofidesTour(struct Graph *graph, int *parent, int *tour) {
+    int n = graph->numNodes;
+    if (n < 3) {
+        for (int i = 0; i < n; i++) {
+            tour[i] = i;
+        }
+        return;
+    }
+
+    int degree[MAX_NODES];
+    for (int v = 0; v < n; v++) {
+        degree[v] = 0;
+    }
+    for (int v = 0; v < n; v++) {
+        if (parent[v] >= 0) {
+            degree[v]++;
+            degree[parent[v]]++;
+        }
+    }
+    int odd[MAX_NODES], mate[MAX_NODES];
+    int numOdd = 0;
+    for (int v = 0; v < n; v++) {
+        if (degree[v] % 2 == 1) {
+            odd[numOdd++] = v;
+        }
+    }
+    minimumWeightMatching(graph, odd, numOdd, matchingMethod, mate);
+
+    // Multigraph of tree and matching edges, adjacency stored per city
+    int endA[2 * MAX_NODES], endB[2 * MAX_NODES];
+    int numEdges = 0;
+    for (int v = 0; v < n; v++) {
+        if (parent[v] >= 0) {
+            endA[numEdges] = v;
+            endB[numEdges++] = parent[v];
+        }
+    }
+    for (int i = 0; i < numOdd; i++) {
+        if (i < mate[i]) {
+            endA[numEdges] = odd[i];
+            endB[numEdges++] = odd[mate[i]];
+        }
+    }
+    int adjStart[MAX_NODES + 1], adjEdge[4 * MAX_NODES], fill[MAX_NODES];
+    for (int v = 0; v <= n; v++) {
+        adjStart[v] = 0;
+    }
+    for (int e = 0; e < numEdges; e++) {
+        adjStart[endA[e] + 1]++;
+        adjStart[endB[e] + 1]++;
+    }
+    for (int v = 0; v < n; v++) {
+        adjStart[v + 1] += adjStart[v];
+        fill[v] = adjStart[v];
+    }
+    for (int e = 0; e < numEdges; e++) {
+        adjEdge[fill[endA[e]]++] = e;
+        adjEdge[fill[endB[e]]++] = e;
+    }
+
+    // Hierholzer's algorithm; cities leave the stack in Euler tour order and are
+    // listed on their first appearance
+    bool used[2 * MAX_NODES];
+    bool visited[MAX_NODES];
+    int next[MAX_NODES], stack[2 * MAX_NODES + 1];
+    for (int e = 0; e < numEdges; e++) {
+        used[e] = false;
+    }
+    for (int v = 0; v < n; v++) {
+        visited[v] = false;
+        next[v] = adjStart[v];
+    }
+    int top = 0, size = 0;
+    stack[top++] = 0;
+    while (top > 0) {
+        int v = stack[top - 1];
+        while (next[v] < adjStart[v + 1] && used[adjEdge[next[v]]]) {
+            next[v]++;
+        }
+        if (next[v] < adjStart[v + 1]) {
+            int e = adjEdge[next[v]++];
+            used[e] = true;
+            stack[top++] = endA[e] == v ? endB[e] : endA[e];
+        } else {
+            top--;
+            if (!visited[v]) {
+                visited[v] = true;
+                tour[size++] = v;
+            }
+        }
+    }
+}
+
+// Builds the start tour with the given method. mstParent may be NULL, the MST is then
+// computed here when needed. order, when not NULL, gives the input order of renumbered
+// cities for START_INPUT_ORDER.
+void constructTour(struct Graph *graph, int method, int *mstParent, struct CityOrder *order, int *tour) {
+    int n = graph->numNodes;
+    struct Rng rng;
+    rngSeed(&rng, 1);
+
+    if (method == START_NEAREST_NEIGHBOR || method == START_GREEDY_EDGE) {
+        struct SpatialGrid *grid = malloc(sizeof(struct SpatialGrid));
+        buildSpatialGrid(graph, grid);
+        if (method == START_NEAREST_NEIGHBOR) {
+            randomizedNearestNeighborTour(graph, grid, 1.0, &rng, tour);
+        } else {
+            struct CandidateList *candidates = malloc(sizeof(struct CandidateList));
+            buildCandidateList(graph, grid, candidates, 8);
+            greedyEdgeTour(graph, candidates, 0.0, &rng, tour);
+            free(candidates);
+        }
+        free(grid);
+    } else if (method == START_SPACE_FILLING_CURVE) {
+        spaceFillingCurveTour(graph, 0.0, NULL, tour);
+    } else if (method == START_MST_DOUBLING || method == START_CHRISTOFIDES) {
+        int parent[MAX_NODES];
+        if (mstParent == NULL) {
+            calculateMSTTree(graph, parent);
+            mstParent = parent;
+        }
+        if (method == START_MST_DOUBLING) {
+            mstDoublingTour(graph, mstParent, tour);
+        } else {
+            christofidesTour(graph, mstParent, tour);
+        }
+    } else {
+        for (int i = 0; i < n; i++) {
+            tour[i] = order != NULL ? order->internal[i] : i;
+        }
+    }
+}
+
+// Runs the candidate-list 2-opt / Or-opt descent from every city, until control (may be
+// NULL) stops the run
+void polishTour(struct Graph *graph, struct CandidateList *candidates, int *tour, struct RunControl *control) {
+    int n = graph->numNodes;
+    int pos[MAX_NODES];
+    int all[MAX_NODES];
+    for (int i = 0; i < n; i++) {
+        pos[tour[i]] = i;
+        all[i] = tour[i];
+    }
+    neighborLocalSearch(graph, tour, pos, candidates, all, n, true, NULL, control);
+}
+
+#endif
@@ -0,0 +1,568 @@
+// DAEMON.h - The header file for the solve daemon
+// A long-running process that serves solve requests over a Unix domain socket. Every
+// connection carries one request per line and gets one response line per request:
+//
+//   SOLVE <algorithm> <budget> <seed> FILE <path>
+//   SOLVE <algorithm> <budget> <seed> COORDS <n> <x1> <y1> ... <xn> <yn>
+//       -> OK <length> <status> <seconds> <hit|miss> <n> <id> ... <id>
+//   STATS
+//       -> OK <cached instances> <hits> <misses> <evictions> <solves>
+//
+// and ERROR <reason> for anything that cannot be served. The budget is in seconds (0 =
+// the solver's own stopping rule), the tour is given by city ids (1 .. n for inline
+// coordinates), and the status tells why the run stopped (RUNCONTROL.h).
+// Instances are preprocessed like batch instances (renumbering, MST, start tour) and
+// kept in an LRU cache keyed by a hash of their content, so a file and the same cities
+// sent inline share one entry. One thread accepts connections and reads their requests,
+// and hands each request, not the connection, to a pool of worker threads, each owning
+// one context per solver (SOLVERS.h), reused from request to request. An idle or slow
+// client therefore holds no worker; a connection has one request served at a time, so
+// its responses come in order.
+
+#ifndef DAEMON_H
+#define DAEMON_H
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#define DAEMON_MAX_CACHE 256
+#define DAEMON_MAX_CONNECTIONS 256
+#define DAEMON_QUEUE_SIZE 64           // Requests waiting for a worker
+#define DAEMON_MAX_REQUEST (1 << 20)   // Longest request line, in bytes
+#define DAEMON_IDLE_TIMEOUT 600.0      // Seconds a connection may stay open without a request
+#define DAEMON_SEND_TIMEOUT 10         // Seconds a response waits for a client that does not read
+
+int daemonWorkers = 0;        // Worker threads (0 = one per online core)
+int daemonCacheSize = 16;     // Preprocessed instances kept, at most DAEMON_MAX_CACHE
+int daemonSolverThreads = 1;  // Threads of each solve (0 = one per online core)
+
+struct CacheEntry {
+    unsigned long long hash;
+    int refs;                      // Requests using the entry; only unused entries are evicted
+    unsigned long long lastUse;
+    bool cached;                   // False for an instance served without a free cache slot
+    struct BatchInstance instance;
+};
+
+struct DaemonCache {
+    pthread_mutex_t lock;
+    struct CacheEntry *entries[DAEMON_MAX_CACHE];
+    int numEntries;
+    unsigned long long clock;
+    long long hits;
+    long long misses;
+    long long evictions;
+    long long solves;
+};
+
+// A client connection, owned by the accepting thread except while one of its requests is
+// with a worker (busy)
+struct DaemonConnection {
+    int fd;
+    bool busy;
+    bool hungUp;         // The client has sent its last request
+    double lastActive;
+    char *buffer;        // Bytes read past the last request handed out
+    size_t length;
+    size_t capacity;
+};
+
+struct DaemonRequest {
+    struct DaemonConnection *connection;
+    char *line;
+};
+
+struct Daemon {
+    struct DaemonCache cache;
+    pthread_mutex_t queueLock;
+    pthread_cond_t queueReady;
+    struct DaemonRequest queue[DAEMON_QUEUE_SIZE];
+    int queueHead;
+    int queueCount;
+    struct DaemonConnection *served[DAEMON_MAX_CONNECTIONS];   // Given back by the workers
+    int numServed;
+    int wakeFds[2];      // Pipe on which the workers wake the accepting thread
+};
+
+struct DaemonWorker {
+    struct Daemon *daemon;
+    void *contexts[NUM_SOLVERS];
+};
+
+volatile sig_atomic_t daemonStopping = 0;
+
+void daemonSignal(int signal) {
+    (void) signal;
+    daemonStopping = 1;
+}
+
+// Content hash of a graph: ids and coordinates of the cities, in order (FNV-1a)
+unsigned long long graphHash(struct Graph *graph) {
+    unsigned long long hash = 0xCBF29CE484222325ULL;
+    for (int i = 0; i < graph->numNodes; i++) {
+        unsigned long long words[3];
+        words[0] = (unsigned long long) graph->nodes[i].id;
+        memcpy(&words[1], &graph->nodes[i].x, sizeof(double));
+        memcpy(&words[2], &graph->nodes[i].y, sizeof(double));
+        for (int w = 0; w < 3; w++) {
+            hash = (hash ^ words[w]) * 0x100000001B3ULL;
+        }
+    }
+    return hash;
+}
+
+bool sameGraph(struct Graph *a, struct Graph *b) {
+    if (a->numNodes != b->numNodes) {
+        return false;
+    }
+    for (int i = 0; i < a->numNodes; i++) {
+        if (a->nodes[i].id != b->nodes[i].id || a->nodes[i].x != b->nodes[i].x || a->nodes[i].y != b->nodes[i].y) {
+            return false;
+        }
+    }
+    return true;
+}
+
+struct CacheEntry *cacheFind(struct DaemonCache *cache, unsigned long long hash, struct Graph *graph) {
+    for (int e = 0; e < cache->numEntries; e++) {
+        if (cache->entries[e]->hash == hash && sameGraph(&cache->entries[e]->instance.inputGraph, graph)) {
+            return cache->entries[e];
+        }
+    }
+    return NULL;
+}
+
+// Takes the entry of the instance read into request, or makes request the entry.
+// Preprocessing runs outside the lock, so a miss does not hold up the other workers.
+struct CacheEntry *cacheAcquire(struct DaemonCache *cache, struct CacheEntry *request, bool *hit) {
+    request->hash = graphHash(&request->instance.inputGraph);
+    pthread_mutex_lock(&cache->lock);
+    struct CacheEntry *entry = cacheFind(cache, request->hash, &request->instance.inputGraph);
+    if (entry != NULL) {
+        entry->refs++;
+        entry->lastUse = ++cache->clock;
+        cache->hits++;
+        pthread_mutex_unlock(&cache->lock);
+        free(request);
+        *hit = true;
+        return entry;
+    }
+    cache->misses++;
+    pthread_mutex_unlock(&cache->lock);
+    *hit = false;
+
+    preprocessBatchInstance(&request->instance);
+
+    pthread_mutex_lock(&cache->lock);
+    // Another worker may have preprocessed the same instance meanwhile
+    entry = cacheFind(cache, request->hash, &request->instance.inputGraph);
+    if (entry != NULL) {
+        entry->refs++;
+        entry->lastUse = ++cache->clock;
+        pthread_mutex_unlock(&cache->lock);
+        free(request);
+        return entry;
+    }
+    if (cache->numEntries >= daemonCacheSize) {
+        int victim = -1;
+        for (int e = 0; e < cache->numEntries; e++) {
+            if (cache->entries[e]->refs == 0 && (victim < 0 || cache->entries[e]->lastUse < cache->entries[victim]->lastUse)) {
+                victim = e;
+            }
+        }
+        if (victim >= 0) {
+            free(cache->entries[victim]);
+            cache->entries[victim] = cache->entries[--cache->numEntries];
+            cache->evictions++;
+        }
+    }
+    request->refs = 1;
+    request->lastUse = ++cache->clock;
+    request->cached = cache->numEntries < daemonCacheSize;
+    if (request->cached) {
+        cache->entries[cache->numEntries++] = request;
+    }
+    pthread_mutex_unlock(&cache->lock);
+    return request;
+}
+
+void cacheRelease(struct DaemonCache *cache, struct CacheEntry *entry) {
+    pthread_mutex_lock(&cache->lock);
+    entry->refs--;
+    bool orphan = !entry->cached;
+    cache->solves++;
+    pthread_mutex_unlock(&cache->lock);
+    if (orphan) {
+        free(entry);
+    }
+}
+
+// Reads the instance of a request, the part after the seed, into graph. Returns NULL or
+// the reason the request cannot be served.
+const char *parseRequestInstance(char *cursor, struct Graph *graph) {
+    char kind[16];
+    int consumed;
+    if (sscanf(cursor, "%15s %n", kind, &consumed) != 1) {
+        return "missing instance";
+    }
+    cursor += consumed;
+    if (strcmp(kind, "FILE") == 0) {
+        cursor[strcspn(cursor, "\r\n")] = '\0';
+        if (!loadInput(graph, cursor)) {
+            return "cannot read the instance file";
+        }
+    } else if (strcmp(kind, "COORDS") == 0) {
+        char *end;
+        long n = strtol(cursor, &end, 10);
+        if (end == cursor || n < 1 || n > MAX_NODES) {
+            return "invalid number of cities";
+        }
+        cursor = end;
+        for (int i = 0; i < n; i++) {
+            graph->nodes[i].id = i + 1;
+            graph->nodes[i].x = strtod(cursor, &end);
+            if (end == cursor) {
+                return "missing coordinates";
+            }
+            cursor = end;
+            graph->nodes[i].y = strtod(cursor, &end);
+            if (end == cursor) {
+                return "missing coordinates";
+            }
+            cursor = end;
+        }
+        graph->numNodes = (int) n;
+    } else {
+        return "unknown instance kind";
+    }
+    if (graph->numNodes < 1) {
+        return "no cities";
+    }
+    return NULL;
+}
+
+void serveSolve(struct DaemonWorker *worker, char *line, FILE *out) {
+    char algorithm[16];
+    double budget;
+    unsigned long long seed;
+    int consumed;
+    if (sscanf(line, "SOLVE %15s %lf %llu %n", algorithm, &budget, &seed, &consumed) != 3 || budget < 0.0) {
+        fprintf(out, "ERROR malformed SOLVE request\n");
+        return;
+    }
+    int solver = findSolver(algorithm);
+    if (solver < 0) {
+        fprintf(out, "ERROR unknown algorithm %s\n", algorithm);
+        return;
+    }
+
+    struct CacheEntry *request = malloc(sizeof(struct CacheEntry));
+    snprintf(request->instance.path, sizeof(request->instance.path), "daemon");
+    const char *error = parseRequestInstance(line + consumed, &request->instance.inputGraph);
+    if (error != NULL) {
+        fprintf(out, "ERROR %s\n", error);
+        free(request);
+        return;
+    }
+    bool hit;
+    struct CacheEntry *entry = cacheAcquire(&worker->daemon->cache, request, &hit);
+    struct BatchInstance *instance = &entry->instance;
+    struct Graph *graph = &instance->graph;
+    int n = graph->numNodes;
+    int tour[MAX_NODES], outputTour[MAX_NODES];
+    memcpy(tour, instance->startTour, n * sizeof(int));
+
+    struct RunControl control;
+    runControlInit(&control);
+    control.deadline = budget > 0.0 ? currentTimeSeconds() + budget : 0.0;
+    struct SolverSettings settings;
+    solverSettingsInit(&settings);
+    settings.seed = seed;
+    settings.timeLimit = budget;
+    settings.threads = daemonSolverThreads;
+    settings.control = &control;
+    solvers[solver].configure(worker->contexts[solver], &settings);
+    solvers[solver].solve(worker->contexts[solver], graph, tour);
+
+    mapTour(instance->order.original, n, tour, outputTour);
+    fprintf(out, "OK %lf %s %lf %s %d", calculateTourLength(graph, tour), runStatusNames[atomic_load(&control.status)],
+            control.elapsed, hit ? "hit" : "miss", n);
+    for (int i = 0; i < n; i++) {
+        fprintf(out, " %d", instance->inputGraph.nodes[outputTour[i]].id);
+    }
+    fprintf(out, "\n");
+    cacheRelease(&worker->daemon->cache, entry);
+}
+
+void serveStats(struct DaemonCache *cache, FILE *out) {
+    pthread_mutex_lock(&cache->lock);
+    fprintf(out, "OK %d %lld %lld %lld %lld\n", cache->numEntries, cache->hits, cache->misses, cache->evictions, cache->solves);
+    pthread_mutex_unlock(&cache->lock);
+}
+
+// Serves one request line, writing the response to fd
+void serveRequest(struct DaemonWorker *worker, int fd, char *line) {
+    FILE *out = fdopen(dup(fd), "w");
+    if (out == NULL) {
+        return;
+    }
+    if (strncmp(line, "SOLVE ", 6) == 0) {
+        serveSolve(worker, line, out);
+    } else if (strncmp(line, "STATS", 5) == 0) {
+        serveStats(&worker->daemon->cache, out);
+    } else {
+        fprintf(out, "ERROR unknown request\n");
+    }
+    fclose(out);
+}
+
+void *daemonWorkerThread(void *arg) {
+    struct DaemonWorker *worker = arg;
+    struct Daemon *daemon = worker->daemon;
+    for (;;) {
+        pthread_mutex_lock(&daemon->queueLock);
+        while (daemon->queueCount == 0) {
+            pthread_cond_wait(&daemon->queueReady, &daemon->queueLock);
+        }
+        struct DaemonRequest request = daemon->queue[daemon->queueHead];
+        daemon->queueHead = (daemon->queueHead + 1) % DAEMON_QUEUE_SIZE;
+        daemon->queueCount--;
+        pthread_mutex_unlock(&daemon->queueLock);
+
+        serveRequest(worker, request.connection->fd, request.line);
+        free(request.line);
+
+        // Give the connection back, so its next request can be read
+        pthread_mutex_lock(&daemon->queueLock);
+        daemon->served[daemon->numServed++] = request.connection;
+        pthread_mutex_unlock(&daemon->queueLock);
+        char wake = 0;
+        if (write(daemon->wakeFds[1], &wake, 1) < 0) {
+            // The pipe is full, so the accepting thread is woken already
+        }
+    }
+    return NULL;
+}
+
+// Hands the next complete request of an idle connection to the workers. Requests that
+// find the queue full are answered at once.
+void connectionDispatch(struct Daemon *daemon, struct DaemonConnection *connection) {
+    while (!connection->busy) {
+        char *end = memchr(connection->buffer, '\n', connection->length);
+        if (end == NULL) {
+            return;
+        }
+        size_t lineLength = end - connection->buffer + 1;
+        char *line = malloc(lineLength + 1);
+        memcpy(line, connection->buffer, lineLength);
+        line[lineLength] = '\0';
+        connection->length -= lineLength;
+        memmove(connection->buffer, end + 1, connection->length);
+
+        pthread_mutex_lock(&daemon->queueLock);
+        if (daemon->queueCount == DAEMON_QUEUE_SIZE) {
+            pthread_mutex_unlock(&daemon->queueLock);
+            dprintf(connection->fd, "ERROR busy\n");
+            free(line);
+            continue;
+        }
+        struct DaemonRequest *request = &daemon->queue[(daemon->queueHead + daemon->queueCount) % DAEMON_QUEUE_SIZE];
+        request->connection = connection;
+        request->line = line;
+        daemon->queueCount++;
+        connection->busy = true;
+        pthread_cond_signal(&daemon->queueReady);
+        pthread_mutex_unlock(&daemon->queueLock);
+    }
+}
+
+// Reads what a readable connection has sent. Returns false if the connection is to be
+// closed: the read failed, or the request is longer than DAEMON_MAX_REQUEST.
+bool connectionRead(struct DaemonConnection *connection) {
+    if (connection->capacity - connection->length < 4096) {
+        if (connection->capacity >= DAEMON_MAX_REQUEST) {
+            dprintf(connection->fd, "ERROR request too long\n");
+            return false;
+        }
+        connection->capacity *= 2;
+        connection->buffer = realloc(connection->buffer, connection->capacity);
+    }
+    ssize_t count = read(connection->fd, connection->buffer + connection->length,
+                         connection->capacity - connection->length - 1);
+    if (count < 0) {
+        return errno == EINTR || errno == EAGAIN;
+    }
+    if (count == 0) {
+        // A last request without a line end is still served
+        if (connection->length > 0 && connection->buffer[connection->length - 1] != '\n') {
+            connection->buffer[connection->length++] = '\n';
+        }
+        connection->hungUp = true;
+    }
+    connection->length += count;
+    connection->lastActive = currentTimeSeconds();
+    return true;
+}
+
+// Serves requests on socketPath until SIGINT or SIGTERM. Returns 1 if the socket cannot
+// be set up. Connections still being served when it returns end with the process.
+int runDaemon(const char *socketPath) {
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (strlen(socketPath) >= sizeof(address.sun_path)) {
+        printf("Socket path too long: %s\n", socketPath);
+        return 1;
+    }
+    strcpy(address.sun_path, socketPath);
+
+    int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener < 0) {
+        perror("Failed to create the socket");
+        return 1;
+    }
+    unlink(socketPath);
+    if (bind(listener, (struct sockaddr *) &address, sizeof(address)) < 0 || listen(listener, DAEMON_QUEUE_SIZE) < 0) {
+        perror("Failed to listen on the socket");
+        close(listener);
+        return 1;
+    }
+
+    // A client that hangs up early must not take the daemon down; SIGINT and SIGTERM
+    // interrupt poll (no SA_RESTART) so the daemon can clean up
+    signal(SIGPIPE, SIG_IGN);
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = daemonSignal;
+    sigaction(SIGINT, &action, NULL);
+    sigaction(SIGTERM, &action, NULL);
+
+    if (daemonCacheSize < 1 || daemonCacheSize > DAEMON_MAX_CACHE) {
+        daemonCacheSize = DAEMON_MAX_CACHE;
+    }
+    struct Daemon *daemon = calloc(1, sizeof(struct Daemon));
+    pthread_mutex_init(&daemon->cache.lock, NULL);
+    pthread_mutex_init(&daemon->queueLock, NULL);
+    pthread_cond_init(&daemon->queueReady, NULL);
+    if (pipe(daemon->wakeFds) < 0) {
+        perror("Failed to create the wake-up pipe");
+        close(listener);
+        return 1;
+    }
+    fcntl(daemon->wakeFds[0], F_SETFL, O_NONBLOCK);
+    fcntl(daemon->wakeFds[1], F_SETFL, O_NONBLOCK);
+
+    int numWorkers = daemonWorkers > 0 ? daemonWorkers : availableCores();
+    struct DaemonWorker *workers = malloc(numWorkers * sizeof(struct DaemonWorker));
+    for (int w = 0; w < numWorkers; w++) {
+        workers[w].daemon = daemon;
+        for (int s = 0; s < NUM_SOLVERS; s++) {
+            workers[w].contexts[s] = solvers[s].create();
+        }
+        pthread_t thread;
+        pthread_create(&thread, NULL, daemonWorkerThread, &workers[w]);
+        pthread_detach(thread);
+    }
+    printf("Serving on %s with %d workers and %d cached instances\n", socketPath, numWorkers, daemonCacheSize);
+    fflush(stdout);
+
+    // The accepting thread polls the listener, the wake-up pipe and every connection that
+    // has no request with a worker
+    struct DaemonConnection *connections[DAEMON_MAX_CONNECTIONS];
+    int numConnections = 0;
+    struct pollfd fds[DAEMON_MAX_CONNECTIONS + 2];
+    while (!daemonStopping) {
+        fds[0].fd = listener;
+        fds[1].fd = daemon->wakeFds[0];
+        for (int c = 0; c < numConnections; c++) {
+            fds[c + 2].fd = connections[c]->busy || connections[c]->hungUp ? -1 : connections[c]->fd;
+        }
+        for (int f = 0; f < numConnections + 2; f++) {
+            fds[f].events = POLLIN;
+            fds[f].revents = 0;
+        }
+        if (poll(fds, numConnections + 2, 1000) < 0) {
+            if (errno != EINTR) {
+                perror("Failed to poll the connections");
+            }
+            continue;
+        }
+
+        // Connections given back by the workers go on with requests they have sent already
+        if (fds[1].revents & POLLIN) {
+            char wake[64];
+            while (read(daemon->wakeFds[0], wake, sizeof(wake)) > 0) {
+            }
+            struct DaemonConnection *served[DAEMON_MAX_CONNECTIONS];
+            pthread_mutex_lock(&daemon->queueLock);
+            int numServed = daemon->numServed;
+            memcpy(served, daemon->served, numServed * sizeof(struct DaemonConnection *));
+            daemon->numServed = 0;
+            pthread_mutex_unlock(&daemon->queueLock);
+            for (int c = 0; c < numServed; c++) {
+                served[c]->busy = false;
+                served[c]->lastActive = currentTimeSeconds();
+                connectionDispatch(daemon, served[c]);
+            }
+        }
+
+        // Read the connections that have sent something, and close the ones that are done:
+        // hung up with nothing left to serve, failed, or idle too long
+        double now = currentTimeSeconds();
+        for (int c = numConnections - 1; c >= 0; c--) {
+            struct DaemonConnection *connection = connections[c];
+            bool open = true;
+            if (fds[c + 2].revents != 0) {
+                open = connectionRead(connection);
+                if (open) {
+                    connectionDispatch(daemon, connection);
+                }
+            }
+            if (!connection->busy && (!open || connection->hungUp || now - connection->lastActive > DAEMON_IDLE_TIMEOUT)) {
+                close(connection->fd);
+                free(connection->buffer);
+                free(connection);
+                connections[c] = connections[--numConnections];
+            }
+        }
+
+        if (fds[0].revents & POLLIN) {
+            int fd = accept(listener, NULL, NULL);
+            if (fd < 0) {
+                if (errno != EINTR) {
+                    perror("Failed to accept a connection");
+                }
+                continue;
+            }
+            if (numConnections == DAEMON_MAX_CONNECTIONS) {
+                dprintf(fd, "ERROR busy\n");
+                close(fd);
+                continue;
+            }
+            // A worker writing a response gives up on a client that stops reading
+            struct timeval timeout = {DAEMON_SEND_TIMEOUT, 0};
+            setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+            struct DaemonConnection *connection = calloc(1, sizeof(struct DaemonConnection));
+            connection->fd = fd;
+            connection->lastActive = currentTimeSeconds();
+            connection->capacity = 4096;
+            connection->buffer = malloc(connection->capacity);
+            connections[numConnections++] = connection;
+        }
+    }
+
+    close(listener);
+    unlink(socketPath);
+    pthread_mutex_lock(&daemon->cache.lock);
+    printf("Daemon stopped: %lld solves, %lld cache hits, %lld misses\n", daemon->cache.solves, daemon->cache.hits,
+           daemon->cache.misses);
+    pthread_mutex_unlock(&daemon->cache.lock);
+    return 0;
+}
+
+#endif
@@ -0,0 +1,910 @@
+// DYNAMIC.h - The header file for dynamic tours
+// A DynamicTour keeps a good tour while cities are added and removed. A new city goes in
+// at the cheapest of the tour edges at its nearest cities, a removed one is spliced out,
+// and local search queued at the changed edges only repairs the tour around the change.
+// The tour is a doubly linked list of successors and predecessors, so an insertion or
+// removal is a splice, and the repairs are the moves a linked list makes in constant
+// time: Or-opt moves of up to three cities, and 2-opt moves that reverse a path of at
+// most DYNAMIC_MAX_REVERSAL cities. The cities sit in a quadtree whose leaves split and
+// merge where cities come and go and whose root doubles to take in cities outside it,
+// and the candidate lists and their reverse lists (the cities listing a city) are updated
+// in place, so nothing in an update is proportional to the tour size.
+// The cities stay at indices 0 .. numNodes - 1, so a removed city's index is taken over
+// by the last city. Callers refer to cities by their ids.
+
+#ifndef DYNAMIC_H
+#define DYNAMIC_H
+
+#define DYNAMIC_CANDIDATES 8
+#define DYNAMIC_NEAR_CITIES 16   // Nearest cities of a new one: insertion points and lists that may take it
+#define DYNAMIC_ID_SLOTS 4096    // Id table size, a power of two above 2 * MAX_NODES
+#define DYNAMIC_LEAF_CITIES 8    // A leaf splits above this many cities, a subtree merges at half of it
+#define DYNAMIC_MAX_REVERSAL 100 // Longest path a repairing 2-opt move reverses
+
+// Square of the quadtree. A leaf (child[0] < 0) holds a doubly linked list of its cities,
+// an internal node its four quadrants. count is the number of cities below the node.
+struct QuadNode {
+    double minX;
+    double minY;
+    double size;
+    int parent;
+    int child[4];
+    int head;
+    int count;
+};
+
+// Every internal node holds over DYNAMIC_LEAF_CITIES / 2 cities, so the tree has O(n)
+// nodes and a city's leaf holds a few cities around it
+struct DynamicQuadtree {
+    struct QuadNode *nodes;   // Pool, its free nodes chained through parent
+    int capacity;
+    int numNodes;
+    int freeNodes;
+    int root;
+    int next[MAX_NODES];
+    int prev[MAX_NODES];
+    int leaf[MAX_NODES];
+};
+
+struct ReverseList {
+    int count;
+    int capacity;
+    int *cities;
+};
+
+struct DynamicTour {
+    struct Graph graph;
+    int succ[MAX_NODES];
+    int pred[MAX_NODES];
+    double length;
+    struct DynamicQuadtree tree;
+    struct CandidateList candidates;
+    struct ReverseList listedBy[MAX_NODES];   // Cities whose candidate list holds the city
+    int idSlots[DYNAMIC_ID_SLOTS];            // Open addressing from id to city (-1 = empty)
+    int queue[MAX_NODES];
+    bool queued[MAX_NODES];
+};
+
+int quadAlloc(struct DynamicQuadtree *tree, int parent, double minX, double minY, double size) {
+    int node = tree->freeNodes;
+    if (node >= 0) {
+        tree->freeNodes = tree->nodes[node].parent;
+    } else {
+        if (tree->numNodes == tree->capacity) {
+            tree->capacity = tree->capacity > 0 ? 2 * tree->capacity : 64;
+            tree->nodes = realloc(tree->nodes, tree->capacity * sizeof(struct QuadNode));
+        }
+        node = tree->numNodes++;
+    }
+    struct QuadNode *q = &tree->nodes[node];
+    q->minX = minX;
+    q->minY = minY;
+    q->size = size;
+    q->parent = parent;
+    q->child[0] = q->child[1] = q->child[2] = q->child[3] = -1;
+    q->head = -1;
+    q->count = 0;
+    return node;
+}
+
+void quadFree(struct DynamicQuadtree *tree, int node) {
+    tree->nodes[node].parent = tree->freeNodes;
+    tree->freeNodes = node;
+}
+
+// Starts an empty tree whose root covers the given square
+void quadInit(struct DynamicQuadtree *tree, double minX, double minY, double size) {
+    tree->nodes = NULL;
+    tree->capacity = 0;
+    tree->numNodes = 0;
+    tree->freeNodes = -1;
+    tree->root = quadAlloc(tree, -1, minX, minY, size);
+}
+
+bool quadContains(struct QuadNode *q, double x, double y) {
+    return x >= q->minX && x <= q->minX + q->size && y >= q->minY && y <= q->minY + q->size;
+}
+
+int quadChild(struct QuadNode *q, double x, double y) {
+    double half = q->size / 2.0;
+    return q->child[(x >= q->minX + half) + 2 * (y >= q->minY + half)];
+}
+
+// Coincident cities would split a leaf without end, so squares stop splitting once
+// halving them no longer tells coordinates apart
+bool quadCanSplit(struct QuadNode *q) {
+    return q->size > 1e-9 * (1.0 + fabs(q->minX) + fabs(q->minY));
+}
+
+void quadLink(struct DynamicQuadtree *tree, int leaf, int city) {
+    struct QuadNode *q = &tree->nodes[leaf];
+    tree->leaf[city] = leaf;
+    tree->prev[city] = -1;
+    tree->next[city] = q->head;
+    if (q->head >= 0) {
+        tree->prev[q->head] = city;
+    }
+    q->head = city;
+}
+
+void quadUnlink(struct DynamicQuadtree *tree, int city) {
+    if (tree->prev[city] >= 0) {
+        tree->next[tree->prev[city]] = tree->next[city];
+    } else {
+        tree->nodes[tree->leaf[city]].head = tree->next[city];
+    }
+    if (tree->next[city] >= 0) {
+        tree->prev[tree->next[city]] = tree->prev[city];
+    }
+}
+
+// Doubles the root towards (x, y) until it covers the point. A leaf root just grows; an
+// internal one becomes a quadrant of a new root, so no city moves.
+void quadGrow(struct DynamicQuadtree *tree, double x, double y) {
+    while (!quadContains(&tree->nodes[tree->root], x, y)) {
+        struct QuadNode *root = &tree->nodes[tree->root];
+        if (root->count == 0) {
+            root->minX = x - root->size / 2.0;
+            root->minY = y - root->size / 2.0;
+            continue;
+        }
+        double minX = x < root->minX ? root->minX - root->size : root->minX;
+        double minY = y < root->minY ? root->minY - root->size : root->minY;
+        if (root->child[0] < 0) {
+            root->minX = minX;
+            root->minY = minY;
+            root->size *= 2.0;
+            continue;
+        }
+        // The old root is the quadrant away from the point
+        int old = tree->root, oldQuadrant = (x < root->minX) + 2 * (y < root->minY);
+        double size = root->size;
+        int count = root->count;
+        int grown = quadAlloc(tree, -1, minX, minY, 2.0 * size);
+        for (int c = 0; c < 4; c++) {
+            int child = c == oldQuadrant ? old : quadAlloc(tree, grown, minX + (c & 1) * size, minY + (c >> 1) * size, size);
+            tree->nodes[grown].child[c] = child;
+        }
+        tree->nodes[old].parent = grown;
+        tree->nodes[grown].count = count;
+        tree->root = grown;
+    }
+}
+
+// Splits a leaf over DYNAMIC_LEAF_CITIES cities into quadrants, and those in turn
+void quadSplit(struct DynamicQuadtree *tree, struct Graph *graph, int leaf) {
+    if (tree->nodes[leaf].count <= DYNAMIC_LEAF_CITIES || !quadCanSplit(&tree->nodes[leaf])) {
+        return;
+    }
+    double half = tree->nodes[leaf].size / 2.0;
+    for (int c = 0; c < 4; c++) {
+        int child = quadAlloc(tree, leaf, tree->nodes[leaf].minX + (c & 1) * half, tree->nodes[leaf].minY + (c >> 1) * half,
+                              half);
+        tree->nodes[leaf].child[c] = child;
+    }
+    int city = tree->nodes[leaf].head;
+    tree->nodes[leaf].head = -1;
+    while (city >= 0) {
+        int following = tree->next[city];
+        int child = quadChild(&tree->nodes[leaf], graph->nodes[city].x, graph->nodes[city].y);
+        tree->nodes[child].count++;
+        quadLink(tree, child, city);
+        city = following;
+    }
+    for (int c = 0; c < 4; c++) {
+        quadSplit(tree, graph, tree->nodes[leaf].child[c]);
+    }
+}
+
+void quadAdd(struct DynamicQuadtree *tree, struct Graph *graph, int city) {
+    double x = graph->nodes[city].x, y = graph->nodes[city].y;
+    quadGrow(tree, x, y);
+    int node = tree->root;
+    tree->nodes[node].count++;
+    while (tree->nodes[node].child[0] >= 0) {
+        node = quadChild(&tree->nodes[node], x, y);
+        tree->nodes[node].count++;
+    }
+    quadLink(tree, node, city);
+    quadSplit(tree, graph, node);
+}
+
+// Moves the cities below node 'from' into leaf 'into' and frees the nodes under it
+void quadGather(struct DynamicQuadtree *tree, int from, int into) {
+    if (tree->nodes[from].child[0] >= 0) {
+        for (int c = 0; c < 4; c++) {
+            quadGather(tree, tree->nodes[from].child[c], into);
+        }
+    }
+    int city = tree->nodes[from].head;
+    while (city >= 0) {
+        int following = tree->next[city];
+        quadLink(tree, into, city);
+        city = following;
+    }
+    quadFree(tree, from);
+}
+
+// Takes a city out, merges the highest subtree left with at most half a leaf of cities
+// into one leaf, and drops roots with a single non-empty quadrant
+void quadRemove(struct DynamicQuadtree *tree, int city) {
+    quadUnlink(tree, city);
+    int merge = -1;
+    for (int node = tree->leaf[city]; node >= 0; node = tree->nodes[node].parent) {
+        tree->nodes[node].count--;
+        if (tree->nodes[node].child[0] >= 0 && tree->nodes[node].count <= DYNAMIC_LEAF_CITIES / 2) {
+            merge = node;
+        }
+    }
+    if (merge >= 0) {
+        int children[4];
+        memcpy(children, tree->nodes[merge].child, sizeof(children));
+        tree->nodes[merge].child[0] = -1;
+        for (int c = 0; c < 4; c++) {
+            quadGather(tree, children[c], merge);
+        }
+    }
+
+    for (;;) {
+        struct QuadNode *root = &tree->nodes[tree->root];
+        int kept = -1, nonEmpty = 0;
+        for (int c = 0; c < 4 && root->child[0] >= 0; c++) {
+            if (tree->nodes[root->child[c]].count > 0) {
+                kept = root->child[c];
+                nonEmpty++;
+            }
+        }
+        if (nonEmpty != 1) {
+            return;
+        }
+        for (int c = 0; c < 4; c++) {
+            if (root->child[c] != kept) {
+                quadFree(tree, root->child[c]);
+            }
+        }
+        quadFree(tree, tree->root);
+        tree->nodes[kept].parent = -1;
+        tree->root = kept;
+    }
+}
+
+double quadDistance(struct QuadNode *q, double x, double y) {
+    double dx = fmax(fmax(q->minX - x, x - q->minX - q->size), 0.0);
+    double dy = fmax(fmax(q->minY - y, y - q->minY - q->size), 0.0);
+    return sqrt(dx * dx + dy * dy);
+}
+
+// Adds the cities below node to the k nearest found so far, skipping quadrants farther
+// than the k-th of them
+void quadSearch(struct DynamicQuadtree *tree, struct Graph *graph, int node, struct Node query, int exclude, int k,
+                int *result, double *resultDist, int *found) {
+    struct QuadNode *q = &tree->nodes[node];
+    if (q->child[0] < 0) {
+        for (int city = q->head; city >= 0; city = tree->next[city]) {
+            if (city == exclude) {
+                continue;
+            }
+            double d = calculateDistance(query, graph->nodes[city]);
+            if (*found == k && d >= resultDist[k - 1]) {
+                continue;
+            }
+            int p = *found < k ? (*found)++ : k - 1;
+            while (p > 0 && resultDist[p - 1] > d) {
+                result[p] = result[p - 1];
+                resultDist[p] = resultDist[p - 1];
+                p--;
+            }
+            result[p] = city;
+            resultDist[p] = d;
+        }
+        return;
+    }
+
+    // Nearest quadrant first, so the farther ones are mostly cut off
+    int order[4];
+    double dist[4];
+    for (int c = 0; c < 4; c++) {
+        double d = quadDistance(&tree->nodes[q->child[c]], query.x, query.y);
+        int p = c;
+        while (p > 0 && dist[p - 1] > d) {
+            order[p] = order[p - 1];
+            dist[p] = dist[p - 1];
+            p--;
+        }
+        order[p] = q->child[c];
+        dist[p] = d;
+    }
+    for (int c = 0; c < 4 && (*found < k || dist[c] < resultDist[k - 1]); c++) {
+        if (tree->nodes[order[c]].count > 0) {
+            quadSearch(tree, graph, order[c], query, exclude, k, result, resultDist, found);
+        }
+    }
+}
+
+// Finds up to k cities nearest to (x, y), skipping 'exclude', nearest first, like
+// gridNearest. Returns how many were found. The search starts at the leaf covering the
+// point and widens to the ancestors' other quadrants only until the cities found are
+// nearer than anything outside, so it stays around the point.
+int quadNearest(struct DynamicQuadtree *tree, struct Graph *graph, double x, double y, int exclude, int k, int *result,
+                double *resultDist) {
+    int found = 0;
+    if (k <= 0) {
+        return 0;
+    }
+    struct Node query = {-1, x, y};
+    int node = tree->root;
+    while (tree->nodes[node].child[0] >= 0 && quadContains(&tree->nodes[node], x, y)) {
+        node = quadChild(&tree->nodes[node], x, y);
+    }
+    quadSearch(tree, graph, node, query, exclude, k, result, resultDist, &found);
+    for (int parent = tree->nodes[node].parent; parent >= 0; node = parent, parent = tree->nodes[node].parent) {
+        struct QuadNode *q = &tree->nodes[node];
+        double inside = fmin(fmin(x - q->minX, q->minX + q->size - x), fmin(y - q->minY, q->minY + q->size - y));
+        if (found == k && resultDist[k - 1] <= inside) {
+            break;
+        }
+        for (int c = 0; c < 4; c++) {
+            struct QuadNode *sibling = &tree->nodes[tree->nodes[parent].child[c]];
+            if (sibling != q && sibling->count > 0 &&
+                (found < k || quadDistance(sibling, x, y) < resultDist[k - 1])) {
+                quadSearch(tree, graph, tree->nodes[parent].child[c], query, exclude, k, result, resultDist, &found);
+            }
+        }
+    }
+    return found;
+}
+
+int idSlot(int id) {
+    return (int) (((unsigned int) id * 2654435761u) & (DYNAMIC_ID_SLOTS - 1));
+}
+
+// Slot holding id, or the empty slot where it would go
+int idFindSlot(struct DynamicTour *dyn, int id) {
+    int s = idSlot(id);
+    while (dyn->idSlots[s] >= 0 && dyn->graph.nodes[dyn->idSlots[s]].id != id) {
+        s = (s + 1) & (DYNAMIC_ID_SLOTS - 1);
+    }
+    return s;
+}
+
+// Empties slot s, moving later entries of its probe run back so no lookup breaks
+void idClearSlot(struct DynamicTour *dyn, int s) {
+    dyn->idSlots[s] = -1;
+    int t = s;
+    for (;;) {
+        t = (t + 1) & (DYNAMIC_ID_SLOTS - 1);
+        if (dyn->idSlots[t] < 0) {
+            return;
+        }
+        int home = idSlot(dyn->graph.nodes[dyn->idSlots[t]].id);
+        // The entry at t may move to s if its home is not in (s, t]
+        if (((t - home) & (DYNAMIC_ID_SLOTS - 1)) >= ((t - s) & (DYNAMIC_ID_SLOTS - 1))) {
+            dyn->idSlots[s] = dyn->idSlots[t];
+            dyn->idSlots[t] = -1;
+            s = t;
+        }
+    }
+}
+
+// City of the given id, or -1
+int dynamicCity(struct DynamicTour *dyn, int id) {
+    return dyn->idSlots[idFindSlot(dyn, id)];
+}
+
+void listedByAdd(struct DynamicTour *dyn, int city, int by) {
+    struct ReverseList *list = &dyn->listedBy[city];
+    for (int i = 0; i < list->count; i++) {
+        if (list->cities[i] == by) {
+            return;
+        }
+    }
+    if (list->count == list->capacity) {
+        list->capacity = list->capacity > 0 ? 2 * list->capacity : 4;
+        list->cities = realloc(list->cities, list->capacity * sizeof(int));
+    }
+    list->cities[list->count++] = by;
+}
+
+void listedByRemove(struct DynamicTour *dyn, int city, int by) {
+    struct ReverseList *list = &dyn->listedBy[city];
+    for (int i = 0; i < list->count; i++) {
+        if (list->cities[i] == by) {
+            list->cities[i] = list->cities[--list->count];
+            return;
+        }
+    }
+}
+
+// Recomputes the candidate list of a city from the quadtree
+void dynamicSetCandidates(struct DynamicTour *dyn, int city) {
+    struct CandidateList *candidates = &dyn->candidates;
+    for (int m = 0; m < candidates->count; m++) {
+        listedByRemove(dyn, candidates->neighbors[city][m], city);
+    }
+    double dist[MAX_CANDIDATES];
+    quadNearest(&dyn->tree, &dyn->graph, dyn->graph.nodes[city].x, dyn->graph.nodes[city].y, city, candidates->count,
+                candidates->neighbors[city], dist);
+    for (int m = 0; m < candidates->count; m++) {
+        listedByAdd(dyn, candidates->neighbors[city][m], city);
+    }
+}
+
+// Puts city into the candidate list of 'by' if it is nearer than the farthest entry
+void dynamicOfferCandidate(struct DynamicTour *dyn, int by, int city, double d) {
+    struct CandidateList *candidates = &dyn->candidates;
+    int *list = candidates->neighbors[by];
+    int k = candidates->count;
+    if (d >= calculateDistance(dyn->graph.nodes[by], dyn->graph.nodes[list[k - 1]])) {
+        return;
+    }
+    listedByRemove(dyn, list[k - 1], by);
+    int p = k - 1;
+    while (p > 0 && calculateDistance(dyn->graph.nodes[by], dyn->graph.nodes[list[p - 1]]) > d) {
+        list[p] = list[p - 1];
+        p--;
+    }
+    list[p] = city;
+    listedByAdd(dyn, city, by);
+}
+
+// Builds all candidate lists from scratch
+void dynamicRebuildCandidates(struct DynamicTour *dyn) {
+    int n = dyn->graph.numNodes;
+    for (int i = 0; i < n; i++) {
+        dyn->listedBy[i].count = 0;
+    }
+    dyn->candidates.count = n - 1 < DYNAMIC_CANDIDATES ? (n > 1 ? n - 1 : 0) : DYNAMIC_CANDIDATES;
+    dyn->candidates.fixedPartner = NULL;
+    for (int i = 0; i < n; i++) {
+        double dist[MAX_CANDIDATES];
+        quadNearest(&dyn->tree, &dyn->graph, dyn->graph.nodes[i].x, dyn->graph.nodes[i].y, i, dyn->candidates.count,
+                    dyn->candidates.neighbors[i], dist);
+        for (int m = 0; m < dyn->candidates.count; m++) {
+            listedByAdd(dyn, dyn->candidates.neighbors[i][m], i);
+        }
+    }
+}
+
+// Lists shorter than DYNAMIC_CANDIDATES fit only the tour size they were built for, at
+// most DYNAMIC_CANDIDATES + 1 cities, so rebuilding them is cheap
+bool dynamicNeedsRebuild(struct DynamicTour *dyn) {
+    int n = dyn->graph.numNodes;
+    int count = n - 1 < DYNAMIC_CANDIDATES ? (n > 1 ? n - 1 : 0) : DYNAMIC_CANDIDATES;
+    return count != dyn->candidates.count;
+}
+
+// Starts from the cities of graph (at most MAX_NODES, ids unique) and a tour of them
+void dynamicTourInit(struct DynamicTour *dyn, struct Graph *graph, const int *tour) {
+    int n = graph->numNodes;
+    dyn->graph = *graph;
+    for (int s = 0; s < DYNAMIC_ID_SLOTS; s++) {
+        dyn->idSlots[s] = -1;
+    }
+    for (int i = 0; i < MAX_NODES; i++) {
+        dyn->listedBy[i].count = 0;
+        dyn->listedBy[i].capacity = 0;
+        dyn->listedBy[i].cities = NULL;
+        dyn->queued[i] = false;
+    }
+    dyn->length = 0.0;
+    for (int i = 0; i < n; i++) {
+        dyn->succ[tour[i]] = tour[(i + 1) % n];
+        dyn->pred[tour[(i + 1) % n]] = tour[i];
+        dyn->length += n > 1 ? calculateDistance(graph->nodes[tour[i]], graph->nodes[tour[(i + 1) % n]]) : 0.0;
+        dyn->idSlots[idFindSlot(dyn, graph->nodes[i].id)] = i;
+    }
+
+    double minX = DBL_MAX, minY = DBL_MAX, maxX = -DBL_MAX, maxY = -DBL_MAX;
+    for (int i = 0; i < n; i++) {
+        minX = fmin(minX, graph->nodes[i].x);
+        minY = fmin(minY, graph->nodes[i].y);
+        maxX = fmax(maxX, graph->nodes[i].x);
+        maxY = fmax(maxY, graph->nodes[i].y);
+    }
+    if (n == 0) {
+        minX = minY = maxX = maxY = 0.0;
+    }
+    quadInit(&dyn->tree, minX, minY, fmax(fmax(maxX - minX, maxY - minY), 1e-9));
+    for (int i = 0; i < n; i++) {
+        quadAdd(&dyn->tree, &dyn->graph, i);
+    }
+    dynamicRebuildCandidates(dyn);
+}
+
+void dynamicTourFree(struct DynamicTour *dyn) {
+    for (int i = 0; i < MAX_NODES; i++) {
+        free(dyn->listedBy[i].cities);
+    }
+    free(dyn->tree.nodes);
+}
+
+void dynamicLink(struct DynamicTour *dyn, int a, int b) {
+    dyn->succ[a] = b;
+    dyn->pred[b] = a;
+}
+
+// Swaps the successors and predecessors of the tour path first .. last, leaving its ends
+// for the caller to link
+void dynamicTurnPath(struct DynamicTour *dyn, int first, int last) {
+    for (int city = first;; ) {
+        int following = dyn->succ[city];
+        dyn->succ[city] = dyn->pred[city];
+        dyn->pred[city] = following;
+        if (city == last) {
+            return;
+        }
+        city = following;
+    }
+}
+
+// Reverses the tour path first .. last in place: O(its length)
+void dynamicReversePath(struct DynamicTour *dyn, int first, int last) {
+    int before = dyn->pred[first], after = dyn->succ[last];
+    dynamicTurnPath(dyn, first, last);
+    dynamicLink(dyn, before, last);
+    dynamicLink(dyn, first, after);
+}
+
+// True if the tour path from 'first' reaches 'last' within 'limit' cities
+bool dynamicPathWithin(struct DynamicTour *dyn, int first, int last, int limit) {
+    for (int i = 0; i < limit; i++, first = dyn->succ[first]) {
+        if (first == last) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// The tour paths first .. last and otherFirst .. otherLast make up the tour. Returns 0 or
+// 1 for the one at most 'limit' cities long, walking both at once so this costs the
+// shorter one, or -1 if both are longer.
+int dynamicShortPath(struct DynamicTour *dyn, int first, int last, int otherFirst, int otherLast, int limit) {
+    for (int i = 0; i < limit; i++, first = dyn->succ[first], otherFirst = dyn->succ[otherFirst]) {
+        if (first == last) {
+            return 0;
+        }
+        if (otherFirst == otherLast) {
+            return 1;
+        }
+    }
+    return -1;
+}
+
+// Moves the tour path first .. last (at most a few cities) between 'after' and its
+// successor, turned around if asked
+void dynamicMoveSegment(struct DynamicTour *dyn, int first, int last, int after, bool reversed) {
+    dynamicLink(dyn, dyn->pred[first], dyn->succ[last]);
+    int to = dyn->succ[after];
+    if (reversed) {
+        dynamicTurnPath(dyn, first, last);
+        dynamicLink(dyn, after, last);
+        dynamicLink(dyn, first, to);
+    } else {
+        dynamicLink(dyn, after, first);
+        dynamicLink(dyn, last, to);
+    }
+}
+
+// First improving 2-opt move at city a, as twoOptNeighborMove, taken only if one of the
+// two paths it could reverse is at most DYNAMIC_MAX_REVERSAL cities long
+double dynamicTwoOptMove(struct DynamicTour *dyn, int a, int *ends) {
+    struct Node *nodes = dyn->graph.nodes;
+    struct CandidateList *candidates = &dyn->candidates;
+    for (int dir = 0; dir < 2; dir++) {
+        int b = dir == 0 ? dyn->succ[a] : dyn->pred[a];
+        double dab = calculateDistance(nodes[a], nodes[b]);
+
+        for (int m = 0; m < candidates->count; m++) {
+            int c = candidates->neighbors[a][m];
+            double dac = calculateDistance(nodes[a], nodes[c]);
+            if (dac >= dab) {
+                break; // Candidates are sorted, no later one can gain
+            }
+            int d = dir == 0 ? dyn->succ[c] : dyn->pred[c];
+            if (c == b || d == a) {
+                continue;
+            }
+
+            double gain = dab + calculateDistance(nodes[c], nodes[d]) - dac - calculateDistance(nodes[b], nodes[d]);
+            PERF_COUNT(deltaEvals);
+            if (gain <= 1e-10) {
+                PERF_COUNT(movesRejected);
+                continue;
+            }
+            // Replace (a,b),(c,d) with (a,c),(b,d) by reversing b .. c or the rest, d .. a
+            int first = dir == 0 ? b : a, last = dir == 0 ? c : d;
+            int otherFirst = dir == 0 ? d : c, otherLast = dir == 0 ? a : b;
+            int shorter = dynamicShortPath(dyn, first, last, otherFirst, otherLast, DYNAMIC_MAX_REVERSAL);
+            if (shorter < 0) {
+                PERF_COUNT(movesRejected);
+                continue;
+            }
+            if (shorter == 0) {
+                dynamicReversePath(dyn, first, last);
+            } else {
+                dynamicReversePath(dyn, otherFirst, otherLast);
+            }
+            PERF_COUNT(movesAccepted);
+            ends[0] = a;
+            ends[1] = b;
+            ends[2] = c;
+            ends[3] = d;
+            ends[4] = a;
+            ends[5] = a;
+            return gain;
+        }
+    }
+    return 0.0;
+}
+
+// First improving Or-opt move of the one to three cities from city a, as orOptNeighborMove
+double dynamicOrOptMove(struct DynamicTour *dyn, int a, int *ends) {
+    int n = dyn->graph.numNodes;
+    struct Node *nodes = dyn->graph.nodes;
+    struct CandidateList *candidates = &dyn->candidates;
+    int prev = dyn->pred[a];
+    int last = a;
+
+    for (int length = 1; length <= 3 && length + 3 <= n; length++, last = dyn->succ[last]) {
+        int next = dyn->succ[last];
+        double removeGain = calculateDistance(nodes[prev], nodes[a]) + calculateDistance(nodes[last], nodes[next])
+                          - calculateDistance(nodes[prev], nodes[next]);
+        if (removeGain <= 1e-10) {
+            continue;
+        }
+
+        for (int m = 0; m < candidates->count; m++) {
+            int c = candidates->neighbors[a][m];
+            double dac = calculateDistance(nodes[a], nodes[c]);
+            if (dac >= removeGain) {
+                break;
+            }
+            if (dynamicPathWithin(dyn, a, c, length)) {
+                continue; // Inside the segment
+            }
+
+            // c, a .. last, after
+            int after = dyn->succ[c];
+            if (c != prev) {
+                double gain = removeGain - dac - calculateDistance(nodes[last], nodes[after])
+                            + calculateDistance(nodes[c], nodes[after]);
+                PERF_COUNT(deltaEvals);
+                if (gain > 1e-10) {
+                    PERF_COUNT(movesAccepted);
+                    dynamicMoveSegment(dyn, a, last, c, false);
+                    ends[0] = prev;
+                    ends[1] = next;
+                    ends[2] = a;
+                    ends[3] = last;
+                    ends[4] = c;
+                    ends[5] = after;
+                    return gain;
+                }
+                PERF_COUNT(movesRejected);
+            }
+
+            // before, last .. a, c
+            int before = dyn->pred[c];
+            if (c != next) {
+                double gain = removeGain - dac - calculateDistance(nodes[before], nodes[last])
+                            + calculateDistance(nodes[before], nodes[c]);
+                PERF_COUNT(deltaEvals);
+                if (gain > 1e-10) {
+                    PERF_COUNT(movesAccepted);
+                    dynamicMoveSegment(dyn, a, last, before, true);
+                    ends[0] = prev;
+                    ends[1] = next;
+                    ends[2] = a;
+                    ends[3] = last;
+                    ends[4] = c;
+                    ends[5] = before;
+                    return gain;
+                }
+                PERF_COUNT(movesRejected);
+            }
+        }
+    }
+    return 0.0;
+}
+
+// Local search from the given cities, see neighborLocalSearch. The queued flags persist
+// between updates, so nothing here is proportional to the tour size.
+void dynamicLocalSearch(struct DynamicTour *dyn, const int *touched, int numTouched) {
+    int n = dyn->graph.numNodes;
+    if (n < 8) {
+        return;
+    }
+    int head = 0, size = 0;
+    for (int t = 0; t < numTouched; t++) {
+        if (!dyn->queued[touched[t]]) {
+            dyn->queued[touched[t]] = true;
+            dyn->queue[(head + size++) % n] = touched[t];
+        }
+    }
+    while (size > 0) {
+        int a = dyn->queue[head];
+        head = (head + 1) % n;
+        size--;
+        dyn->queued[a] = false;
+
+        int ends[6];
+        double gain = dynamicTwoOptMove(dyn, a, ends);
+        if (gain <= 0.0) {
+            gain = dynamicOrOptMove(dyn, a, ends);
+        }
+        if (gain > 0.0) {
+            dyn->length -= gain;
+            for (int e = 0; e < 6; e++) {
+                if (!dyn->queued[ends[e]]) {
+                    dyn->queued[ends[e]] = true;
+                    dyn->queue[(head + size++) % n] = ends[e];
+                }
+            }
+        }
+    }
+}
+
+// Adds a city at its cheapest insertion point and repairs the tour around it. Returns
+// false if the id is taken or the tour is full.
+bool dynamicInsert(struct DynamicTour *dyn, int id, double x, double y) {
+    int n = dyn->graph.numNodes;
+    int slot = idFindSlot(dyn, id);
+    if (n == MAX_NODES || dyn->idSlots[slot] >= 0) {
+        return false;
+    }
+    int city = n;
+    dyn->graph.nodes[city].id = id;
+    dyn->graph.nodes[city].x = x;
+    dyn->graph.nodes[city].y = y;
+    dyn->idSlots[slot] = city;
+
+    int near[DYNAMIC_NEAR_CITIES];
+    double nearDist[DYNAMIC_NEAR_CITIES];
+    int numNear = quadNearest(&dyn->tree, &dyn->graph, x, y, city, DYNAMIC_NEAR_CITIES, near, nearDist);
+
+    // Cheapest of the tour edges at the nearest cities
+    struct Node *nodes = dyn->graph.nodes;
+    int bestA = -1;
+    double bestCost = DBL_MAX;
+    for (int i = 0; i < numNear && n >= 2; i++) {
+        for (int side = 0; side < 2; side++) {
+            int a = side == 0 ? near[i] : dyn->pred[near[i]];
+            int b = dyn->succ[a];
+            double cost = calculateDistance(nodes[a], nodes[city]) + calculateDistance(nodes[city], nodes[b]) -
+                          calculateDistance(nodes[a], nodes[b]);
+            PERF_COUNT(deltaEvals);
+            if (cost < bestCost) {
+                bestCost = cost;
+                bestA = a;
+            }
+        }
+    }
+    if (n == 0) {
+        dynamicLink(dyn, city, city);
+    } else if (n == 1) {
+        dynamicLink(dyn, near[0], city);
+        dynamicLink(dyn, city, near[0]);
+        bestCost = 2.0 * nearDist[0];
+    } else {
+        dynamicLink(dyn, city, dyn->succ[bestA]);
+        dynamicLink(dyn, bestA, city);
+    }
+    dyn->graph.numNodes = n + 1;
+    dyn->length += n > 0 ? bestCost : 0.0;
+    quadAdd(&dyn->tree, &dyn->graph, city);
+
+    if (dynamicNeedsRebuild(dyn)) {
+        dynamicRebuildCandidates(dyn);
+    } else {
+        int k = dyn->candidates.count;
+        for (int m = 0; m < k; m++) {
+            dyn->candidates.neighbors[city][m] = near[m];
+            listedByAdd(dyn, near[m], city);
+        }
+        for (int i = 0; i < numNear; i++) {
+            dynamicOfferCandidate(dyn, near[i], city, nearDist[i]);
+        }
+    }
+
+    if (n >= 2) {
+        int touched[3] = {bestA, city, dyn->succ[city]};
+        dynamicLocalSearch(dyn, touched, 3);
+    }
+    return true;
+}
+
+// Gives city the index 'to', which the caller has freed
+void dynamicRenumber(struct DynamicTour *dyn, int city, int to) {
+    struct CandidateList *candidates = &dyn->candidates;
+    dyn->graph.nodes[to] = dyn->graph.nodes[city];
+    dyn->idSlots[idFindSlot(dyn, dyn->graph.nodes[to].id)] = to;
+    int succ = dyn->succ[city] == city ? to : dyn->succ[city];
+    int pred = dyn->pred[city] == city ? to : dyn->pred[city];
+    dynamicLink(dyn, to, succ);
+    dynamicLink(dyn, pred, to);
+
+    struct DynamicQuadtree *tree = &dyn->tree;
+    tree->leaf[to] = tree->leaf[city];
+    tree->prev[to] = tree->prev[city];
+    tree->next[to] = tree->next[city];
+    if (tree->prev[to] >= 0) {
+        tree->next[tree->prev[to]] = to;
+    } else {
+        tree->nodes[tree->leaf[to]].head = to;
+    }
+    if (tree->next[to] >= 0) {
+        tree->prev[tree->next[to]] = to;
+    }
+
+    for (int m = 0; m < candidates->count; m++) {
+        int w = candidates->neighbors[city][m];
+        candidates->neighbors[to][m] = w;
+        listedByRemove(dyn, w, city);
+        listedByAdd(dyn, w, to);
+    }
+    struct ReverseList freed = dyn->listedBy[to];
+    dyn->listedBy[to] = dyn->listedBy[city];
+    dyn->listedBy[city] = freed;
+    dyn->listedBy[city].count = 0;
+    for (int i = 0; i < dyn->listedBy[to].count; i++) {
+        int u = dyn->listedBy[to].cities[i];
+        for (int m = 0; m < candidates->count; m++) {
+            if (candidates->neighbors[u][m] == city) {
+                candidates->neighbors[u][m] = to;
+            }
+        }
+    }
+}
+
+// Removes the city with the given id, joining its tour neighbors, and repairs the tour
+// around them. Returns false if there is no such city.
+bool dynamicRemove(struct DynamicTour *dyn, int id) {
+    int slot = idFindSlot(dyn, id);
+    int city = dyn->idSlots[slot];
+    if (city < 0) {
+        return false;
+    }
+    int n = dyn->graph.numNodes;
+    struct Node *nodes = dyn->graph.nodes;
+    int a = dyn->pred[city];
+    int b = dyn->succ[city];
+    if (n > 2) {
+        dyn->length += calculateDistance(nodes[a], nodes[b]) - calculateDistance(nodes[a], nodes[city]) -
+                       calculateDistance(nodes[city], nodes[b]);
+    } else {
+        dyn->length = 0.0;
+    }
+    dynamicLink(dyn, a, b);
+    idClearSlot(dyn, slot);
+
+    // Out of the index first, so the lists that held it refill without it
+    quadRemove(&dyn->tree, city);
+    for (int m = 0; m < dyn->candidates.count; m++) {
+        listedByRemove(dyn, dyn->candidates.neighbors[city][m], city);
+    }
+    // Below DYNAMIC_CANDIDATES + 1 cities everything is rebuilt below
+    if (n - 2 >= DYNAMIC_CANDIDATES) {
+        while (dyn->listedBy[city].count > 0) {
+            dynamicSetCandidates(dyn, dyn->listedBy[city].cities[0]);
+        }
+    }
+
+    int last = n - 1;
+    if (city != last) {
+        dynamicRenumber(dyn, last, city);
+        a = a == last ? city : a;
+        b = b == last ? city : b;
+    }
+    dyn->graph.numNodes = n - 1;
+
+    if (dynamicNeedsRebuild(dyn)) {
+        dynamicRebuildCandidates(dyn);
+    }
+    if (n - 1 >= 2) {
+        int touched[2] = {a, b};
+        dynamicLocalSearch(dyn, touched, 2);
+    }
+    return true;
+}
+
+#endif
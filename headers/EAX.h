@@ -0,0 +1,584 @@
+// EAX.h - The header file for Edge Assembly Crossover (EAX) genetic algorithm
+// Tours are kept as city adjacency (links), parents are paired along a random cycle of
+// the population, every pair yields EAX_CHILDREN offspring built from AB-cycles, and
+// the first parent is replaced by the offspring that best trades length for loss of
+// edge entropy. All per-generation scratch space lives in struct EAXWorkspace, which
+// is owned by an EAXContext and reused across runs. The initial population comes from
+// buildPopulation (GPX.h).
+
+#ifndef EAX_H
+#define EAX_H
+
+#define EAX_POPULATION_SIZE 100
+#define EAX_CHILDREN 30                 // Offspring generated per parent pair
+#define EAX_STAGNATION_GENERATIONS 50   // Stop after this many generations without a new best
+#define EAX_MERGE_CANDIDATES 10         // Candidate neighbors tried when merging subtours
+
+// E-set selection strategies
+#define EAX_SINGLE 0   // Every offspring applies a single AB-cycle (EAX-1AB)
+#define EAX_RAND 1     // Every AB-cycle is applied with probability 1/2
+
+struct EAXPopulation {
+    int size;
+    int links[EAX_POPULATION_SIZE][MAX_NODES][2];   // The two tour neighbors of every city
+    double length[EAX_POPULATION_SIZE];
+};
+
+// Scratch space of one crossover. AB-cycles are stored back to back in cycleVertices,
+// cycle c occupying [cycleStart[c], cycleStart[c + 1]) with its first edge from parent A.
+struct EAXWorkspace {
+    int remA[MAX_NODES][2];        // Parent A edges not in B and not yet in an AB-cycle
+    int remB[MAX_NODES][2];
+    int countA[MAX_NODES];
+    int countB[MAX_NODES];
+    int path[2 * MAX_NODES + 1];
+    int pathPos[MAX_NODES][2];     // Position of a city on the path, by parity of the position
+    int starts[MAX_NODES];
+    int cycleVertices[2 * MAX_NODES];
+    int cycleStart[MAX_NODES + 1];
+    double cycleDelta[MAX_NODES];  // Length change of applying the cycle to parent A
+    int numCycles;
+    int order[MAX_NODES];          // Cycle indices in random order
+    int childLinks[MAX_NODES][2];
+    int bestLinks[MAX_NODES][2];
+    int modified[4 * MAX_NODES];   // Cities whose links differ from parent A
+    int numModified;
+    int modifiedStamp[MAX_NODES];
+    int subtourOf[MAX_NODES];
+    int subtourHead[MAX_NODES];
+    int subtourSize[MAX_NODES];
+    int visitStamp[MAX_NODES];
+    int members[MAX_NODES];
+    int stamp;
+    double entropyTerm[EAX_POPULATION_SIZE + 2];   // -(f/N) log(f/N) for an edge in f tours
+    unsigned short *edgeFrequency;                  // Tours containing edge (a, b), at a * n + b with a < b
+    struct CandidateList candidates;
+};
+
+// Parameters, seed and scratch space of EAX runs. The buffers are allocated once and
+// reused across runs and instances. Concurrent runs need a context each.
+struct EAXContext {
+    int strategy;
+    double timeLimit;            // Wall-clock limit in seconds (0 = until stagnation)
+    int initThreads;             // Threads building the population (0 = one per online core)
+    unsigned long long seed;
+    struct Trace *trace;         // Convergence trace (NULL = none), iterations counted in generations
+    struct RunControl *control;  // Deadline, target and cancellation (NULL = none)
+
+    struct EAXPopulation *population;
+    int (*members)[MAX_NODES];
+    struct EAXWorkspace *workspace;
+    size_t edgeCapacity;         // Entries allocated in workspace->edgeFrequency
+    struct SpatialGrid *grid;
+};
+
+void eaxContextInit(struct EAXContext *ctx) {
+    ctx->strategy = EAX_SINGLE;
+    ctx->timeLimit = 0.0;
+    ctx->initThreads = 0;
+    ctx->seed = 1;
+    ctx->trace = NULL;
+    ctx->control = NULL;
+    ctx->population = malloc(sizeof(struct EAXPopulation));
+    ctx->members = malloc(EAX_POPULATION_SIZE * sizeof(*ctx->members));
+    ctx->workspace = malloc(sizeof(struct EAXWorkspace));
+    ctx->workspace->edgeFrequency = NULL;
+    ctx->edgeCapacity = 0;
+    ctx->grid = malloc(sizeof(struct SpatialGrid));
+}
+
+void eaxContextFree(struct EAXContext *ctx) {
+    free(ctx->grid);
+    free(ctx->workspace->edgeFrequency);
+    free(ctx->workspace);
+    free(ctx->members);
+    free(ctx->population);
+}
+
+int eaxEdgeIndex(int a, int b, int numNodes) {
+    return a < b ? a * numNodes + b : b * numNodes + a;
+}
+
+void eaxReplaceLink(int (*links)[2], int v, int oldNeighbor, int newNeighbor) {
+    if (links[v][0] == oldNeighbor) {
+        links[v][0] = newNeighbor;
+    } else {
+        links[v][1] = newNeighbor;
+    }
+}
+
+bool eaxHasLink(int (*links)[2], int v, int u) {
+    return links[v][0] == u || links[v][1] == u;
+}
+
+void eaxRemoveRemaining(int (*rem)[2], int *count, int a, int b) {
+    for (int s = 0; s < count[a]; s++) {
+        if (rem[a][s] == b) {
+            rem[a][s] = rem[a][--count[a]];
+            break;
+        }
+    }
+    for (int s = 0; s < count[b]; s++) {
+        if (rem[b][s] == a) {
+            rem[b][s] = rem[b][--count[b]];
+            break;
+        }
+    }
+}
+
+// Stores path[q .. k) as a new AB-cycle, rotated so that its first edge is from A
+void eaxStoreCycle(struct Graph *graph, struct EAXWorkspace *ws, int q, int k) {
+    int c = ws->numCycles;
+    int start = ws->cycleStart[c];
+    int length = k - q;
+    for (int i = 0; i < length; i++) {
+        ws->cycleVertices[start + i] = ws->path[q + (q % 2 + i) % length];
+    }
+    ws->cycleStart[c + 1] = start + length;
+
+    double delta = 0.0;
+    for (int i = 0; i < length; i++) {
+        int a = ws->cycleVertices[start + i];
+        int b = ws->cycleVertices[start + (i + 1) % length];
+        double d = calculateDistance(graph->nodes[a], graph->nodes[b]);
+        delta += i % 2 == 0 ? -d : d;
+    }
+    ws->cycleDelta[c] = delta;
+    ws->numCycles++;
+}
+
+// Decomposes the edges of A and B that are not shared into AB-cycles: closed walks that
+// alternate between an A edge and a B edge. A random alternating walk is extended until
+// it returns to a city it visited at a position of the same parity; that stretch is cut
+// off as a cycle and the walk goes on from there.
+void eaxBuildABCycles(struct Graph *graph, int (*linksA)[2], int (*linksB)[2], struct EAXWorkspace *ws, struct Rng *rng) {
+    int n = graph->numNodes;
+    int numStarts = 0;
+    for (int v = 0; v < n; v++) {
+        ws->countA[v] = 0;
+        ws->countB[v] = 0;
+        for (int s = 0; s < 2; s++) {
+            if (!eaxHasLink(linksB, v, linksA[v][s])) {
+                ws->remA[v][ws->countA[v]++] = linksA[v][s];
+            }
+            if (!eaxHasLink(linksA, v, linksB[v][s])) {
+                ws->remB[v][ws->countB[v]++] = linksB[v][s];
+            }
+        }
+        ws->pathPos[v][0] = -1;
+        ws->pathPos[v][1] = -1;
+        if (ws->countA[v] > 0) {
+            ws->starts[numStarts++] = v;
+        }
+    }
+
+    ws->numCycles = 0;
+    ws->cycleStart[0] = 0;
+    while (numStarts > 0) {
+        int pick = rngInt(rng, numStarts);
+        int start = ws->starts[pick];
+        if (ws->countA[start] == 0) {
+            ws->starts[pick] = ws->starts[--numStarts];
+            continue;
+        }
+
+        int k = 0;
+        ws->path[0] = start;
+        ws->pathPos[start][0] = 0;
+        while (k > 0 || ws->countA[start] > 0) {
+            // Even positions leave by an A edge, odd positions by a B edge
+            int cur = ws->path[k];
+            int next;
+            if (k % 2 == 0) {
+                next = ws->remA[cur][rngInt(rng, ws->countA[cur])];
+                eaxRemoveRemaining(ws->remA, ws->countA, cur, next);
+            } else {
+                next = ws->remB[cur][rngInt(rng, ws->countB[cur])];
+                eaxRemoveRemaining(ws->remB, ws->countB, cur, next);
+            }
+            ws->path[++k] = next;
+
+            int q = ws->pathPos[next][k % 2];
+            if (q < 0) {
+                ws->pathPos[next][k % 2] = k;
+                continue;
+            }
+            eaxStoreCycle(graph, ws, q, k);
+            for (int j = q + 1; j < k; j++) {
+                ws->pathPos[ws->path[j]][j % 2] = -1;
+            }
+            k = q;
+        }
+        ws->pathPos[start][0] = -1;
+    }
+}
+
+void eaxMarkModified(struct EAXWorkspace *ws, int v) {
+    if (ws->modifiedStamp[v] != ws->stamp) {
+        ws->modifiedStamp[v] = ws->stamp;
+        ws->modified[ws->numModified++] = v;
+    }
+}
+
+// Replaces the A edges of cycle c in childLinks by its B edges
+void eaxApplyCycle(struct EAXWorkspace *ws, int c) {
+    int start = ws->cycleStart[c];
+    int length = ws->cycleStart[c + 1] - start;
+    int *cycle = &ws->cycleVertices[start];
+    for (int i = 0; i < length; i++) {
+        int prev = cycle[(i - 1 + length) % length];
+        int next = cycle[(i + 1) % length];
+        int v = cycle[i];
+        if (i % 2 == 0) {
+            eaxReplaceLink(ws->childLinks, v, next, prev);
+        } else {
+            eaxReplaceLink(ws->childLinks, v, prev, next);
+        }
+        eaxMarkModified(ws, v);
+    }
+}
+
+// Labels the subtours of childLinks. Every subtour passes through a modified city,
+// since the untouched part of A is a single path.
+int eaxLabelSubtours(struct EAXWorkspace *ws) {
+    int numSubtours = 0;
+    for (int m = 0; m < ws->numModified; m++) {
+        int s = ws->modified[m];
+        if (ws->visitStamp[s] == ws->stamp) {
+            continue;
+        }
+        int size = 0;
+        int prev = ws->childLinks[s][1], cur = s;
+        do {
+            ws->visitStamp[cur] = ws->stamp;
+            ws->subtourOf[cur] = numSubtours;
+            size++;
+            int next = ws->childLinks[cur][0] != prev ? ws->childLinks[cur][0] : ws->childLinks[cur][1];
+            prev = cur;
+            cur = next;
+        } while (cur != s);
+        ws->subtourHead[numSubtours] = s;
+        ws->subtourSize[numSubtours] = size;
+        numSubtours++;
+    }
+    return numSubtours;
+}
+
+// Joins the subtours of childLinks into one tour, smallest subtour first. Each merge
+// removes an edge (u, u2) of the subtour and an edge (v, v2) of another one and
+// reconnects the four ends in the cheaper way, with v taken from the candidate
+// neighbors of u (or from all cities if none lies outside the subtour). Returns the
+// length change.
+double eaxMergeSubtours(struct Graph *graph, struct EAXWorkspace *ws, int numSubtours) {
+    double total = 0.0;
+    int n = graph->numNodes;
+    int live = numSubtours;
+    while (live > 1) {
+        int small = -1;
+        for (int t = 0; t < numSubtours; t++) {
+            if (ws->subtourSize[t] > 0 && (small < 0 || ws->subtourSize[t] < ws->subtourSize[small])) {
+                small = t;
+            }
+        }
+
+        int size = 0;
+        int prev = ws->childLinks[ws->subtourHead[small]][1], cur = ws->subtourHead[small];
+        do {
+            ws->members[size++] = cur;
+            int next = ws->childLinks[cur][0] != prev ? ws->childLinks[cur][0] : ws->childLinks[cur][1];
+            prev = cur;
+            cur = next;
+        } while (cur != ws->subtourHead[small]);
+
+        double bestDelta = DBL_MAX;
+        int bestU = -1, bestU2 = -1, bestV = -1, bestV2 = -1;
+        bool crossed = false;
+        for (int pass = 0; pass < 2 && bestU < 0; pass++) {
+            // The second pass looks at every other city
+            int limit = pass == 0 ? ws->candidates.count : n;
+            for (int m = 0; m < size; m++) {
+                int u = ws->members[m];
+                for (int c = 0; c < limit; c++) {
+                    int v = pass == 0 ? ws->candidates.neighbors[u][c] : c;
+                    if (ws->subtourOf[v] == small) {
+                        continue;
+                    }
+                    double uv = calculateDistance(graph->nodes[u], graph->nodes[v]);
+                    for (int s = 0; s < 2; s++) {
+                        int u2 = ws->childLinks[u][s];
+                        double removed = calculateDistance(graph->nodes[u], graph->nodes[u2]);
+                        for (int t = 0; t < 2; t++) {
+                            int v2 = ws->childLinks[v][t];
+                            double base = uv - removed - calculateDistance(graph->nodes[v], graph->nodes[v2]);
+                            double straight = base + calculateDistance(graph->nodes[u2], graph->nodes[v2]);
+                            if (straight < bestDelta) {
+                                bestDelta = straight;
+                                bestU = u, bestU2 = u2, bestV = v, bestV2 = v2;
+                                crossed = false;
+                            }
+                            // Or connect u to v2 and u2 to v instead
+                            double other = calculateDistance(graph->nodes[u], graph->nodes[v2]) - uv + base
+                                           + calculateDistance(graph->nodes[u2], graph->nodes[v]);
+                            if (other < bestDelta) {
+                                bestDelta = other;
+                                bestU = u, bestU2 = u2, bestV = v, bestV2 = v2;
+                                crossed = true;
+                            }
+                        }
+                    }
+                }
+            }
+        }
+
+        int v = crossed ? bestV2 : bestV;
+        int v2 = crossed ? bestV : bestV2;
+        eaxReplaceLink(ws->childLinks, bestU, bestU2, v);
+        eaxReplaceLink(ws->childLinks, bestU2, bestU, v2);
+        eaxReplaceLink(ws->childLinks, v, v2, bestU);
+        eaxReplaceLink(ws->childLinks, v2, v, bestU2);
+        eaxMarkModified(ws, bestU);
+        eaxMarkModified(ws, bestU2);
+        eaxMarkModified(ws, bestV);
+        eaxMarkModified(ws, bestV2);
+        total += bestDelta;
+
+        int target = ws->subtourOf[bestV];
+        for (int m = 0; m < size; m++) {
+            ws->subtourOf[ws->members[m]] = target;
+        }
+        ws->subtourSize[target] += size;
+        ws->subtourSize[small] = 0;
+        live--;
+    }
+    return total;
+}
+
+// Change of the population's edge entropy if childLinks replaced parent A
+double eaxEntropyChange(struct EAXWorkspace *ws, int (*linksA)[2], int numNodes) {
+    double change = 0.0;
+    for (int m = 0; m < ws->numModified; m++) {
+        int v = ws->modified[m];
+        for (int s = 0; s < 2; s++) {
+            int u = linksA[v][s];
+            if (v < u && !eaxHasLink(ws->childLinks, v, u)) {
+                int f = ws->edgeFrequency[eaxEdgeIndex(v, u, numNodes)];
+                change += ws->entropyTerm[f - 1] - ws->entropyTerm[f];
+            }
+            u = ws->childLinks[v][s];
+            if (v < u && !eaxHasLink(linksA, v, u)) {
+                int f = ws->edgeFrequency[eaxEdgeIndex(v, u, numNodes)];
+                change += ws->entropyTerm[f + 1] - ws->entropyTerm[f];
+            }
+        }
+    }
+    return change;
+}
+
+// Adds (sign = 1) or removes (sign = -1) the edges of a tour to the frequency table
+void eaxCountEdges(struct EAXWorkspace *ws, int (*links)[2], int numNodes, int sign) {
+    for (int v = 0; v < numNodes; v++) {
+        for (int s = 0; s < 2; s++) {
+            if (v < links[v][s]) {
+                ws->edgeFrequency[eaxEdgeIndex(v, links[v][s], numNodes)] += sign;
+            }
+        }
+    }
+}
+
+// Crossover of members a and b. Generates up to EAX_CHILDREN offspring and replaces a
+// by the one that maximizes length gain per unit of entropy lost (any gain counts when
+// entropy does not drop). Returns true if a was replaced.
+bool eaxCrossover(struct Graph *graph, struct EAXPopulation *pop, int a, int b, int strategy, struct EAXWorkspace *ws,
+                  struct Rng *rng) {
+    int n = graph->numNodes;
+    int (*linksA)[2] = pop->links[a];
+    eaxBuildABCycles(graph, linksA, pop->links[b], ws, rng);
+    if (ws->numCycles == 0) {
+        return false;
+    }
+
+    for (int c = 0; c < ws->numCycles; c++) {
+        ws->order[c] = c;
+    }
+    int numChildren = strategy == EAX_SINGLE && ws->numCycles < EAX_CHILDREN ? ws->numCycles : EAX_CHILDREN;
+
+    double bestScore = 0.0, bestLength = 0.0;
+    for (int child = 0; child < numChildren; child++) {
+        memcpy(ws->childLinks, linksA, n * sizeof(ws->childLinks[0]));
+        ws->stamp++;
+        ws->numModified = 0;
+
+        double delta = 0.0;
+        if (strategy == EAX_SINGLE) {
+            // Partial Fisher-Yates: every child gets a different cycle
+            int j = child + rngInt(rng, ws->numCycles - child);
+            int c = ws->order[j];
+            ws->order[j] = ws->order[child];
+            ws->order[child] = c;
+            eaxApplyCycle(ws, c);
+            delta += ws->cycleDelta[c];
+        } else {
+            for (int c = 0; c < ws->numCycles; c++) {
+                if (rngNext(rng) >> 63) {
+                    eaxApplyCycle(ws, c);
+                    delta += ws->cycleDelta[c];
+                }
+            }
+            if (ws->numModified == 0) {
+                continue;
+            }
+        }
+
+        int numSubtours = eaxLabelSubtours(ws);
+        delta += eaxMergeSubtours(graph, ws, numSubtours);
+        if (delta > -1e-9) {
+            continue;
+        }
+
+        double entropyLoss = -eaxEntropyChange(ws, linksA, n);
+        double score = entropyLoss > 1e-12 ? -delta / entropyLoss : -delta / 1e-12;
+        if (score > bestScore) {
+            bestScore = score;
+            bestLength = pop->length[a] + delta;
+            memcpy(ws->bestLinks, ws->childLinks, n * sizeof(ws->bestLinks[0]));
+        }
+    }
+
+    if (bestScore <= 0.0) {
+        return false;
+    }
+    eaxCountEdges(ws, linksA, n, -1);
+    memcpy(linksA, ws->bestLinks, n * sizeof(ws->bestLinks[0]));
+    eaxCountEdges(ws, linksA, n, 1);
+    pop->length[a] = bestLength;
+    return true;
+}
+
+void eaxLinksToTour(int (*links)[2], int numNodes, int *tour) {
+    int prev = links[0][1], cur = 0;
+    for (int i = 0; i < numNodes; i++) {
+        tour[i] = cur;
+        int next = links[cur][0] != prev ? links[cur][0] : links[cur][1];
+        prev = cur;
+        cur = next;
+    }
+}
+
+void eaxAlgorithm(struct EAXContext *ctx, struct Graph *graph, int *tour) {
+    int n = graph->numNodes;
+    unsigned long long seed = ctx->seed;
+    double deadline = ctx->timeLimit > 0.0 ? currentTimeSeconds() + ctx->timeLimit : 0.0;
+    struct EAXWorkspace *ws = ctx->workspace;
+    traceStart(ctx->trace, calculateTourLength(graph, tour));
+    runBegin(ctx->control);
+
+    // Too few cities for AB-cycles to be of any use: keep the polished tour
+    if (n < 8) {
+        buildSpatialGrid(graph, ctx->grid);
+        buildCandidateList(graph, ctx->grid, &ws->candidates, n - 1);
+        polishTour(graph, &ws->candidates, tour, ctx->control);
+        double length = calculateTourLength(graph, tour);
+        traceImprove(ctx->trace, length, 0);
+        runEnd(ctx->control, length, 0);
+        return;
+    }
+
+    // Initial population: 2-opt / Or-opt local optima of random tours and of the tour
+    // passed in, built in parallel
+    struct EAXPopulation *pop = ctx->population;
+    int (*members)[MAX_NODES] = ctx->members;
+    struct RunControl buildControl;
+    runPhaseBegin(&buildControl, ctx->control, deadline);
+    buildPopulation(graph, members, EAX_POPULATION_SIZE, INIT_RANDOM_TWO_OPT, ctx->initThreads, true, seed, tour, &buildControl);
+    pop->size = EAX_POPULATION_SIZE;
+    for (int m = 0; m < pop->size; m++) {
+        for (int i = 0; i < n; i++) {
+            pop->links[m][members[m][i]][0] = members[m][(i - 1 + n) % n];
+            pop->links[m][members[m][i]][1] = members[m][(i + 1) % n];
+        }
+        pop->length[m] = calculateTourLength(graph, members[m]);
+    }
+
+    int best = 0;
+    for (int m = 1; m < pop->size; m++) {
+        if (pop->length[m] < pop->length[best]) {
+            best = m;
+        }
+    }
+    traceImprove(ctx->trace, pop->length[best], 0);
+
+    // A build cut short leaves no time for generations, nor for their setup below
+    if (atomic_load(&buildControl.status) != RUN_RUNNING) {
+        runShouldStop(ctx->control, pop->length[best]);   // Records the reason in the run's control
+        memcpy(tour, members[best], n * sizeof(int));
+        runEnd(ctx->control, pop->length[best], 0);
+        return;
+    }
+
+    size_t numEdges = (size_t) n * n;
+    if (numEdges > ctx->edgeCapacity) {
+        free(ws->edgeFrequency);
+        ws->edgeFrequency = malloc(numEdges * sizeof(unsigned short));
+        ctx->edgeCapacity = numEdges;
+    }
+    memset(ws->edgeFrequency, 0, numEdges * sizeof(unsigned short));
+    ws->stamp = 0;
+    for (int v = 0; v < n; v++) {
+        ws->modifiedStamp[v] = 0;
+        ws->visitStamp[v] = 0;
+    }
+    for (int f = 0; f <= pop->size + 1; f++) {
+        double p = (double) f / pop->size;
+        ws->entropyTerm[f] = f == 0 ? 0.0 : -p * log(p);
+    }
+    for (int m = 0; m < pop->size; m++) {
+        eaxCountEdges(ws, pop->links[m], n, 1);
+    }
+    buildSpatialGrid(graph, ctx->grid);
+    buildCandidateList(graph, ctx->grid, &ws->candidates, EAX_MERGE_CANDIDATES);
+
+    struct Rng rng;
+    rngSeed(&rng, seed ^ 0x9E3779B97F4A7C15ULL);
+
+    int order[EAX_POPULATION_SIZE];
+    int stagnation = 0;
+    long long generation = 0;
+    while (stagnation < EAX_STAGNATION_GENERATIONS && (deadline == 0.0 || currentTimeSeconds() < deadline) &&
+           !runShouldStop(ctx->control, pop->length[best])) {
+        // Pair every member with its successor on a random cycle through the population
+        for (int m = 0; m < pop->size; m++) {
+            order[m] = m;
+        }
+        for (int m = pop->size - 1; m > 0; m--) {
+            int j = rngInt(&rng, m + 1);
+            int temp = order[m];
+            order[m] = order[j];
+            order[j] = temp;
+        }
+
+        generation++;
+        double previousBest = pop->length[best];
+        bool changed = false;
+        for (int m = 0; m < pop->size; m++) {
+            int a = order[m];
+            if (eaxCrossover(graph, pop, a, order[(m + 1) % pop->size], ctx->strategy, ws, &rng)) {
+                changed = true;
+                if (pop->length[a] < pop->length[best]) {
+                    best = a;
+                }
+            }
+        }
+
+        // A population whose members no longer produce better offspring has converged
+        if (!changed) {
+            break;
+        }
+        traceImprove(ctx->trace, pop->length[best], generation);
+        stagnation = pop->length[best] < previousBest - 1e-9 ? 0 : stagnation + 1;
+    }
+
+    eaxLinksToTour(pop->links[best], n, tour);
+    runEnd(ctx->control, pop->length[best], generation);
+}
+
+#endif
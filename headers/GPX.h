@@ -3,13 +3,106 @@
 #ifndef GPX_H
 #define GPX_H
 
+#include <pthread.h>
+#include <stdatomic.h>
+
 #define POPULATION_SIZE 50
 #define MAX_GENERATIONS 1000
+#define GPX_STAGNATION_GENERATIONS 1000   // Stop after this many generations without a new best
 #define THRESHOLD_FITNESS 0.01
 
+// Population construction methods
+#define INIT_NEAREST_NEIGHBOR 0    // Randomized nearest neighbor on the spatial grid
+#define INIT_GREEDY_EDGE 1         // Greedy edge matching with randomly perturbed lengths
+#define INIT_SPACE_FILLING_CURVE 2 // Hilbert curve order of jittered coordinates
+#define INIT_RANDOM_TWO_OPT 3      // Random permutation
+#define INIT_MIXED 4               // Cycle through the four methods member by member
+
+// Steady-state replacement policies; the offspring only ever replaces a worse member
+#define REPLACE_WORST 0          // The worst member of the population
+#define REPLACE_TOURNAMENT 1     // The worst of GPX_TOURNAMENT_SIZE random members
+#define REPLACE_WORSE_PARENT 2   // The worse of the two parents
+
+#define GPX_TOURNAMENT_SIZE 4
+
+// Island model: sub-populations evolve on their own threads and send their best tour to
+// other islands every migrationInterval generations
+#define TOPOLOGY_RING 0     // Island i sends to island i + 1
+#define TOPOLOGY_RANDOM 1   // Island i sends to a random other island
+
+#define MIGRATION_QUEUE_CAPACITY 4
+
+// Final phase over the elite members of the population
+#define FINAL_NONE 0       // Return the best member
+#define FINAL_BACKBONE 1   // Search the instance reduced by the edges all elites share (BACKBONE.h)
+#define FINAL_MERGE 2      // Best tour in the union of the elites (MERGE.h), backbone search if too wide
 
-// Assuming you have a population array declared globally or passed as a parameter to the functions
-int population[POPULATION_SIZE][MAX_NODES];
+// Population with cached fitness values. The heap keeps member indices ordered by
+// fitness with the worst member on top, so finding and replacing it is O(log P).
+// Members also carry their tour hash, so duplicates are found without comparing tours.
+struct Population {
+    int size;
+    int tours[POPULATION_SIZE][MAX_NODES];
+    double fitness[POPULATION_SIZE];   // Tour length of each member, updated only when it changes
+    unsigned long long hash[POPULATION_SIZE];
+    int heap[POPULATION_SIZE];         // Max-heap of member indices by fitness
+    int heapIndex[POPULATION_SIZE];    // Position of each member in heap[]
+    int best;                          // Index of the fittest member
+};
+
+// Parameters, seed, statistics and populations of GPX runs. The populations are
+// allocated once (islands on first use) and reused across runs and instances.
+// Concurrent runs need a context each.
+struct GPXContext {
+    int initMethod;
+    int initThreads;          // Threads building the population (0 = one per online core)
+    bool polishPopulation;    // Run the candidate 2-opt / Or-opt descent on every member
+    int replacement;
+    int maxGenerations;
+    double timeLimit;         // Wall-clock budget in seconds (0 = generations only)
+    int islands;              // Number of islands (0 = one per online core, 1 = single population)
+    int migrationInterval;    // Generations between migrations
+    int topology;
+    int finalPhase;
+    int finalTrials;          // Shake + repair trials of the final phase (0 = 50 per reduced city)
+    unsigned long long seed;  // Base seed of the member RNG streams
+    struct Trace *trace;      // Convergence trace (NULL = none), iterations counted in crossovers
+    struct RunControl *control;   // Deadline, target and cancellation (NULL = none)
+
+    atomic_llong totalPartitions;   // Feasible partitions found by the last run
+    atomic_llong crossoverCount;    // Crossovers performed by the last run
+
+    struct Population *population;  // Single-population runs
+    struct Population *islandPopulations;
+    int islandCapacity;
+};
+
+void gpxContextInit(struct GPXContext *ctx) {
+    ctx->initMethod = INIT_MIXED;
+    ctx->initThreads = 0;
+    ctx->polishPopulation = true;
+    ctx->replacement = REPLACE_WORST;
+    ctx->maxGenerations = MAX_GENERATIONS;
+    ctx->timeLimit = 0.0;
+    ctx->islands = 0;
+    ctx->migrationInterval = 50;
+    ctx->topology = TOPOLOGY_RING;
+    ctx->finalPhase = FINAL_BACKBONE;
+    ctx->finalTrials = 0;
+    ctx->seed = 1;
+    ctx->trace = NULL;
+    ctx->control = NULL;
+    atomic_init(&ctx->totalPartitions, 0);
+    atomic_init(&ctx->crossoverCount, 0);
+    ctx->population = malloc(sizeof(struct Population));
+    ctx->islandPopulations = NULL;
+    ctx->islandCapacity = 0;
+}
+
+void gpxContextFree(struct GPXContext *ctx) {
+    free(ctx->islandPopulations);
+    free(ctx->population);
+}
 
 double evaluateFitness(struct Graph *graph, int *tour) {
     double tourLength = calculateTourLength(graph, tour);
@@ -18,142 +111,696 @@ double evaluateFitness(struct Graph *graph, int *tour) {
     return tourLength;
 }
 
-void gpcxCrossover(struct Graph *graph, int *parent1, int *parent2, int *offspring1, int *offspring2) {
-    int numNodes = graph->numNodes;
+void populationHeapSwap(struct Population *pop, int i, int j) {
+    int temp = pop->heap[i];
+    pop->heap[i] = pop->heap[j];
+    pop->heap[j] = temp;
+    pop->heapIndex[pop->heap[i]] = i;
+    pop->heapIndex[pop->heap[j]] = j;
+}
+
+void populationSiftUp(struct Population *pop, int i) {
+    while (i > 0) {
+        int parent = (i - 1) / 2;
+        if (pop->fitness[pop->heap[parent]] >= pop->fitness[pop->heap[i]]) {
+            break;
+        }
+        populationHeapSwap(pop, i, parent);
+        i = parent;
+    }
+}
+
+void populationSiftDown(struct Population *pop, int i) {
+    while (true) {
+        int largest = i;
+        int left = 2 * i + 1, right = 2 * i + 2;
+        if (left < pop->size && pop->fitness[pop->heap[left]] > pop->fitness[pop->heap[largest]]) {
+            largest = left;
+        }
+        if (right < pop->size && pop->fitness[pop->heap[right]] > pop->fitness[pop->heap[largest]]) {
+            largest = right;
+        }
+        if (largest == i) {
+            break;
+        }
+        populationHeapSwap(pop, i, largest);
+        i = largest;
+    }
+}
+
+// Evaluates every member once and builds the heap
+void populationInit(struct Population *pop, struct Graph *graph, int size) {
+    pop->size = size;
+    pop->best = 0;
+    for (int m = 0; m < size; m++) {
+        pop->fitness[m] = evaluateFitness(graph, pop->tours[m]);
+        pop->hash[m] = tourHash(pop->tours[m], graph->numNodes);
+        pop->heap[m] = m;
+        pop->heapIndex[m] = m;
+        if (pop->fitness[m] < pop->fitness[pop->best]) {
+            pop->best = m;
+        }
+    }
+    for (int i = size / 2 - 1; i >= 0; i--) {
+        populationSiftDown(pop, i);
+    }
+}
 
-    // Step 1: Initialize helper arrays and variables
-    bool marked[numNodes];
+int populationWorst(struct Population *pop) {
+    return pop->heap[0];
+}
+
+// Whether some member has the given tour hash
+bool populationContains(struct Population *pop, unsigned long long hash) {
+    for (int m = 0; m < pop->size; m++) {
+        if (pop->hash[m] == hash) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Overwrites member m with a tour of known fitness and hash and restores the heap
+void populationReplace(struct Population *pop, int m, int *tour, double fitness, unsigned long long hash, int numNodes) {
+    memcpy(pop->tours[m], tour, numNodes * sizeof(int));
+    pop->hash[m] = hash;
+    double old = pop->fitness[m];
+    pop->fitness[m] = fitness;
+    if (fitness > old) {
+        populationSiftUp(pop, pop->heapIndex[m]);
+    } else {
+        populationSiftDown(pop, pop->heapIndex[m]);
+    }
+
+    if (fitness < pop->fitness[pop->best]) {
+        pop->best = m;
+    } else if (m == pop->best && fitness > old) {
+        for (int i = 0; i < pop->size; i++) {
+            if (pop->fitness[i] < pop->fitness[pop->best]) {
+                pop->best = i;
+            }
+        }
+    }
+}
+
+// Copies the (up to) count fittest members into elites, best first. Returns how many.
+int populationElites(struct Population *pop, int (*elites)[MAX_NODES], int count, int numNodes) {
+    bool taken[POPULATION_SIZE] = {false};
+    if (count > pop->size) {
+        count = pop->size;
+    }
+    for (int e = 0; e < count; e++) {
+        int pick = -1;
+        for (int m = 0; m < pop->size; m++) {
+            if (!taken[m] && (pick < 0 || pop->fitness[m] < pop->fitness[pick])) {
+                pick = m;
+            }
+        }
+        taken[pick] = true;
+        memcpy(elites[e], pop->tours[pick], numNodes * sizeof(int));
+    }
+    return count;
+}
+
+// True if the run is neither stopped by its control nor past the solver's own deadline
+// (0 = none), so it may still spend time on the final phase
+bool populationMayFinish(struct RunControl *control, double deadline, double bestLength) {
+    return !runShouldStop(control, bestLength) && (deadline == 0.0 || currentTimeSeconds() < deadline);
+}
+
+// Replaces tour by the result of the final phase over the population's elites
+void populationFinalPhase(struct Graph *graph, struct Population *pop, int phase, int trials, int *tour, unsigned long long seed) {
+    int (*elites)[MAX_NODES] = malloc(BACKBONE_ELITES * sizeof(*elites));
+    if (phase == FINAL_MERGE) {
+        int numElites = populationElites(pop, elites, MERGE_MAX_TOURS, graph->numNodes);
+        mergeTours(graph, elites, numElites, tour, trials, seed, NULL);
+    } else if (phase == FINAL_BACKBONE) {
+        int numElites = populationElites(pop, elites, BACKBONE_ELITES, graph->numNodes);
+        backboneIntensify(graph, elites, numElites, tour, trials, seed);
+    }
+    free(elites);
+}
+
+// Picks the member the offspring should replace under the given policy, or -1 if the
+// offspring is not better than that member
+int populationReplacementSlot(struct Population *pop, int policy, int parent1Idx, int parent2Idx, double offspringFitness, struct Rng *rng) {
+    int slot;
+    if (policy == REPLACE_WORSE_PARENT) {
+        slot = pop->fitness[parent1Idx] > pop->fitness[parent2Idx] ? parent1Idx : parent2Idx;
+    } else if (policy == REPLACE_TOURNAMENT) {
+        slot = rngInt(rng, pop->size);
+        for (int t = 1; t < GPX_TOURNAMENT_SIZE; t++) {
+            int other = rngInt(rng, pop->size);
+            if (pop->fitness[other] > pop->fitness[slot]) {
+                slot = other;
+            }
+        }
+    } else {
+        slot = populationWorst(pop);
+    }
+    return offspringFitness < pop->fitness[slot] ? slot : -1;
+}
+
+// Fills adj[v] with the two tour neighbors of every city
+void tourAdjacency(int *tour, int numNodes, int (*adj)[2]) {
     for (int i = 0; i < numNodes; i++) {
-        marked[i] = false;
-        offspring1[i] = -1;
-        offspring2[i] = -1;
-    }
-
-    // Step 2: Choose the starting point randomly
-    int startNode = rand() % numNodes;
-    offspring1[0] = startNode;
-    offspring2[0] = startNode;
-    marked[startNode] = true;
-
-    // Step 3: Assign nodes to partitions in alternating order
-    int currNode1 = startNode;
-    int currNode2 = startNode;
-    bool isParent1Turn = true;
-
-    for (int i = 1; i < numNodes; i++) {
-        int nextNode;
-
-        if (isParent1Turn) {
-            // Find the unmarked node closest to currNode1 in parent2
-            int closestNode = -1;
-            double minDistance = -1;
-            for (int j = 0; j < numNodes; j++) {
-                if (!marked[j]) {
-                    double distance = calculateDistance(graph->nodes[parent1[currNode1]], graph->nodes[parent2[j]]);
-                    if (closestNode == -1 || distance < minDistance) {
-                        closestNode = j;
-                        minDistance = distance;
-                    }
-                }
+        adj[tour[i]][0] = tour[(i - 1 + numNodes) % numNodes];
+        adj[tour[i]][1] = tour[(i + 1) % numNodes];
+    }
+}
+
+int findRoot(int *parent, int v) {
+    while (parent[v] != v) {
+        parent[v] = parent[parent[v]];
+        v = parent[v];
+    }
+    return v;
+}
+
+// Generalized Partition Crossover. The union graph of the parents minus their shared
+// edges falls apart into components; a component that both parents enter and leave
+// exactly once (two portals, counting chains of shared edges as single edges) can take
+// either parent's path through it independently of the rest. The offspring takes the
+// shorter path in every such partition and the shorter parent on everything else, so it
+// is never longer than the better parent. Runs in O(n). Returns the number of feasible
+// partitions.
+int gpcxCrossover(struct Graph *graph, int *parent1, int *parent2, int *offspring) {
+    int numNodes = graph->numNodes;
+    int adj1[MAX_NODES][2], adj2[MAX_NODES][2];
+    int component[MAX_NODES];
+    bool shared1[MAX_NODES][2];   // Whether parent 1's edge adj1[v][s] is also in parent 2
+    bool active[MAX_NODES];       // Has at least one edge that is not shared
+    int portals[MAX_NODES];
+    double length1[MAX_NODES], length2[MAX_NODES];
+
+    tourAdjacency(parent1, numNodes, adj1);
+    tourAdjacency(parent2, numNodes, adj2);
+
+    // Step 1: mark shared edges and join the endpoints of every other edge
+    for (int v = 0; v < numNodes; v++) {
+        component[v] = v;
+        active[v] = false;
+        portals[v] = 0;
+        length1[v] = 0.0;
+        length2[v] = 0.0;
+    }
+    for (int v = 0; v < numNodes; v++) {
+        for (int s = 0; s < 2; s++) {
+            int u = adj1[v][s];
+            shared1[v][s] = adj2[v][0] == u || adj2[v][1] == u;
+            if (!shared1[v][s]) {
+                active[v] = true;
+                component[findRoot(component, u)] = findRoot(component, v);
             }
-            nextNode = closestNode;
-            marked[nextNode] = true;
-            currNode1 = nextNode;
-        } else {
-            // Find the unmarked node closest to currNode2 in parent1
-            int closestNode = -1;
-            double minDistance = -1;
-            for (int j = 0; j < numNodes; j++) {
-                if (!marked[j]) {
-                    double distance = calculateDistance(graph->nodes[parent2[currNode2]], graph->nodes[parent1[j]]);
-                    if (closestNode == -1 || distance < minDistance) {
-                        closestNode = j;
-                        minDistance = distance;
-                    }
-                }
+            int w = adj2[v][s];
+            if (adj1[v][0] != w && adj1[v][1] != w) {
+                component[findRoot(component, w)] = findRoot(component, v);
+            }
+        }
+    }
+    if (numNodes < 4) {
+        memcpy(offspring, parent1, numNodes * sizeof(int));
+        return 0;
+    }
+    for (int v = 0; v < numNodes; v++) {
+        component[v] = findRoot(component, v);
+    }
+
+    // Step 2: path length of each parent inside every component (each edge seen from both ends)
+    for (int v = 0; v < numNodes; v++) {
+        for (int s = 0; s < 2; s++) {
+            if (!shared1[v][s]) {
+                length1[component[v]] += 0.5 * calculateDistance(graph->nodes[v], graph->nodes[adj1[v][s]]);
+            }
+            int u = adj2[v][s];
+            if (adj1[v][0] != u && adj1[v][1] != u) {
+                length2[component[v]] += 0.5 * calculateDistance(graph->nodes[v], graph->nodes[u]);
+            }
+        }
+    }
+
+    // Step 3: count portals. A chain of shared edges through cities without any other edge
+    // counts as one edge between the active cities at its ends.
+    for (int v = 0; v < numNodes; v++) {
+        if (!active[v]) {
+            continue;
+        }
+        for (int s = 0; s < 2; s++) {
+            if (!shared1[v][s]) {
+                continue;
+            }
+            int prev = v, curr = adj1[v][s];
+            while (!active[curr]) {
+                int next = adj1[curr][0] == prev ? adj1[curr][1] : adj1[curr][0];
+                prev = curr;
+                curr = next;
+            }
+            if (component[curr] != component[v]) {
+                portals[component[v]]++;
+            }
+        }
+    }
+
+    // Step 4: choose a parent per feasible partition; infeasible components all go with
+    // whichever parent is shorter on them together
+    int partitions = 0;
+    double rest1 = 0.0, rest2 = 0.0;
+    for (int v = 0; v < numNodes; v++) {
+        if (active[v] && component[v] == v) {
+            if (portals[v] <= 2) {
+                partitions++;
+            } else {
+                rest1 += length1[v];
+                rest2 += length2[v];
             }
-            nextNode = closestNode;
-            marked[nextNode] = true;
-            currNode2 = nextNode;
         }
+    }
+    bool restFromParent2 = rest2 < rest1;
+
+    // Step 5: every city takes its neighbors from the parent chosen for its component
+    int (*pick[MAX_NODES])[2];
+    for (int v = 0; v < numNodes; v++) {
+        int c = component[v];
+        bool fromParent2 = (active[c] && portals[c] <= 2) ? length2[c] < length1[c] : restFromParent2;
+        pick[v] = fromParent2 ? &adj2[v] : &adj1[v];
+    }
+
+    int prev = -1, curr = 0;
+    for (int i = 0; i < numNodes; i++) {
+        offspring[i] = curr;
+        int next = (*pick[curr])[0] != prev ? (*pick[curr])[0] : (*pick[curr])[1];
+        prev = curr;
+        curr = next;
+    }
+    return partitions;
+}
+
+
+struct PopulationBuild {
+    struct Graph *graph;
+    struct SpatialGrid *grid;
+    struct CandidateList *candidates;
+    int (*members)[MAX_NODES];
+    int *startTour;       // Becomes member 0 when not NULL
+    int count;
+    int method;
+    int numThreads;
+    bool polish;          // Polish every member, not only random permutations
+    unsigned long long seed;
+    struct RunControl *control;   // Once it stops, the remaining members are copies of the start
+                                  // tour, or random tours without one
+};
 
-        // Assign the selected node to the offspring
-        if (isParent1Turn) {
-            offspring1[i] = nextNode;
+struct PopulationBuilder {
+    struct PopulationBuild *build;
+    int id;
+};
+
+// Builds member m from its own stream, so the result does not depend on which thread
+// builds it. gridCopy is scratch space for the nearest neighbor method.
+void buildPopulationMember(struct PopulationBuild *build, int m, struct SpatialGrid *gridCopy) {
+    struct Graph *graph = build->graph;
+    int *tour = build->members[m];
+    int method = build->method == INIT_MIXED ? m % INIT_MIXED : build->method;
+
+    struct Rng rng;
+    rngSeed(&rng, build->seed + (unsigned long long) m);
+
+    // No best length is known yet, so only the deadline and cancellation apply
+    if (runShouldStop(build->control, INFINITY)) {
+        if (build->startTour != NULL) {
+            memcpy(tour, build->startTour, graph->numNodes * sizeof(int));
         } else {
-            offspring2[i] = nextNode;
+            randomTour(graph->numNodes, &rng, tour);
+        }
+        return;
+    }
+
+    if (m == 0 && build->startTour != NULL) {
+        memcpy(tour, build->startTour, graph->numNodes * sizeof(int));
+    } else if (method == INIT_NEAREST_NEIGHBOR) {
+        memcpy(gridCopy, build->grid, sizeof(struct SpatialGrid));
+        randomizedNearestNeighborTour(graph, gridCopy, 0.9, &rng, tour);
+    } else if (method == INIT_GREEDY_EDGE) {
+        greedyEdgeTour(graph, build->candidates, 0.2, &rng, tour);
+    } else if (method == INIT_SPACE_FILLING_CURVE) {
+        spaceFillingCurveTour(graph, 0.5, &rng, tour);
+    } else {
+        randomTour(graph->numNodes, &rng, tour);
+    }
+
+    if (build->polish || method == INIT_RANDOM_TWO_OPT) {
+        polishTour(graph, build->candidates, tour, build->control);
+    }
+}
+
+void *populationBuilderThread(void *arg) {
+    struct PopulationBuilder *builder = arg;
+    struct PopulationBuild *build = builder->build;
+    struct SpatialGrid *gridCopy = malloc(sizeof(struct SpatialGrid));
+
+    for (int m = builder->id; m < build->count; m += build->numThreads) {
+        buildPopulationMember(build, m, gridCopy);
+    }
+
+    free(gridCopy);
+    return NULL;
+}
+
+// Fills members[0 .. count) with independently seeded tours built by 'method', spread
+// over numThreads threads. The grid and candidate lists are built once and shared
+// read-only. A startTour (may be NULL) is taken over, polished, as member 0. A control
+// (may be NULL, see runPhaseBegin) is polled between the steps of the build and inside
+// the polishing, and cuts it short, still leaving valid tours.
+void buildPopulation(struct Graph *graph, int (*members)[MAX_NODES], int count, int method, int numThreads, bool polish,
+                     unsigned long long seed, int *startTour, struct RunControl *control) {
+    if (numThreads <= 0) {
+        numThreads = availableCores();
+    }
+    if (numThreads > count) {
+        numThreads = count;
+    }
+
+    struct PopulationBuild build;
+    build.graph = graph;
+    build.grid = malloc(sizeof(struct SpatialGrid));
+    build.candidates = malloc(sizeof(struct CandidateList));
+    build.members = members;
+    build.startTour = startTour;
+    build.count = count;
+    build.method = method;
+    build.numThreads = numThreads;
+    build.polish = polish;
+    build.seed = seed;
+    build.control = control;
+    buildSpatialGrid(graph, build.grid);
+    if (!runShouldStop(control, INFINITY)) {
+        buildCandidateList(graph, build.grid, build.candidates, 8);
+    }
+
+    struct PopulationBuilder *builders = malloc(numThreads * sizeof(struct PopulationBuilder));
+    pthread_t *threads = malloc(numThreads * sizeof(pthread_t));
+    for (int t = 0; t < numThreads; t++) {
+        builders[t].build = &build;
+        builders[t].id = t;
+    }
+    if (numThreads == 1) {
+        populationBuilderThread(&builders[0]);
+    } else {
+        for (int t = 0; t < numThreads; t++) {
+            perfThreadCreate(&threads[t], NULL, populationBuilderThread, &builders[t]);
+        }
+        for (int t = 0; t < numThreads; t++) {
+            pthread_join(threads[t], NULL);
         }
+    }
+
+    free(threads);
+    free(builders);
+    free(build.candidates);
+    free(build.grid);
+}
 
-        // Switch the turn between parent1 and parent2
-        isParent1Turn = !isParent1Turn;
+// One steady-state generation: two random parents, GPX, and replacement of a worse member
+void gpxGeneration(struct GPXContext *ctx, struct Graph *graph, struct Population *pop, struct Rng *rng) {
+    // Selection: Choose two parent tours from the population
+    // For simplicity, you can randomly select two parents
+    int parent1Idx = rngInt(rng, pop->size);
+    int parent2Idx;
+    do {
+        parent2Idx = rngInt(rng, pop->size);
+    } while (parent2Idx == parent1Idx);
+
+    // Identical parents can only reproduce themselves
+    if (pop->hash[parent1Idx] == pop->hash[parent2Idx]) {
+        return;
+    }
+
+    // Crossover: Create the offspring tour by applying GPX on the two parents
+    int offspring[MAX_NODES];
+    int partitions = gpcxCrossover(graph, pop->tours[parent1Idx], pop->tours[parent2Idx], offspring);
+    atomic_fetch_add(&ctx->totalPartitions, partitions);
+    long long crossovers = atomic_fetch_add(&ctx->crossoverCount, 1) + 1;
+
+    // Without a feasible partition the offspring is a copy of the better parent
+    if (partitions > 0) {
+        // Duplicates are rejected, so the population keeps distinct tours
+        unsigned long long offspringHash = tourHash(offspring, graph->numNodes);
+        if (populationContains(pop, offspringHash)) {
+            return;
+        }
+        double offspringFitness = evaluateFitness(graph, offspring);
+
+        // Replacement: steady-state, the offspring only replaces a worse member
+        int slot = populationReplacementSlot(pop, ctx->replacement, parent1Idx, parent2Idx, offspringFitness, rng);
+        if (slot >= 0) {
+            populationReplace(pop, slot, offspring, offspringFitness, offspringHash, graph->numNodes);
+            traceImprove(ctx->trace, offspringFitness, crossovers);
+        }
     }
 }
 
+// Single-producer / single-consumer ring of migrant tours. The producer only writes
+// tail and the consumer only writes head, so neither side ever waits for the other;
+// a migrant that finds the queue full is dropped.
+struct MigrationQueue {
+    atomic_int head;
+    atomic_int tail;
+    double fitness[MIGRATION_QUEUE_CAPACITY];
+    unsigned long long hash[MIGRATION_QUEUE_CAPACITY];
+    int tours[MIGRATION_QUEUE_CAPACITY][MAX_NODES];
+};
 
-void gpcxAlgorithm(struct Graph *graph, int *tour) {
+bool migrationPush(struct MigrationQueue *queue, int *tour, double fitness, unsigned long long hash, int numNodes) {
+    int tail = atomic_load_explicit(&queue->tail, memory_order_relaxed);
+    int head = atomic_load_explicit(&queue->head, memory_order_acquire);
+    if (tail - head == MIGRATION_QUEUE_CAPACITY) {
+        return false;
+    }
+    int slot = tail % MIGRATION_QUEUE_CAPACITY;
+    memcpy(queue->tours[slot], tour, numNodes * sizeof(int));
+    queue->fitness[slot] = fitness;
+    queue->hash[slot] = hash;
+    atomic_store_explicit(&queue->tail, tail + 1, memory_order_release);
+    return true;
+}
+
+bool migrationPop(struct MigrationQueue *queue, int *tour, double *fitness, unsigned long long *hash, int numNodes) {
+    int head = atomic_load_explicit(&queue->head, memory_order_relaxed);
+    int tail = atomic_load_explicit(&queue->tail, memory_order_acquire);
+    if (head == tail) {
+        return false;
+    }
+    int slot = head % MIGRATION_QUEUE_CAPACITY;
+    memcpy(tour, queue->tours[slot], numNodes * sizeof(int));
+    *fitness = queue->fitness[slot];
+    *hash = queue->hash[slot];
+    atomic_store_explicit(&queue->head, head + 1, memory_order_release);
+    return true;
+}
+
+struct IslandModel {
+    struct GPXContext *ctx;
+    struct Graph *graph;
+    int numIslands;
+    int migrationInterval;
+    int topology;
+    double deadline;      // Absolute wall-clock time to stop evolving at (0 = none)
+    unsigned long long seed;
+    int *startTour;                   // Seeds island 0
+    struct Population *islands;
+    struct MigrationQueue **queues;   // queues[from * numIslands + to], NULL where unused
+};
+
+struct IslandWorker {
+    struct IslandModel *model;
+    int id;
+};
+
+void *islandThread(void *arg) {
+    struct IslandWorker *worker = arg;
+    struct IslandModel *model = worker->model;
+    struct GPXContext *ctx = model->ctx;
+    struct Graph *graph = model->graph;
+    struct Population *pop = &model->islands[worker->id];
     int numNodes = graph->numNodes;
+    int numIslands = model->numIslands;
+
+    struct Rng rng;
+    rngSeed(&rng, model->seed ^ ((unsigned long long) (worker->id + 1) * 0x9E3779B97F4A7C15ULL));
+
+    // Each island builds its own population on its own thread
+    struct RunControl buildControl;
+    runPhaseBegin(&buildControl, ctx->control, model->deadline);
+    buildPopulation(graph, pop->tours, POPULATION_SIZE, ctx->initMethod, 1, ctx->polishPopulation,
+                    model->seed + (unsigned long long) worker->id * 1000003ULL, worker->id == 0 ? model->startTour : NULL,
+                    &buildControl);
+    populationInit(pop, graph, POPULATION_SIZE);
+    traceImprove(ctx->trace, pop->fitness[pop->best], 0);
+
+    int migrant[MAX_NODES];
+    int stagnation = 0;
+    for (int generation = 1; generation <= ctx->maxGenerations && stagnation < GPX_STAGNATION_GENERATIONS; generation++) {
+        if ((model->deadline > 0.0 && currentTimeSeconds() >= model->deadline) ||
+            runShouldStop(ctx->control, pop->fitness[pop->best])) {
+            break;
+        }
+        double previousBest = pop->fitness[pop->best];
+        gpxGeneration(ctx, graph, pop, &rng);
 
-    for (int generation = 0; generation < MAX_GENERATIONS; generation++) {
-        // Evaluate the fitness of the current tour (calculate total tour length)
-        double tourLength = calculateTourLength(graph, tour);
-
-        // Selection: Choose two parent tours from the population based on their fitness
-        int parent1[MAX_NODES];
-        int parent2[MAX_NODES];
-        // For simplicity, you can randomly select two parents
-        int parent1Idx = rand() % POPULATION_SIZE;
-        int parent2Idx;
-        do {
-            parent2Idx = rand() % POPULATION_SIZE;
-        } while (parent2Idx == parent1Idx);
-
-        // Copy the selected parents to parent1 and parent2 arrays
-        for (int i = 0; i < numNodes; i++) {
-            parent1[i] = population[parent1Idx][i];
-            parent2[i] = population[parent2Idx][i];
-        }
-
-        // Crossover: Create two offspring tours by applying GPCX on parent1 and parent2
-        int offspring1[MAX_NODES];
-        int offspring2[MAX_NODES];
-        gpcxCrossover(graph, parent1, parent2, offspring1, offspring2);
-
-        // Evaluate the fitness of the offspring tours
-        double offspring1Length = evaluateFitness(graph, offspring1);
-        double offspring2Length = evaluateFitness(graph, offspring2);
-
-        // Replacement: Replace the least fit tours in the population with the offspring tours
-        int minFit1Idx = -1, minFit2Idx = -1;
-        double minFit1 = DBL_MAX, minFit2 = DBL_MAX;
-
-        for (int i = 0; i < POPULATION_SIZE; i++) {
-            double fitness = evaluateFitness(graph, population[i]);
-            if (fitness < minFit1) {
-                minFit2 = minFit1;
-                minFit2Idx = minFit1Idx;
-                minFit1 = fitness;
-                minFit1Idx = i;
-            } else if (fitness < minFit2) {
-                minFit2 = fitness;
-                minFit2Idx = i;
+        if (generation % model->migrationInterval == 0) {
+            // Emigrate: send the elite to the neighbor
+            int to = (worker->id + 1) % numIslands;
+            if (model->topology == TOPOLOGY_RANDOM) {
+                to = (worker->id + 1 + rngInt(&rng, numIslands - 1)) % numIslands;
+            }
+            migrationPush(model->queues[worker->id * numIslands + to], pop->tours[pop->best], pop->fitness[pop->best], pop->hash[pop->best], numNodes);
+
+            // Immigrate: whatever has arrived replaces the worst member if it is better
+            // and not already here
+            for (int from = 0; from < numIslands; from++) {
+                struct MigrationQueue *queue = model->queues[from * numIslands + worker->id];
+                double fitness;
+                unsigned long long hash;
+                while (queue != NULL && migrationPop(queue, migrant, &fitness, &hash, numNodes)) {
+                    int worst = populationWorst(pop);
+                    if (!populationContains(pop, hash) && fitness < pop->fitness[worst]) {
+                        populationReplace(pop, worst, migrant, fitness, hash, numNodes);
+                    }
+                }
             }
         }
+        // A new best, bred or immigrated, keeps the island evolving
+        stagnation = pop->fitness[pop->best] < previousBest - 1e-9 ? 0 : stagnation + 1;
+    }
+    return NULL;
+}
 
-        // Replace the two least fit tours with the offspring tours
-        for (int i = 0; i < numNodes; i++) {
-            population[minFit1Idx][i] = offspring1[i];
-            population[minFit2Idx][i] = offspring2[i];
+// Island-model GPX: numIslands sub-populations evolve in parallel and exchange elites
+// through lock-free queues. tour receives the best member of all islands.
+void gpxIslandAlgorithm(struct GPXContext *ctx, struct Graph *graph, int *tour, int numIslands, double deadline) {
+    if (numIslands > ctx->islandCapacity) {
+        free(ctx->islandPopulations);
+        ctx->islandPopulations = malloc(numIslands * sizeof(struct Population));
+        ctx->islandCapacity = numIslands;
+    }
+    int topology = ctx->topology;
+    struct IslandModel model;
+    model.ctx = ctx;
+    model.graph = graph;
+    model.numIslands = numIslands;
+    model.migrationInterval = ctx->migrationInterval > 0 ? ctx->migrationInterval : 1;
+    model.topology = topology;
+    model.deadline = deadline;
+    model.seed = ctx->seed;
+    model.startTour = tour;
+    model.islands = ctx->islandPopulations;
+    model.queues = malloc(numIslands * numIslands * sizeof(struct MigrationQueue *));
+
+    for (int from = 0; from < numIslands; from++) {
+        for (int to = 0; to < numIslands; to++) {
+            bool used = from != to && (topology == TOPOLOGY_RANDOM || to == (from + 1) % numIslands);
+            struct MigrationQueue *queue = NULL;
+            if (used) {
+                queue = malloc(sizeof(struct MigrationQueue));
+                atomic_init(&queue->head, 0);
+                atomic_init(&queue->tail, 0);
+            }
+            model.queues[from * numIslands + to] = queue;
         }
+    }
+
+    struct IslandWorker *workers = malloc(numIslands * sizeof(struct IslandWorker));
+    pthread_t *threads = malloc(numIslands * sizeof(pthread_t));
+    for (int i = 0; i < numIslands; i++) {
+        workers[i].model = &model;
+        workers[i].id = i;
+        perfThreadCreate(&threads[i], NULL, islandThread, &workers[i]);
+    }
+    for (int i = 0; i < numIslands; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    int bestIsland = 0;
+    for (int i = 1; i < numIslands; i++) {
+        struct Population *pop = &model.islands[i];
+        if (pop->fitness[pop->best] < model.islands[bestIsland].fitness[model.islands[bestIsland].best]) {
+            bestIsland = i;
+        }
+    }
+    struct Population *best = &model.islands[bestIsland];
+    memcpy(tour, best->tours[best->best], graph->numNodes * sizeof(int));
+    // An interrupted run returns at once
+    if (populationMayFinish(ctx->control, deadline, best->fitness[best->best])) {
+        populationFinalPhase(graph, best, ctx->finalPhase, ctx->finalTrials, tour, ctx->seed);
+    }
+    traceImprove(ctx->trace, calculateTourLength(graph, tour), atomic_load(&ctx->crossoverCount));
+
+    for (int q = 0; q < numIslands * numIslands; q++) {
+        free(model.queues[q]);
+    }
+    free(model.queues);
+    free(threads);
+    free(workers);
+}
+
+void gpcxAlgorithm(struct GPXContext *ctx, struct Graph *graph, int *tour) {
+    int numNodes = graph->numNodes;
+    unsigned long long seed = ctx->seed;
+    atomic_store(&ctx->totalPartitions, 0);
+    atomic_store(&ctx->crossoverCount, 0);
+    double deadline = ctx->timeLimit > 0.0 ? currentTimeSeconds() + ctx->timeLimit : 0.0;
+    traceStart(ctx->trace, calculateTourLength(graph, tour));
+    runBegin(ctx->control);
+
+    int numIslands = ctx->islands > 0 ? ctx->islands : availableCores();
+    if (numIslands > 1) {
+        gpxIslandAlgorithm(ctx, graph, tour, numIslands, deadline);
+        runEnd(ctx->control, calculateTourLength(graph, tour), atomic_load(&ctx->crossoverCount));
+        return;
+    }
+
+    // The tour passed in joins the population, so the run never ends worse than it started
+    struct Population *population = ctx->population;
+    struct RunControl buildControl;
+    runPhaseBegin(&buildControl, ctx->control, deadline);
+    buildPopulation(graph, population->tours, POPULATION_SIZE, ctx->initMethod, ctx->initThreads, ctx->polishPopulation,
+                    seed, tour, &buildControl);
+    populationInit(population, graph, POPULATION_SIZE);
+    traceImprove(ctx->trace, population->fitness[population->best], 0);
+
+    struct Rng rng;
+    rngSeed(&rng, seed ^ 0x9E3779B97F4A7C15ULL);
+
+    // A converged population only draws identical parents or partition-free pairs, so
+    // the run also ends once GPX_STAGNATION_GENERATIONS pass without a new best
+    int stagnation = 0;
+    for (int generation = 0; generation < ctx->maxGenerations && stagnation < GPX_STAGNATION_GENERATIONS; generation++) {
+        if ((deadline > 0.0 && currentTimeSeconds() >= deadline) ||
+            runShouldStop(ctx->control, population->fitness[population->best])) {
+            break;
+        }
+        double previousBest = population->fitness[population->best];
+        gpxGeneration(ctx, graph, population, &rng);
+        stagnation = population->fitness[population->best] < previousBest - 1e-9 ? 0 : stagnation + 1;
 
         // Termination condition (e.g., if a satisfactory solution is found)
         // For simplicity, we terminate if the best fitness reaches a threshold value
-        double bestFitness = fmin(minFit1, minFit2);
-        if (bestFitness < THRESHOLD_FITNESS) {
+        if (population->fitness[population->best] < THRESHOLD_FITNESS) {
             break;
         }
     }
 
+    // Return the best member of the final population
+    for (int i = 0; i < numNodes; i++) {
+        tour[i] = population->tours[population->best][i];
+    }
+    if (populationMayFinish(ctx->control, deadline, population->fitness[population->best])) {
+        populationFinalPhase(graph, population, ctx->finalPhase, ctx->finalTrials, tour, seed);
+    }
+    double length = calculateTourLength(graph, tour);
+    traceImprove(ctx->trace, length, atomic_load(&ctx->crossoverCount));
+    runEnd(ctx->control, length, atomic_load(&ctx->crossoverCount));
 }
 
 #endif
-
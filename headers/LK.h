@@ -4,7 +4,22 @@
 #ifndef LKH_H
 #define LKH_H
 
+// Parameters and trace of an LK run. Concurrent runs need a context each unless none
+// of them is traced.
+struct LKContext {
+    int maxIterations;     // Maximum number of iterations
+    struct Trace *trace;   // Convergence trace (NULL = none)
+    struct RunControl *control;   // Deadline, target and cancellation (NULL = none)
+};
+
+void lkContextInit(struct LKContext *ctx) {
+    ctx->maxIterations = 1000;
+    ctx->trace = NULL;
+    ctx->control = NULL;
+}
+
 void reverse(int *tour, int start, int end) {
+    PERF_ADD(elementsSwapped, end > start ? end - start + 1 : 0);
     while (start < end) {
         int temp = tour[start];
         tour[start] = tour[end];
@@ -14,31 +29,25 @@ void reverse(int *tour, int start, int end) {
     }
 }
 
-void lkhAlgorithm(struct Graph *graph, int *tour) {
-    int maxIterations = 1000;  // Set a maximum number of iterations
-
+void lkhAlgorithm(struct LKContext *ctx, struct Graph *graph, int *tour) {
+    int maxIterations = ctx->maxIterations;
 
     int n = graph->numNodes;
     int t1, t2, t3;
 
-    // Generate a random initial tour
-    for (int i = 0; i < n; i++) {
-        tour[i] = i;
-    }
-    for (int i = 0; i < n; i++) {
-        int j = rand() % n;
-        int temp = tour[i];
-        tour[i] = tour[j];
-        tour[j] = temp;
-    }
+    // Start from the tour passed in (see constructTour)
 
     double pathLength = calculateTourLength(graph, tour);
     double bestLength = pathLength;
-
+    traceStart(ctx->trace, pathLength);
+    runBegin(ctx->control);
 
     int i = 1;
     int iterations = 0;  // Counter for iterations
     while (iterations < maxIterations) {
+        if (runShouldStopEvery(ctx->control, iterations, bestLength)) {
+            break;
+        }
         t1 = i;
         // Step 3: Choose x1 = (t1,t2) ∈ T
         t2 = (t1 + 1) % n;
@@ -90,12 +99,15 @@ void lkhAlgorithm(struct Graph *graph, int *tour) {
         double newEdge1 = calculateDistance(graph->nodes[xi_a], graph->nodes[yi_a]);
         double newEdge2 = calculateDistance(graph->nodes[xi_b], graph->nodes[yi_b]);
         double deltaEnergy = (newEdge1 + newEdge2) - (originalEdge1 + originalEdge2);
+        PERF_COUNT(deltaEvals);
 
         if (deltaEnergy < 0) {
+            PERF_COUNT(movesAccepted);
             reverse(tour, t2, t2i);
             pathLength += deltaEnergy;
             if (pathLength < bestLength) {
                 bestLength = pathLength;
+                traceImprove(ctx->trace, bestLength, iterations);
                 for (int j = 0; j < n; j++) {
                     tour[j] = tour[(t1 + j) % n];
                 }
@@ -105,6 +117,7 @@ void lkhAlgorithm(struct Graph *graph, int *tour) {
             i = 1;
         } else {
             // Go back to Step 5 and try again
+            PERF_COUNT(movesRejected);
             i--;
         }
 
@@ -121,6 +134,7 @@ void lkhAlgorithm(struct Graph *graph, int *tour) {
             break;
         }
     }
+    runEnd(ctx->control, calculateTourLength(graph, tour), iterations);
 }
 
 
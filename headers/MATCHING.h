@@ -0,0 +1,535 @@
+// MATCHING.h - The header file for minimum-weight perfect matching of cities
+// contains Edmonds' weighted blossom algorithm and a greedy matching, both restricted to
+// the k-nearest candidate graph of the cities to match. Cities the candidate graph
+// leaves unmatched are paired greedily, nearest first, so the result is always perfect.
+
+#ifndef MATCHING_H
+#define MATCHING_H
+
+#define MATCHING_CANDIDATES 10      // Candidate neighbors per city
+#define BLOSSOM_MAX_VERTICES 1000   // Larger sets use the greedy matching (the blossom table is quadratic)
+
+// Matching methods
+#define MATCHING_BLOSSOM 0   // Minimum weight among the maximum matchings of the candidate graph
+#define MATCHING_GREEDY 1    // Shortest candidate edges first
+
+int matchingMethod = MATCHING_BLOSSOM;
+
+struct BlossomEdge {
+    int u;
+    int v;
+    long long w;   // 0 when there is no edge
+};
+
+// State of the O(n^3) primal-dual blossom algorithm for maximum-weight matching.
+// Vertices are 1 .. n, blossoms n + 1 .. 2n; 0 stands for "none". A blossom lists its
+// sub-blossoms in cycle order starting from its base.
+struct Blossom {
+    int n;
+    int numX;                // Highest vertex or blossom index in use
+    int stride;              // Row length of the edge table (2n + 1)
+    struct BlossomEdge *g;   // g[x * stride + y]: best original edge between x and y
+    long long *lab;          // Dual variables
+    int *match;
+    int *slack;
+    int *st;                 // Top-level blossom containing x
+    int *pa;
+    int *S;                  // 0 outer, 1 inner, -1 free
+    int *vis;
+    int visStamp;
+    int *flowerFrom;         // flowerFrom[b * (n + 1) + x]: sub-blossom of b containing vertex x
+    int *flower;             // flower[b * (n + 1) + i]: i-th sub-blossom of b
+    int *flowerSize;
+    int *queue;
+    int queueHead;
+    int queueTail;
+};
+
+struct BlossomEdge *blossomEdge(struct Blossom *bl, int x, int y) {
+    return &bl->g[x * bl->stride + y];
+}
+
+int *blossomFlower(struct Blossom *bl, int b) {
+    return &bl->flower[b * (bl->n + 1)];
+}
+
+long long blossomDelta(struct Blossom *bl, struct BlossomEdge *e) {
+    return bl->lab[e->u] + bl->lab[e->v] - 2 * e->w;
+}
+
+void blossomUpdateSlack(struct Blossom *bl, int u, int x) {
+    if (!bl->slack[x] || blossomDelta(bl, blossomEdge(bl, u, x)) < blossomDelta(bl, blossomEdge(bl, bl->slack[x], x))) {
+        bl->slack[x] = u;
+    }
+}
+
+void blossomSetSlack(struct Blossom *bl, int x) {
+    bl->slack[x] = 0;
+    for (int u = 1; u <= bl->n; u++) {
+        if (blossomEdge(bl, u, x)->w > 0 && bl->st[u] != x && bl->S[bl->st[u]] == 0) {
+            blossomUpdateSlack(bl, u, x);
+        }
+    }
+}
+
+void blossomPush(struct Blossom *bl, int x) {
+    if (x <= bl->n) {
+        bl->queue[bl->queueTail++] = x;
+        return;
+    }
+    int *flower = blossomFlower(bl, x);
+    for (int i = 0; i < bl->flowerSize[x]; i++) {
+        blossomPush(bl, flower[i]);
+    }
+}
+
+void blossomSetTop(struct Blossom *bl, int x, int b) {
+    bl->st[x] = b;
+    if (x > bl->n) {
+        int *flower = blossomFlower(bl, x);
+        for (int i = 0; i < bl->flowerSize[x]; i++) {
+            blossomSetTop(bl, flower[i], b);
+        }
+    }
+}
+
+void blossomReverse(int *a, int from, int to) {
+    for (to--; from < to; from++, to--) {
+        int temp = a[from];
+        a[from] = a[to];
+        a[to] = temp;
+    }
+}
+
+// Position of sub-blossom xr in b, with the cycle turned so that it is even
+int blossomEvenPosition(struct Blossom *bl, int b, int xr) {
+    int *flower = blossomFlower(bl, b);
+    int size = bl->flowerSize[b];
+    int pr = 0;
+    while (flower[pr] != xr) {
+        pr++;
+    }
+    if (pr % 2 == 1) {
+        blossomReverse(flower, 1, size);
+        return size - pr;
+    }
+    return pr;
+}
+
+void blossomSetMatch(struct Blossom *bl, int u, int v) {
+    struct BlossomEdge e = *blossomEdge(bl, u, v);
+    bl->match[u] = e.v;
+    if (u <= bl->n) {
+        return;
+    }
+    int xr = bl->flowerFrom[u * (bl->n + 1) + e.u];
+    int pr = blossomEvenPosition(bl, u, xr);
+    int *flower = blossomFlower(bl, u);
+    for (int i = 0; i < pr; i++) {
+        blossomSetMatch(bl, flower[i], flower[i ^ 1]);
+    }
+    blossomSetMatch(bl, xr, v);
+    // Rotate so that xr becomes the base
+    int size = bl->flowerSize[u];
+    blossomReverse(flower, 0, pr);
+    blossomReverse(flower, pr, size);
+    blossomReverse(flower, 0, size);
+}
+
+void blossomAugment(struct Blossom *bl, int u, int v) {
+    for (;;) {
+        int xnv = bl->st[bl->match[u]];
+        blossomSetMatch(bl, u, v);
+        if (!xnv) {
+            return;
+        }
+        blossomSetMatch(bl, xnv, bl->st[bl->pa[xnv]]);
+        u = bl->st[bl->pa[xnv]];
+        v = xnv;
+    }
+}
+
+int blossomLca(struct Blossom *bl, int u, int v) {
+    bl->visStamp++;
+    while (u || v) {
+        if (u) {
+            if (bl->vis[u] == bl->visStamp) {
+                return u;
+            }
+            bl->vis[u] = bl->visStamp;
+            u = bl->st[bl->match[u]];
+            if (u) {
+                u = bl->st[bl->pa[u]];
+            }
+        }
+        int temp = u;
+        u = v;
+        v = temp;
+    }
+    return 0;
+}
+
+void blossomAdd(struct Blossom *bl, int u, int lca, int v) {
+    int n = bl->n;
+    int b = n + 1;
+    while (b <= bl->numX && bl->st[b]) {
+        b++;
+    }
+    if (b > bl->numX) {
+        bl->numX++;
+    }
+    bl->lab[b] = 0;
+    bl->S[b] = 0;
+    bl->match[b] = bl->match[lca];
+
+    int *flower = blossomFlower(bl, b);
+    int size = 0;
+    flower[size++] = lca;
+    for (int x = u, y; x != lca; x = bl->st[bl->pa[y]]) {
+        flower[size++] = x;
+        flower[size++] = y = bl->st[bl->match[x]];
+        blossomPush(bl, y);
+    }
+    blossomReverse(flower, 1, size);
+    for (int x = v, y; x != lca; x = bl->st[bl->pa[y]]) {
+        flower[size++] = x;
+        flower[size++] = y = bl->st[bl->match[x]];
+        blossomPush(bl, y);
+    }
+    bl->flowerSize[b] = size;
+    blossomSetTop(bl, b, b);
+
+    for (int x = 1; x <= bl->numX; x++) {
+        blossomEdge(bl, b, x)->w = 0;
+        blossomEdge(bl, x, b)->w = 0;
+    }
+    for (int x = 1; x <= n; x++) {
+        bl->flowerFrom[b * (n + 1) + x] = 0;
+    }
+    for (int i = 0; i < size; i++) {
+        int xs = flower[i];
+        for (int x = 1; x <= bl->numX; x++) {
+            if (blossomEdge(bl, b, x)->w == 0 || blossomDelta(bl, blossomEdge(bl, xs, x)) < blossomDelta(bl, blossomEdge(bl, b, x))) {
+                *blossomEdge(bl, b, x) = *blossomEdge(bl, xs, x);
+                *blossomEdge(bl, x, b) = *blossomEdge(bl, x, xs);
+            }
+        }
+        for (int x = 1; x <= n; x++) {
+            if (bl->flowerFrom[xs * (n + 1) + x]) {
+                bl->flowerFrom[b * (n + 1) + x] = xs;
+            }
+        }
+    }
+    blossomSetSlack(bl, b);
+}
+
+// Dissolves the inner blossom b whose dual variable reached 0
+void blossomExpand(struct Blossom *bl, int b) {
+    int *flower = blossomFlower(bl, b);
+    int size = bl->flowerSize[b];
+    for (int i = 0; i < size; i++) {
+        blossomSetTop(bl, flower[i], flower[i]);
+    }
+    int xr = bl->flowerFrom[b * (bl->n + 1) + blossomEdge(bl, b, bl->pa[b])->u];
+    int pr = blossomEvenPosition(bl, b, xr);
+    for (int i = 0; i < pr; i += 2) {
+        int xs = flower[i], xns = flower[i + 1];
+        bl->pa[xs] = blossomEdge(bl, xns, xs)->u;
+        bl->S[xs] = 1;
+        bl->S[xns] = 0;
+        bl->slack[xs] = 0;
+        blossomSetSlack(bl, xns);
+        blossomPush(bl, xns);
+    }
+    bl->S[xr] = 1;
+    bl->pa[xr] = bl->pa[b];
+    for (int i = pr + 1; i < size; i++) {
+        int xs = flower[i];
+        bl->S[xs] = -1;
+        blossomSetSlack(bl, xs);
+    }
+    bl->st[b] = 0;
+}
+
+// Handles a tight edge out of an outer blossom. Returns true after an augmentation.
+bool blossomFoundEdge(struct Blossom *bl, struct BlossomEdge e) {
+    int u = bl->st[e.u], v = bl->st[e.v];
+    if (bl->S[v] == -1) {
+        bl->pa[v] = e.u;
+        bl->S[v] = 1;
+        int nu = bl->st[bl->match[v]];
+        bl->slack[v] = 0;
+        bl->slack[nu] = 0;
+        bl->S[nu] = 0;
+        blossomPush(bl, nu);
+    } else if (bl->S[v] == 0) {
+        int lca = blossomLca(bl, u, v);
+        if (!lca) {
+            blossomAugment(bl, u, v);
+            blossomAugment(bl, v, u);
+            return true;
+        }
+        blossomAdd(bl, u, lca, v);
+    }
+    return false;
+}
+
+// One search for an augmenting path, with dual updates in between. Returns false when
+// the matching is maximum.
+bool blossomPhase(struct Blossom *bl) {
+    int n = bl->n;
+    for (int x = 1; x <= bl->numX; x++) {
+        bl->S[x] = -1;
+        bl->slack[x] = 0;
+    }
+    bl->queueHead = bl->queueTail = 0;
+    for (int x = 1; x <= bl->numX; x++) {
+        if (bl->st[x] == x && !bl->match[x]) {
+            bl->pa[x] = 0;
+            bl->S[x] = 0;
+            blossomPush(bl, x);
+        }
+    }
+    if (bl->queueTail == 0) {
+        return false;
+    }
+
+    for (;;) {
+        while (bl->queueHead < bl->queueTail) {
+            int u = bl->queue[bl->queueHead++];
+            if (bl->S[bl->st[u]] == 1) {
+                continue;
+            }
+            for (int v = 1; v <= n; v++) {
+                struct BlossomEdge *e = blossomEdge(bl, u, v);
+                if (e->w > 0 && bl->st[u] != bl->st[v]) {
+                    if (blossomDelta(bl, e) == 0) {
+                        if (blossomFoundEdge(bl, *e)) {
+                            return true;
+                        }
+                    } else {
+                        blossomUpdateSlack(bl, u, bl->st[v]);
+                    }
+                }
+            }
+        }
+
+        long long d = LLONG_MAX;
+        for (int b = n + 1; b <= bl->numX; b++) {
+            if (bl->st[b] == b && bl->S[b] == 1 && bl->lab[b] / 2 < d) {
+                d = bl->lab[b] / 2;
+            }
+        }
+        for (int x = 1; x <= bl->numX; x++) {
+            if (bl->st[x] == x && bl->slack[x]) {
+                long long delta = blossomDelta(bl, blossomEdge(bl, bl->slack[x], x));
+                if (bl->S[x] == -1 && delta < d) {
+                    d = delta;
+                } else if (bl->S[x] == 0 && delta / 2 < d) {
+                    d = delta / 2;
+                }
+            }
+        }
+        // An outer vertex whose dual would drop to 0 ends the search: no augmenting path
+        for (int u = 1; u <= n; u++) {
+            if (bl->S[bl->st[u]] == 0 && bl->lab[u] <= d) {
+                return false;
+            }
+        }
+        for (int u = 1; u <= n; u++) {
+            if (bl->S[bl->st[u]] == 0) {
+                bl->lab[u] -= d;
+            } else if (bl->S[bl->st[u]] == 1) {
+                bl->lab[u] += d;
+            }
+        }
+        for (int b = n + 1; b <= bl->numX; b++) {
+            if (bl->st[b] == b) {
+                if (bl->S[b] == 0) {
+                    bl->lab[b] += 2 * d;
+                } else if (bl->S[b] == 1) {
+                    bl->lab[b] -= 2 * d;
+                }
+            }
+        }
+
+        bl->queueHead = bl->queueTail = 0;
+        for (int x = 1; x <= bl->numX; x++) {
+            if (bl->st[x] == x && bl->slack[x] && bl->st[bl->slack[x]] != x &&
+                blossomDelta(bl, blossomEdge(bl, bl->slack[x], x)) == 0) {
+                if (blossomFoundEdge(bl, *blossomEdge(bl, bl->slack[x], x))) {
+                    return true;
+                }
+            }
+        }
+        for (int b = n + 1; b <= bl->numX; b++) {
+            if (bl->st[b] == b && bl->S[b] == 1 && bl->lab[b] == 0) {
+                blossomExpand(bl, b);
+            }
+        }
+    }
+}
+
+// Maximum-weight matching of vertices 0 .. n - 1 under the symmetric weights w[i * n + j]
+// (0 = no edge). mate[i] receives the partner of i, or -1.
+void blossomMatching(int n, const long long *w, int *mate) {
+    struct Blossom bl;
+    int size = 2 * n + 1;
+    bl.n = n;
+    bl.numX = n;
+    bl.stride = size;
+    bl.g = malloc((size_t) size * size * sizeof(struct BlossomEdge));
+    bl.lab = calloc(size, sizeof(long long));
+    bl.match = calloc(size, sizeof(int));
+    bl.slack = calloc(size, sizeof(int));
+    bl.st = calloc(size, sizeof(int));
+    bl.pa = calloc(size, sizeof(int));
+    bl.S = calloc(size, sizeof(int));
+    bl.vis = calloc(size, sizeof(int));
+    bl.visStamp = 0;
+    bl.flowerFrom = calloc((size_t) size * (n + 1), sizeof(int));
+    bl.flower = calloc((size_t) size * (n + 1), sizeof(int));
+    bl.flowerSize = calloc(size, sizeof(int));
+    bl.queue = malloc(2 * size * sizeof(int));
+
+    long long maxWeight = 0;
+    for (int x = 0; x < size; x++) {
+        for (int y = 0; y < size; y++) {
+            struct BlossomEdge *e = blossomEdge(&bl, x, y);
+            e->u = x;
+            e->v = y;
+            e->w = x >= 1 && x <= n && y >= 1 && y <= n ? w[(x - 1) * n + (y - 1)] : 0;
+            if (e->w > maxWeight) {
+                maxWeight = e->w;
+            }
+        }
+    }
+    for (int x = 0; x <= n; x++) {
+        bl.st[x] = x;
+    }
+    for (int x = 1; x <= n; x++) {
+        bl.flowerFrom[x * (n + 1) + x] = x;
+        bl.lab[x] = maxWeight;
+    }
+
+    while (blossomPhase(&bl)) {
+    }
+
+    for (int x = 1; x <= n; x++) {
+        mate[x - 1] = bl.match[x] ? bl.match[x] - 1 : -1;
+    }
+
+    free(bl.queue);
+    free(bl.flowerSize);
+    free(bl.flower);
+    free(bl.flowerFrom);
+    free(bl.vis);
+    free(bl.S);
+    free(bl.pa);
+    free(bl.st);
+    free(bl.slack);
+    free(bl.match);
+    free(bl.lab);
+    free(bl.g);
+}
+
+struct MatchingEdge {
+    double length;
+    int a;
+    int b;
+};
+
+int compareMatchingEdges(const void *a, const void *b) {
+    double la = ((const struct MatchingEdge *) a)->length;
+    double lb = ((const struct MatchingEdge *) b)->length;
+    return (la > lb) - (la < lb);
+}
+
+// Perfect matching of the cities vertices[0 .. count), count even. mate[i] receives the
+// index (into vertices) of the partner of vertices[i].
+void minimumWeightMatching(struct Graph *graph, int *vertices, int count, int method, int *mate) {
+    for (int i = 0; i < count; i++) {
+        mate[i] = -1;
+    }
+    if (count < 2) {
+        return;
+    }
+
+    struct Graph *sub = malloc(sizeof(struct Graph));
+    struct SpatialGrid *grid = malloc(sizeof(struct SpatialGrid));
+    struct CandidateList *candidates = malloc(sizeof(struct CandidateList));
+    sub->numNodes = count;
+    for (int i = 0; i < count; i++) {
+        sub->nodes[i] = graph->nodes[vertices[i]];
+    }
+    buildSpatialGrid(sub, grid);
+    buildCandidateList(sub, grid, candidates, MATCHING_CANDIDATES);
+    free(grid);
+
+    if (method == MATCHING_BLOSSOM && count <= BLOSSOM_MAX_VERTICES) {
+        // Maximize sum(big - length): any extra matched pair outweighs all length
+        // differences, so the result is a maximum matching of minimum length
+        double maxLength = 1e-9;
+        for (int i = 0; i < count; i++) {
+            for (int m = 0; m < candidates->count; m++) {
+                maxLength = fmax(maxLength, calculateDistance(sub->nodes[i], sub->nodes[candidates->neighbors[i][m]]));
+            }
+        }
+        double scale = 1e9 / maxLength;
+        long long big = (long long) (count / 2 + 1) * 1000000000LL + 1;
+        long long *w = calloc((size_t) count * count, sizeof(long long));
+        for (int i = 0; i < count; i++) {
+            for (int m = 0; m < candidates->count; m++) {
+                int j = candidates->neighbors[i][m];
+                long long weight = big - llround(calculateDistance(sub->nodes[i], sub->nodes[j]) * scale);
+                w[i * count + j] = weight;
+                w[j * count + i] = weight;
+            }
+        }
+        blossomMatching(count, w, mate);
+        free(w);
+    } else {
+        int numEdges = 0;
+        struct MatchingEdge *edges = malloc(count * candidates->count * sizeof(struct MatchingEdge));
+        for (int i = 0; i < count; i++) {
+            for (int m = 0; m < candidates->count; m++) {
+                edges[numEdges].length = calculateDistance(sub->nodes[i], sub->nodes[candidates->neighbors[i][m]]);
+                edges[numEdges].a = i;
+                edges[numEdges].b = candidates->neighbors[i][m];
+                numEdges++;
+            }
+        }
+        qsort(edges, numEdges, sizeof(struct MatchingEdge), compareMatchingEdges);
+        for (int e = 0; e < numEdges; e++) {
+            if (mate[edges[e].a] < 0 && mate[edges[e].b] < 0) {
+                mate[edges[e].a] = edges[e].b;
+                mate[edges[e].b] = edges[e].a;
+            }
+        }
+        free(edges);
+    }
+
+    // Pair what the candidate graph could not match, nearest first
+    for (int i = 0; i < count; i++) {
+        if (mate[i] >= 0) {
+            continue;
+        }
+        int best = -1;
+        double bestDist = DBL_MAX;
+        for (int j = i + 1; j < count; j++) {
+            if (mate[j] < 0) {
+                double d = calculateDistance(sub->nodes[i], sub->nodes[j]);
+                if (d < bestDist) {
+                    bestDist = d;
+                    best = j;
+                }
+            }
+        }
+        mate[i] = best;
+        mate[best] = i;
+    }
+    free(candidates);
+    free(sub);
+}
+
+#endif
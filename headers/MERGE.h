@@ -0,0 +1,484 @@
+// MERGE.h - The header file for tour merging
+// Finds the shortest tour that only uses edges of k given tours and keeps the edges they
+// all share: those paths are contracted first (BACKBONE.h). The cities of the remaining
+// union graph are then swept in the order of the best tour, which gives a path
+// decomposition of the union graph, and a dynamic program keeps, for every way the
+// chosen edges can meet the frontier of the sweep, the cheapest partial solution. When
+// the frontier gets too wide the reduced instance is searched locally instead.
+
+#ifndef MERGE_H
+#define MERGE_H
+
+#define MERGE_MAX_TOURS 8
+#define MERGE_MAX_DEGREE (2 * MERGE_MAX_TOURS)
+#define MERGE_MAX_WIDTH 16               // Widest frontier the dynamic program accepts
+#define MERGE_MAX_STATES 65536           // Frontier states kept per step
+#define MERGE_TABLE_SIZE (2 * MERGE_MAX_STATES)
+#define MERGE_MAX_HISTORY (1 << 24)      // Back-pointers kept for rebuilding the tour
+#define MERGE_GREEDY_STARTS 8            // Start cities tried for greedy sweep orders
+
+// Frontier state. key[s] describes the frontier city in slot s: 0 = no chosen edge yet,
+// 1 = two chosen edges, 2 and up = end of a chosen path, labelled so that both ends of
+// a path share the label. closed is set once the tour has been closed.
+struct MergeState {
+    unsigned char key[MERGE_MAX_WIDTH];
+    unsigned char closed;
+    double cost;
+    int ref;                   // Back-pointer of the last edge decision, -1 before the first
+};
+
+struct MergeDP {
+    struct MergeState *cur;
+    struct MergeState *next;
+    int numCur;
+    int numNext;
+    int width;
+    int frontier[MERGE_MAX_WIDTH + 1];   // Reduced city in each slot
+    int *table;                          // Open addressing over next[], valid where tableStamp == stamp
+    int *tableStamp;
+    int stamp;
+    int *historyParent;                  // Per edge step and state: ref of the state it came from ...
+    unsigned char *historyTook;          // ... and whether the edge was taken
+    int historySize;
+    int historyCapacity;
+    int historyBase;                     // First history entry of the current edge step
+    bool overflow;
+};
+
+// Relabels the path ends in order of first appearance, so equal frontiers get equal keys
+void mergeCanonical(unsigned char *key, int width) {
+    unsigned char map[256] = {0};
+    unsigned char label = 2;
+    for (int s = 0; s < width; s++) {
+        if (key[s] >= 2) {
+            if (map[key[s]] == 0) {
+                map[key[s]] = label++;
+            }
+            key[s] = map[key[s]];
+        }
+    }
+}
+
+unsigned int mergeKeyHash(unsigned char *key, int width, unsigned char closed) {
+    unsigned int hash = 2166136261u ^ closed;
+    for (int s = 0; s < width; s++) {
+        hash = (hash ^ key[s]) * 16777619u;
+    }
+    return hash;
+}
+
+// Adds a state to the next step, keeping the cheaper of two equal frontiers
+void mergeAddState(struct MergeDP *dp, unsigned char *key, unsigned char closed, double cost, int parent, bool took) {
+    unsigned int slot = mergeKeyHash(key, dp->width, closed) & (MERGE_TABLE_SIZE - 1);
+    while (dp->tableStamp[slot] == dp->stamp) {
+        struct MergeState *state = &dp->next[dp->table[slot]];
+        if (state->closed == closed && memcmp(state->key, key, dp->width) == 0) {
+            if (cost < state->cost) {
+                state->cost = cost;
+                dp->historyParent[state->ref] = parent;
+                dp->historyTook[state->ref] = took;
+            }
+            return;
+        }
+        slot = (slot + 1) & (MERGE_TABLE_SIZE - 1);
+    }
+    if (dp->numNext == MERGE_MAX_STATES) {
+        dp->overflow = true;
+        return;
+    }
+
+    int index = dp->numNext++;
+    struct MergeState *state = &dp->next[index];
+    memcpy(state->key, key, dp->width);
+    state->closed = closed;
+    state->cost = cost;
+    state->ref = dp->historyBase + index;
+    dp->historyParent[state->ref] = parent;
+    dp->historyTook[state->ref] = took;
+    dp->tableStamp[slot] = dp->stamp;
+    dp->table[slot] = index;
+}
+
+// Decides the edge between the cities in slots a and b for every state. A fixed edge
+// must be taken; the tour may only be closed on the last city of the sweep.
+void mergeEdgeStep(struct MergeDP *dp, int a, int b, double length, bool fixed, bool lastCity) {
+    if (dp->historySize + MERGE_MAX_STATES > dp->historyCapacity) {
+        if (dp->historyCapacity >= MERGE_MAX_HISTORY) {
+            dp->overflow = true;
+            return;
+        }
+        dp->historyCapacity *= 2;
+        dp->historyParent = realloc(dp->historyParent, dp->historyCapacity * sizeof(int));
+        dp->historyTook = realloc(dp->historyTook, dp->historyCapacity * sizeof(unsigned char));
+    }
+    dp->historyBase = dp->historySize;
+    dp->numNext = 0;
+    dp->stamp++;
+
+    unsigned char key[MERGE_MAX_WIDTH];
+    for (int i = 0; i < dp->numCur && !dp->overflow; i++) {
+        struct MergeState *state = &dp->cur[i];
+        if (!fixed) {
+            mergeAddState(dp, state->key, state->closed, state->cost, state->ref, false);
+        }
+        unsigned char x = state->key[a], y = state->key[b];
+        if (state->closed || x == 1 || y == 1) {
+            continue;
+        }
+
+        memcpy(key, state->key, dp->width);
+        unsigned char closed = 0;
+        if (x == 0 && y == 0) {
+            key[a] = key[b] = 255; // A new path, relabelled below
+        } else if (x == 0) {
+            key[a] = y;
+            key[b] = 1;
+        } else if (y == 0) {
+            key[b] = x;
+            key[a] = 1;
+        } else if (x != y) {
+            // Two paths join: the far end of y's path takes x's label
+            key[a] = key[b] = 1;
+            for (int s = 0; s < dp->width; s++) {
+                if (key[s] == y) {
+                    key[s] = x;
+                }
+            }
+        } else {
+            // Both ends of one path: only the Hamiltonian cycle may close
+            bool complete = lastCity;
+            for (int s = 0; s < dp->width && complete; s++) {
+                complete = s == a || s == b || key[s] == 1;
+            }
+            if (!complete) {
+                continue;
+            }
+            key[a] = key[b] = 1;
+            closed = 1;
+        }
+        mergeCanonical(key, dp->width);
+        mergeAddState(dp, key, closed, state->cost + length, state->ref, true);
+    }
+
+    struct MergeState *temp = dp->cur;
+    dp->cur = dp->next;
+    dp->next = temp;
+    dp->numCur = dp->numNext;
+    dp->historySize += dp->numNext;
+}
+
+// Drops slot s from the frontier; its city must have two chosen edges by now
+void mergeForget(struct MergeDP *dp, int s) {
+    int kept = 0;
+    for (int i = 0; i < dp->numCur; i++) {
+        struct MergeState *state = &dp->cur[i];
+        if (state->key[s] != 1) {
+            continue;
+        }
+        memmove(&state->key[s], &state->key[s + 1], dp->width - s - 1);
+        dp->cur[kept++] = *state;
+    }
+    dp->numCur = kept;
+    for (int t = s; t < dp->width - 1; t++) {
+        dp->frontier[t] = dp->frontier[t + 1];
+    }
+    dp->width--;
+}
+
+// Largest frontier of a sweep that visits the cities in the order given by ord
+int mergeSweepWidth(int numNodes, int *ord, int *lastOrd) {
+    int change[MAX_NODES + 1];
+    for (int i = 0; i <= numNodes; i++) {
+        change[i] = 0;
+    }
+    for (int v = 0; v < numNodes; v++) {
+        change[ord[v]]++;
+        change[lastOrd[v] + 1]--;
+    }
+    int width = 0, widest = 0;
+    for (int i = 0; i < numNodes; i++) {
+        width += change[i];
+        if (width > widest) {
+            widest = width;
+        }
+    }
+    return widest;
+}
+
+// Greedy sweep order: from the start city, always introduce the city that leaves the
+// smallest frontier (preferring cities with more neighbors already swept). Writes the
+// order and returns its width.
+int mergeGreedyOrder(int numNodes, int (*adj)[MERGE_MAX_DEGREE], int *degree, int start, int *order) {
+    int swept[MAX_NODES];      // Neighbors already introduced
+    int remaining[MAX_NODES];  // Neighbors not yet introduced
+    bool done[MAX_NODES];
+    for (int v = 0; v < numNodes; v++) {
+        swept[v] = 0;
+        remaining[v] = degree[v];
+        done[v] = false;
+    }
+
+    int frontier = 0, widest = 0;
+    for (int i = 0; i < numNodes; i++) {
+        int pick = -1, pickSize = 0;
+        if (i == 0) {
+            pick = start;
+        } else {
+            for (int v = 0; v < numNodes; v++) {
+                if (done[v] || (swept[v] == 0 && pick >= 0)) {
+                    continue;
+                }
+                int size = frontier + (degree[v] > swept[v]);
+                for (int e = 0; e < degree[v]; e++) {
+                    int u = adj[v][e];
+                    size -= done[u] && remaining[u] == 1;
+                }
+                if (pick < 0 || (swept[pick] == 0 && swept[v] > 0) || size < pickSize ||
+                    (size == pickSize && swept[v] > swept[pick])) {
+                    pick = v;
+                    pickSize = size;
+                }
+            }
+        }
+
+        order[i] = pick;
+        done[pick] = true;
+        if (frontier + 1 > widest) {
+            widest = frontier + 1;
+        }
+        frontier += degree[pick] > swept[pick];
+        for (int e = 0; e < degree[pick]; e++) {
+            int u = adj[pick][e];
+            swept[u]++;
+            remaining[u]--;
+            if (done[u] && remaining[u] == 0) {
+                frontier--;
+            }
+        }
+    }
+    return widest;
+}
+
+// Runs the dynamic program over the union graph of the reduced instance. order is the
+// sweep order; tour receives the optimal reduced tour. Returns false if the state or
+// history limits were hit.
+bool mergeUnionGraph(struct ReducedProblem *reduced, int (*adj)[MERGE_MAX_DEGREE], int *degree, int *order, int *tour) {
+    struct Graph *graph = &reduced->graph;
+    int m = graph->numNodes;
+    int ord[MAX_NODES], lastOrd[MAX_NODES], slotOf[MAX_NODES];
+    for (int i = 0; i < m; i++) {
+        ord[order[i]] = i;
+    }
+    for (int v = 0; v < m; v++) {
+        lastOrd[v] = ord[v];
+        for (int e = 0; e < degree[v]; e++) {
+            if (ord[adj[v][e]] > lastOrd[v]) {
+                lastOrd[v] = ord[adj[v][e]];
+            }
+        }
+    }
+
+    struct MergeDP dp;
+    dp.cur = malloc(MERGE_MAX_STATES * sizeof(struct MergeState));
+    dp.next = malloc(MERGE_MAX_STATES * sizeof(struct MergeState));
+    dp.table = malloc(MERGE_TABLE_SIZE * sizeof(int));
+    dp.tableStamp = calloc(MERGE_TABLE_SIZE, sizeof(int));
+    dp.stamp = 0;
+    dp.historyCapacity = 4 * MERGE_MAX_STATES;
+    dp.historyParent = malloc(dp.historyCapacity * sizeof(int));
+    dp.historyTook = malloc(dp.historyCapacity * sizeof(unsigned char));
+    dp.historySize = 0;
+    dp.overflow = false;
+    dp.width = 0;
+    dp.numCur = 1;
+    dp.cur[0].closed = 0;
+    dp.cur[0].cost = 0.0;
+    dp.cur[0].ref = -1;
+
+    int numEdges = 0;
+    int (*edges)[2] = malloc(m * MERGE_MAX_DEGREE * sizeof(*edges));
+
+    for (int i = 0; i < m && !dp.overflow; i++) {
+        int v = order[i];
+        slotOf[v] = dp.width;
+        dp.frontier[dp.width] = v;
+        for (int s = 0; s < dp.numCur; s++) {
+            dp.cur[s].key[dp.width] = 0;
+        }
+        dp.width++;
+
+        for (int e = 0; e < degree[v] && !dp.overflow; e++) {
+            int u = adj[v][e];
+            if (ord[u] > i) {
+                continue;
+            }
+            bool fixed = reduced->partner[v] == u;
+            double length = fixed ? 0.0 : calculateDistance(graph->nodes[u], graph->nodes[v]);
+            mergeEdgeStep(&dp, slotOf[u], slotOf[v], length, fixed, i == m - 1);
+            edges[numEdges][0] = u;
+            edges[numEdges][1] = v;
+            numEdges++;
+        }
+
+        for (int s = dp.width - 1; s >= 0; s--) {
+            if (lastOrd[dp.frontier[s]] <= i) {
+                mergeForget(&dp, s);
+                for (int t = s; t < dp.width; t++) {
+                    slotOf[dp.frontier[t]] = t;
+                }
+            }
+        }
+    }
+
+    bool solved = !dp.overflow && dp.numCur > 0 && dp.cur[0].closed;
+    if (solved) {
+        // Walk the back-pointers and rebuild the chosen edges
+        int links[MAX_NODES][2];
+        int chosen[MAX_NODES];
+        for (int v = 0; v < m; v++) {
+            chosen[v] = 0;
+        }
+        int ref = dp.cur[0].ref;
+        for (int e = numEdges - 1; e >= 0; e--) {
+            if (dp.historyTook[ref]) {
+                int u = edges[e][0], v = edges[e][1];
+                links[u][chosen[u]++] = v;
+                links[v][chosen[v]++] = u;
+            }
+            ref = dp.historyParent[ref];
+        }
+
+        int prev = links[0][1], curr = 0;
+        for (int i = 0; i < m; i++) {
+            tour[i] = curr;
+            int next = links[curr][0] != prev ? links[curr][0] : links[curr][1];
+            prev = curr;
+            curr = next;
+        }
+    }
+
+    free(edges);
+    free(dp.historyTook);
+    free(dp.historyParent);
+    free(dp.tableStamp);
+    free(dp.table);
+    free(dp.next);
+    free(dp.cur);
+    return solved;
+}
+
+// Shortest tour that only uses edges of the given tours and keeps the edges all of them
+// share; tours[0] should be the best of them and at most MERGE_MAX_TOURS are used.
+// Returns true if the dynamic program found that tour; otherwise tour is the result of
+// searching the instance reduced by the shared edges ('trials' as in backboneIntensify).
+// Either way tour is never longer than tours[0]. width, when not NULL, receives the
+// frontier width of the chosen order.
+bool mergeTours(struct Graph *graph, int (*tours)[MAX_NODES], int numTours, int *tour, int trials, unsigned long long seed, int *width) {
+    int n = graph->numNodes;
+    if (numTours > MERGE_MAX_TOURS) {
+        numTours = MERGE_MAX_TOURS;
+    }
+    memcpy(tour, tours[0], n * sizeof(int));
+    if (width != NULL) {
+        *width = 0;
+    }
+
+    int (*shared)[2] = malloc(MAX_NODES * sizeof(*shared));
+    bool (*fixed)[2] = malloc(MAX_NODES * sizeof(*fixed));
+    if (findBackbone(tours, numTours, n, shared, fixed) >= n) {
+        // All tours are the same
+        free(fixed);
+        free(shared);
+        return true;
+    }
+
+    struct ReducedProblem *reduced = malloc(sizeof(struct ReducedProblem));
+    int reducedIndex[MAX_NODES];
+    buildReducedProblem(graph, shared, fixed, reduced, reducedIndex);
+    int m = reduced->graph.numNodes;
+
+    // Union graph of the tours on the reduced cities
+    int (*adj)[MERGE_MAX_DEGREE] = malloc(MAX_NODES * sizeof(*adj));
+    int degree[MAX_NODES];
+    int order[MAX_NODES], reducedTour[MAX_NODES];
+    for (int v = 0; v < m; v++) {
+        degree[v] = 0;
+    }
+    for (int t = numTours - 1; t >= 0; t--) {
+        int size = 0;
+        for (int i = 0; i < n; i++) {
+            if (reducedIndex[tours[t][i]] >= 0) {
+                order[size++] = reducedIndex[tours[t][i]];
+            }
+        }
+        for (int i = 0; i < m; i++) {
+            int u = order[i], v = order[(i + 1) % m];
+            bool known = false;
+            for (int e = 0; e < degree[u] && !known; e++) {
+                known = adj[u][e] == v;
+            }
+            if (!known && u != v) {
+                adj[u][degree[u]++] = v;
+                adj[v][degree[v]++] = u;
+            }
+        }
+    }
+    // order now holds the reduced order of tours[0]
+    memcpy(reducedTour, order, m * sizeof(int));
+
+    // Sweep along tours[0], starting where the frontier stays narrowest, or in a greedy
+    // order if that is narrower
+    int ord[MAX_NODES], lastOrd[MAX_NODES];
+    int offsets = m < 64 ? m : 64;
+    int bestOffset = 0, bestWidth = m + 1;
+    for (int o = 0; o < offsets; o++) {
+        int offset = (int) ((long long) o * m / offsets);
+        for (int i = 0; i < m; i++) {
+            ord[order[(i + offset) % m]] = i;
+        }
+        for (int v = 0; v < m; v++) {
+            lastOrd[v] = ord[v];
+            for (int e = 0; e < degree[v]; e++) {
+                if (ord[adj[v][e]] > lastOrd[v]) {
+                    lastOrd[v] = ord[adj[v][e]];
+                }
+            }
+        }
+        int sweepWidth = mergeSweepWidth(m, ord, lastOrd);
+        if (sweepWidth < bestWidth) {
+            bestWidth = sweepWidth;
+            bestOffset = offset;
+        }
+    }
+    int sweep[MAX_NODES], greedy[MAX_NODES];
+    for (int i = 0; i < m; i++) {
+        sweep[i] = order[(i + bestOffset) % m];
+    }
+
+    // Greedy orders usually follow the union graph more closely than the tour does
+    for (int g = 0; g < MERGE_GREEDY_STARTS && bestWidth > 2; g++) {
+        int greedyWidth = mergeGreedyOrder(m, adj, degree, order[(int) ((long long) g * m / MERGE_GREEDY_STARTS)], greedy);
+        if (greedyWidth < bestWidth) {
+            bestWidth = greedyWidth;
+            memcpy(sweep, greedy, m * sizeof(int));
+        }
+    }
+    if (width != NULL) {
+        *width = bestWidth;
+    }
+    bool exact = m >= 3 && bestWidth <= MERGE_MAX_WIDTH && mergeUnionGraph(reduced, adj, degree, sweep, reducedTour);
+    if (!exact) {
+        struct Rng rng;
+        rngSeed(&rng, seed);
+        searchReducedProblem(reduced, reducedTour, trials > 0 ? trials : 50 * m, &rng);
+    }
+    expandReducedTour(reduced, reducedTour, tour);
+
+    free(adj);
+    free(reduced);
+    free(fixed);
+    free(shared);
+    return exact;
+}
+
+#endif
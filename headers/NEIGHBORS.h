@@ -0,0 +1,456 @@
+// NEIGHBORS.h - The header file for spatial indexing and candidate neighbor lists
+// contains a uniform grid over the cities, k-nearest candidate lists and 2-opt / Or-opt
+// local search that only looks at candidate neighbors of queued cities
+
+#ifndef NEIGHBORS_H
+#define NEIGHBORS_H
+
+#define MAX_CANDIDATES 10
+
+// Uniform grid over the bounding box of the cities, about two cities per cell.
+// Cities are stored per cell in cellNodes[cellStart[c] .. cellStart[c] + cellCount[c]),
+// so a city can be removed in O(1) by swapping it with the last live one of its cell.
+struct SpatialGrid {
+    int cols;
+    int rows;
+    double minX;
+    double minY;
+    double cellSize;
+    int cellStart[MAX_NODES + 1];
+    int cellCount[MAX_NODES];
+    int cellNodes[MAX_NODES];
+    int nodeCell[MAX_NODES];
+    int nodeSlot[MAX_NODES];
+};
+
+// Candidate neighbors of every city, nearest first. fixedPartner, when not NULL, names
+// for every city the one city it must stay next to (-1 for none); the moves below never
+// remove such an edge.
+struct CandidateList {
+    int count;
+    int neighbors[MAX_NODES][MAX_CANDIDATES];
+    const int *fixedPartner;
+};
+
+bool edgeFixed(struct CandidateList *candidates, int a, int b) {
+    return candidates->fixedPartner != NULL && candidates->fixedPartner[a] == b;
+}
+
+int gridCellOf(struct SpatialGrid *grid, double x, double y) {
+    int cx = (int) ((x - grid->minX) / grid->cellSize);
+    int cy = (int) ((y - grid->minY) / grid->cellSize);
+    if (cx < 0) cx = 0;
+    if (cy < 0) cy = 0;
+    if (cx >= grid->cols) cx = grid->cols - 1;
+    if (cy >= grid->rows) cy = grid->rows - 1;
+    return cy * grid->cols + cx;
+}
+
+void buildSpatialGrid(struct Graph *graph, struct SpatialGrid *grid) {
+    int n = graph->numNodes;
+    double minX = DBL_MAX, minY = DBL_MAX, maxX = -DBL_MAX, maxY = -DBL_MAX;
+    for (int i = 0; i < n; i++) {
+        minX = fmin(minX, graph->nodes[i].x);
+        minY = fmin(minY, graph->nodes[i].y);
+        maxX = fmax(maxX, graph->nodes[i].x);
+        maxY = fmax(maxY, graph->nodes[i].y);
+    }
+
+    double width = fmax(maxX - minX, 1e-9);
+    double height = fmax(maxY - minY, 1e-9);
+    int targetCells = n / 2 > 1 ? n / 2 : 1;
+    grid->cellSize = sqrt(width * height / targetCells);
+    if (grid->cellSize <= 0.0) {
+        grid->cellSize = fmax(width, height);
+    }
+    grid->cols = (int) (width / grid->cellSize) + 1;
+    grid->rows = (int) (height / grid->cellSize) + 1;
+    // Degenerate (almost collinear) inputs can ask for more cells than we have room for
+    while (grid->cols * grid->rows > MAX_NODES) {
+        grid->cellSize *= 1.5;
+        grid->cols = (int) (width / grid->cellSize) + 1;
+        grid->rows = (int) (height / grid->cellSize) + 1;
+    }
+    grid->minX = minX;
+    grid->minY = minY;
+
+    int numCells = grid->cols * grid->rows;
+    for (int c = 0; c <= numCells; c++) {
+        grid->cellStart[c] = 0;
+    }
+    for (int i = 0; i < n; i++) {
+        grid->nodeCell[i] = gridCellOf(grid, graph->nodes[i].x, graph->nodes[i].y);
+        grid->cellStart[grid->nodeCell[i] + 1]++;
+    }
+    for (int c = 0; c < numCells; c++) {
+        grid->cellStart[c + 1] += grid->cellStart[c];
+        grid->cellCount[c] = 0;
+    }
+    for (int i = 0; i < n; i++) {
+        int c = grid->nodeCell[i];
+        grid->nodeSlot[i] = grid->cellStart[c] + grid->cellCount[c];
+        grid->cellNodes[grid->nodeSlot[i]] = i;
+        grid->cellCount[c]++;
+    }
+}
+
+// Removes a city from the grid so later queries skip it
+void gridRemove(struct SpatialGrid *grid, int city) {
+    int c = grid->nodeCell[city];
+    int last = grid->cellStart[c] + grid->cellCount[c] - 1;
+    int slot = grid->nodeSlot[city];
+    int other = grid->cellNodes[last];
+
+    grid->cellNodes[slot] = other;
+    grid->nodeSlot[other] = slot;
+    grid->cellNodes[last] = city;
+    grid->nodeSlot[city] = last;
+    grid->cellCount[c]--;
+}
+
+// Finds up to k cities of the grid nearest to (x, y), skipping 'exclude'.
+// Results are written nearest first; returns how many were found.
+int gridNearest(struct SpatialGrid *grid, struct Graph *graph, double x, double y, int exclude, int k, int *result, double *resultDist) {
+    int cx = (int) ((x - grid->minX) / grid->cellSize);
+    int cy = (int) ((y - grid->minY) / grid->cellSize);
+    if (cx < 0) cx = 0;
+    if (cy < 0) cy = 0;
+    if (cx >= grid->cols) cx = grid->cols - 1;
+    if (cy >= grid->rows) cy = grid->rows - 1;
+
+    int found = 0;
+    int maxRing = grid->cols > grid->rows ? grid->cols : grid->rows;
+    struct Node query = {-1, x, y};
+
+    for (int ring = 0; ring <= maxRing; ring++) {
+        for (int gy = cy - ring; gy <= cy + ring; gy++) {
+            if (gy < 0 || gy >= grid->rows) {
+                continue;
+            }
+            bool edgeRow = gy == cy - ring || gy == cy + ring;
+            for (int gx = cx - ring; gx <= cx + ring; gx += edgeRow ? 1 : 2 * ring) {
+                if (gx >= 0 && gx < grid->cols) {
+                    int c = gy * grid->cols + gx;
+                    for (int s = grid->cellStart[c]; s < grid->cellStart[c] + grid->cellCount[c]; s++) {
+                        int city = grid->cellNodes[s];
+                        if (city == exclude) {
+                            continue;
+                        }
+                        double d = calculateDistance(query, graph->nodes[city]);
+                        if (found == k && d >= resultDist[k - 1]) {
+                            continue;
+                        }
+                        int p = found < k ? found++ : k - 1;
+                        while (p > 0 && resultDist[p - 1] > d) {
+                            result[p] = result[p - 1];
+                            resultDist[p] = resultDist[p - 1];
+                            p--;
+                        }
+                        result[p] = city;
+                        resultDist[p] = d;
+                    }
+                }
+                if (ring == 0) {
+                    break;
+                }
+            }
+        }
+        // Every cell outside the rings searched so far is at least ring * cellSize away
+        if (found == k && resultDist[k - 1] <= ring * grid->cellSize) {
+            break;
+        }
+    }
+    return found;
+}
+
+void buildCandidateList(struct Graph *graph, struct SpatialGrid *grid, struct CandidateList *candidates, int count) {
+    if (count > MAX_CANDIDATES) {
+        count = MAX_CANDIDATES;
+    }
+    if (count > graph->numNodes - 1) {
+        count = graph->numNodes - 1;
+    }
+    candidates->count = count;
+    candidates->fixedPartner = NULL;
+
+    double dist[MAX_CANDIDATES];
+    for (int i = 0; i < graph->numNodes; i++) {
+        gridNearest(grid, graph, graph->nodes[i].x, graph->nodes[i].y, i, count, candidates->neighbors[i], dist);
+    }
+}
+
+// Reverses the tour positions from i to j (inclusive, wrapping around the end) and keeps pos[] in sync
+void reversePositions(int *tour, int *pos, int numNodes, int i, int j) {
+    int length = (j - i + numNodes) % numNodes + 1;
+    PERF_ADD(elementsSwapped, length);
+    for (int s = 0; s < length / 2; s++) {
+        int a = (i + s) % numNodes;
+        int b = (j - s + numNodes) % numNodes;
+        int temp = tour[a];
+        tour[a] = tour[b];
+        tour[b] = temp;
+        pos[tour[a]] = a;
+        pos[tour[b]] = b;
+    }
+}
+
+// Reverses the tour path that runs forward from city 'from' to city 'to'. When that path
+// is longer than half the tour, the complementary path is reversed instead, which gives
+// the same cycle.
+void reversePath(int *tour, int *pos, int numNodes, int from, int to) {
+    int i = pos[from];
+    int j = pos[to];
+    int length = (j - i + numNodes) % numNodes + 1;
+    if (2 * length > numNodes) {
+        reversePositions(tour, pos, numNodes, (j + 1) % numNodes, (i - 1 + numNodes) % numNodes);
+    } else {
+        reversePositions(tour, pos, numNodes, i, j);
+    }
+}
+
+// Moves the segment of 'length' cities starting at tour position p so that it follows
+// city c, reversed if requested. c must not be inside the segment or right before it.
+// Only the cities between the old and the new place of the segment shift.
+void moveSegmentAfter(int *tour, int *pos, int numNodes, int p, int length, int c, bool reversed) {
+    int n = numNodes;
+    int q = pos[c];
+    int forward = (q - p + n) % n;
+    int window[MAX_NODES];
+    int start, size;
+
+    if (forward <= n - forward) {
+        // [S][Y] -> [Y][S], c is the last city of Y
+        start = p;
+        size = forward + 1;
+        for (int i = 0; i < size - length; i++) {
+            window[i] = tour[(p + length + i) % n];
+        }
+        for (int i = 0; i < length; i++) {
+            window[size - length + i] = tour[(p + (reversed ? length - 1 - i : i)) % n];
+        }
+    } else {
+        // [Y][S] -> [S][Y], c is the city right before Y
+        start = (q + 1) % n;
+        size = n - forward + length - 1;
+        for (int i = 0; i < length; i++) {
+            window[i] = tour[(p + (reversed ? length - 1 - i : i)) % n];
+        }
+        for (int i = 0; i < size - length; i++) {
+            window[length + i] = tour[(start + i) % n];
+        }
+    }
+
+    PERF_ADD(elementsSwapped, size);
+    for (int i = 0; i < size; i++) {
+        int idx = (start + i) % n;
+        tour[idx] = window[i];
+        pos[window[i]] = idx;
+    }
+}
+
+// Tries the 2-opt moves that add an edge from city a to one of its candidates.
+// Applies the first improving one and returns its gain (0 if there is none).
+// hash, if not NULL, is updated with the exchanged edges.
+double twoOptNeighborMove(struct Graph *graph, int *tour, int *pos, struct CandidateList *candidates, int a, int *ends,
+                          unsigned long long *hash) {
+    int n = graph->numNodes;
+    for (int dir = 0; dir < 2; dir++) {
+        int b = dir == 0 ? tour[(pos[a] + 1) % n] : tour[(pos[a] - 1 + n) % n];
+        if (edgeFixed(candidates, a, b)) {
+            continue;
+        }
+        double dab = calculateDistance(graph->nodes[a], graph->nodes[b]);
+
+        for (int m = 0; m < candidates->count; m++) {
+            int c = candidates->neighbors[a][m];
+            double dac = calculateDistance(graph->nodes[a], graph->nodes[c]);
+            if (dac >= dab) {
+                break; // Candidates are sorted, no later one can gain
+            }
+            int d = dir == 0 ? tour[(pos[c] + 1) % n] : tour[(pos[c] - 1 + n) % n];
+            if (c == b || d == a || edgeFixed(candidates, c, d)) {
+                continue;
+            }
+
+            double gain = dab + calculateDistance(graph->nodes[c], graph->nodes[d])
+                        - dac - calculateDistance(graph->nodes[b], graph->nodes[d]);
+            PERF_COUNT(deltaEvals);
+            if (gain > 1e-10) {
+                PERF_COUNT(movesAccepted);
+                // Replace (a,b),(c,d) with (a,c),(b,d)
+                if (dir == 0) {
+                    reversePath(tour, pos, n, b, c);
+                } else {
+                    reversePath(tour, pos, n, c, b);
+                }
+                tourHashToggle(hash, a, b);
+                tourHashToggle(hash, c, d);
+                tourHashToggle(hash, a, c);
+                tourHashToggle(hash, b, d);
+                ends[0] = a;
+                ends[1] = b;
+                ends[2] = c;
+                ends[3] = d;
+                ends[4] = a;
+                ends[5] = a;
+                return gain;
+            }
+            PERF_COUNT(movesRejected);
+        }
+    }
+    return 0.0;
+}
+
+// Tries to move the segment of 1 to 3 cities that starts at city a next to one of a's
+// candidates, in either orientation. Applies the first improving move and returns its
+// gain (0 if there is none). hash, if not NULL, is updated with the exchanged edges.
+double orOptNeighborMove(struct Graph *graph, int *tour, int *pos, struct CandidateList *candidates, int a, int *ends,
+                         unsigned long long *hash) {
+    int n = graph->numNodes;
+    int p = pos[a];
+    int prev = tour[(p - 1 + n) % n];
+
+    for (int length = 1; length <= 3 && length + 3 <= n; length++) {
+        int last = tour[(p + length - 1) % n];
+        int next = tour[(p + length) % n];
+        if (edgeFixed(candidates, prev, a) || edgeFixed(candidates, last, next)) {
+            continue;
+        }
+        double removeGain = calculateDistance(graph->nodes[prev], graph->nodes[a])
+                          + calculateDistance(graph->nodes[last], graph->nodes[next])
+                          - calculateDistance(graph->nodes[prev], graph->nodes[next]);
+        if (removeGain <= 1e-10) {
+            continue;
+        }
+
+        for (int m = 0; m < candidates->count; m++) {
+            int c = candidates->neighbors[a][m];
+            double dac = calculateDistance(graph->nodes[a], graph->nodes[c]);
+            if (dac >= removeGain) {
+                break;
+            }
+            if ((pos[c] - p + n) % n < length) {
+                continue; // Inside the segment
+            }
+
+            // c, a .. last, after
+            int after = tour[(pos[c] + 1) % n];
+            if (c != prev && !edgeFixed(candidates, c, after)) {
+                double gain = removeGain - dac - calculateDistance(graph->nodes[last], graph->nodes[after])
+                            + calculateDistance(graph->nodes[c], graph->nodes[after]);
+                PERF_COUNT(deltaEvals);
+                if (gain > 1e-10) {
+                    PERF_COUNT(movesAccepted);
+                    moveSegmentAfter(tour, pos, n, p, length, c, false);
+                    tourHashToggle(hash, prev, a);
+                    tourHashToggle(hash, last, next);
+                    tourHashToggle(hash, c, after);
+                    tourHashToggle(hash, prev, next);
+                    tourHashToggle(hash, c, a);
+                    tourHashToggle(hash, last, after);
+                    ends[0] = prev;
+                    ends[1] = next;
+                    ends[2] = a;
+                    ends[3] = last;
+                    ends[4] = c;
+                    ends[5] = after;
+                    return gain;
+                }
+                PERF_COUNT(movesRejected);
+            }
+
+            // before, last .. a, c
+            int before = tour[(pos[c] - 1 + n) % n];
+            if (c != next && !edgeFixed(candidates, before, c)) {
+                double gain = removeGain - dac - calculateDistance(graph->nodes[before], graph->nodes[last])
+                            + calculateDistance(graph->nodes[before], graph->nodes[c]);
+                PERF_COUNT(deltaEvals);
+                if (gain > 1e-10) {
+                    PERF_COUNT(movesAccepted);
+                    moveSegmentAfter(tour, pos, n, p, length, before, true);
+                    tourHashToggle(hash, prev, a);
+                    tourHashToggle(hash, last, next);
+                    tourHashToggle(hash, before, c);
+                    tourHashToggle(hash, prev, next);
+                    tourHashToggle(hash, before, last);
+                    tourHashToggle(hash, a, c);
+                    ends[0] = prev;
+                    ends[1] = next;
+                    ends[2] = a;
+                    ends[3] = last;
+                    ends[4] = c;
+                    ends[5] = before;
+                    return gain;
+                }
+                PERF_COUNT(movesRejected);
+            }
+        }
+    }
+    return 0.0;
+}
+
+// Local search restricted to candidate neighbors, starting from the queued cities only.
+// Each city first tries 2-opt and, when useOrOpt is set and 2-opt finds nothing, Or-opt
+// (a per-city variable neighborhood descent). A city re-enters the queue when one of its
+// tour edges changes, so for a perturbed local optimum the work stays around the
+// perturbation. pos[] must be the inverse of tour[]. hash, if not NULL, is kept up to
+// date move by move. A control (may be NULL) that stops the run ends the search early,
+// between two moves. Returns the change of the tour length.
+double neighborLocalSearch(struct Graph *graph, int *tour, int *pos, struct CandidateList *candidates, int *touched, int numTouched,
+                           bool useOrOpt, unsigned long long *hash, struct RunControl *control) {
+    int n = graph->numNodes;
+    if (n < 5) {
+        return 0.0;
+    }
+
+    int queue[MAX_NODES];
+    bool queued[MAX_NODES];
+    for (int i = 0; i < n; i++) {
+        queued[i] = false;
+    }
+
+    int head = 0, size = 0;
+    for (int t = 0; t < numTouched; t++) {
+        int city = touched[t];
+        if (!queued[city]) {
+            queued[city] = true;
+            queue[(head + size++) % n] = city;
+        }
+    }
+
+    double delta = 0.0;
+    long long steps = 0;
+    while (size > 0) {
+        if (runShouldStopEvery(control, ++steps, INFINITY)) {
+            break;
+        }
+        int a = queue[head];
+        head = (head + 1) % n;
+        size--;
+        queued[a] = false;
+
+        int ends[6];
+        double gain = twoOptNeighborMove(graph, tour, pos, candidates, a, ends, hash);
+        if (gain <= 0.0 && useOrOpt) {
+            gain = orOptNeighborMove(graph, tour, pos, candidates, a, ends, hash);
+        }
+        if (gain > 0.0) {
+            delta -= gain;
+            for (int e = 0; e < 6; e++) {
+                if (!queued[ends[e]]) {
+                    queued[ends[e]] = true;
+                    queue[(head + size++) % n] = ends[e];
+                }
+            }
+        }
+    }
+
+    return delta;
+}
+
+// 2-opt restricted to candidate neighbors of the queued cities, see neighborLocalSearch
+double twoOptNeighborSearch(struct Graph *graph, int *tour, int *pos, struct CandidateList *candidates, int *touched, int numTouched) {
+    return neighborLocalSearch(graph, tour, pos, candidates, touched, numTouched, false, NULL, NULL);
+}
+
+#endif
@@ -0,0 +1,198 @@
+// PERF.h - The header file for the performance counters of the solvers
+// Built with TSP_PERF_COUNTERS, the hot paths count distance and tour length
+// evaluations, move delta evaluations, accepted and rejected moves and the tour
+// elements moved by reversals, in plain thread-local counters. A PerfRun collects the
+// counts of one solver phase from the thread that runs it and from every thread it
+// starts through perfThreadCreate. With TSP_PERF_EVENTS as well, a PerfRun also reads the
+// cycles, cache misses and branch misses of those threads from Linux perf_event.
+// Without TSP_PERF_COUNTERS the counting macros expand to nothing and perfThreadCreate
+// is pthread_create.
+
+#ifndef PERF_H
+#define PERF_H
+
+#include <pthread.h>
+
+#define PERF_NUM_EVENTS 3
+
+struct PerfCounters {
+    long long distanceEvals;     // calculateDistance calls
+    long long tourLengthEvals;   // calculateTourLength calls
+    long long deltaEvals;        // Length changes of candidate moves computed
+    long long movesAccepted;
+    long long movesRejected;
+    long long elementsSwapped;   // Tour entries rewritten by reversals and segment moves
+};
+
+struct PerfRun {
+    struct PerfCounters counters;
+    long long events[PERF_NUM_EVENTS];   // Hardware counts (-1 = not available)
+    int eventFds[PERF_NUM_EVENTS];
+    pthread_mutex_t lock;                // Guards counters while threads flush into them
+};
+
+#ifdef TSP_PERF_COUNTERS
+
+#ifdef TSP_PERF_EVENTS
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+const char *perfEventNames[PERF_NUM_EVENTS] = {"cycles", "cache_misses", "branch_misses"};
+
+_Thread_local struct PerfCounters perfLocal;
+_Thread_local struct PerfRun *perfCurrentRun;
+
+#define PERF_COUNT(field) (perfLocal.field++)
+#define PERF_ADD(field, amount) (perfLocal.field += (amount))
+
+// Adds this thread's counts to run and starts them over
+void perfFlush(struct PerfRun *run) {
+    if (run != NULL) {
+        pthread_mutex_lock(&run->lock);
+        run->counters.distanceEvals += perfLocal.distanceEvals;
+        run->counters.tourLengthEvals += perfLocal.tourLengthEvals;
+        run->counters.deltaEvals += perfLocal.deltaEvals;
+        run->counters.movesAccepted += perfLocal.movesAccepted;
+        run->counters.movesRejected += perfLocal.movesRejected;
+        run->counters.elementsSwapped += perfLocal.elementsSwapped;
+        pthread_mutex_unlock(&run->lock);
+    }
+    memset(&perfLocal, 0, sizeof(perfLocal));
+}
+
+struct PerfThreadStart {
+    void *(*function)(void *);
+    void *arg;
+    struct PerfRun *run;
+};
+
+void *perfThreadMain(void *arg) {
+    struct PerfThreadStart start = *(struct PerfThreadStart *) arg;
+    free(arg);
+    perfCurrentRun = start.run;
+    memset(&perfLocal, 0, sizeof(perfLocal));
+    void *result = start.function(start.arg);
+    perfFlush(start.run);
+    return result;
+}
+
+// pthread_create whose thread counts into the creating thread's run
+int perfThreadCreate(pthread_t *thread, const pthread_attr_t *attr, void *(*function)(void *), void *arg) {
+    struct PerfThreadStart *start = malloc(sizeof(struct PerfThreadStart));
+    start->function = function;
+    start->arg = arg;
+    start->run = perfCurrentRun;
+    return pthread_create(thread, attr, perfThreadMain, start);
+}
+
+// Hardware counters of the calling thread and the threads it creates from now on
+void perfEventsOpen(struct PerfRun *run) {
+    for (int e = 0; e < PERF_NUM_EVENTS; e++) {
+        run->eventFds[e] = -1;
+        run->events[e] = -1;
+    }
+#ifdef TSP_PERF_EVENTS
+    const unsigned long long configs[PERF_NUM_EVENTS] = {PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_CACHE_MISSES,
+                                                         PERF_COUNT_HW_BRANCH_MISSES};
+    for (int e = 0; e < PERF_NUM_EVENTS; e++) {
+        struct perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = configs[e];
+        attr.disabled = 1;
+        attr.inherit = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        // Unavailable counters (no PMU, restrictive perf_event_paranoid) stay at -1
+        run->eventFds[e] = (int) syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+        if (run->eventFds[e] >= 0) {
+            ioctl(run->eventFds[e], PERF_EVENT_IOC_RESET, 0);
+            ioctl(run->eventFds[e], PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+#endif
+}
+
+void perfEventsClose(struct PerfRun *run) {
+#ifdef TSP_PERF_EVENTS
+    for (int e = 0; e < PERF_NUM_EVENTS; e++) {
+        if (run->eventFds[e] >= 0) {
+            ioctl(run->eventFds[e], PERF_EVENT_IOC_DISABLE, 0);
+            long long count;
+            if (read(run->eventFds[e], &count, sizeof(count)) == sizeof(count)) {
+                run->events[e] = count;
+            }
+            close(run->eventFds[e]);
+        }
+    }
+#else
+    (void) run;
+#endif
+}
+
+// Starts counting a phase on the calling thread
+void perfRunBegin(struct PerfRun *run) {
+    memset(&run->counters, 0, sizeof(run->counters));
+    pthread_mutex_init(&run->lock, NULL);
+    memset(&perfLocal, 0, sizeof(perfLocal));
+    perfCurrentRun = run;
+    perfEventsOpen(run);
+}
+
+// Ends the phase; the threads it started have been joined
+void perfRunEnd(struct PerfRun *run) {
+    perfEventsClose(run);
+    perfFlush(run);
+    perfCurrentRun = NULL;
+    pthread_mutex_destroy(&run->lock);
+}
+
+// Appends the counts of a phase to a results file (see resultsFilename)
+void appendPerfCounters(const char *resultsFile, const char *phase, struct PerfRun *run) {
+    FILE *file = fopen(resultsFile, "a");
+    if (file == NULL) {
+        printf("Failed to open the output file.\n");
+        return;
+    }
+    fprintf(file, "\n---Performance Counters (%s)---\n", phase);
+    fprintf(file, "Distance evaluations: %lld\n", run->counters.distanceEvals);
+    fprintf(file, "Tour length evaluations: %lld\n", run->counters.tourLengthEvals);
+    fprintf(file, "Delta evaluations: %lld\n", run->counters.deltaEvals);
+    fprintf(file, "Moves accepted: %lld\n", run->counters.movesAccepted);
+    fprintf(file, "Moves rejected: %lld\n", run->counters.movesRejected);
+    fprintf(file, "Elements swapped: %lld\n", run->counters.elementsSwapped);
+    for (int e = 0; e < PERF_NUM_EVENTS; e++) {
+        if (run->events[e] >= 0) {
+            fprintf(file, "Hardware %s: %lld\n", perfEventNames[e], run->events[e]);
+        }
+    }
+    fclose(file);
+}
+
+#else
+
+#define PERF_COUNT(field) ((void) 0)
+#define PERF_ADD(field, amount) ((void) 0)
+#define perfThreadCreate pthread_create
+
+void perfRunBegin(struct PerfRun *run) {
+    (void) run;
+}
+
+void perfRunEnd(struct PerfRun *run) {
+    (void) run;
+}
+
+void appendPerfCounters(const char *resultsFile, const char *phase, struct PerfRun *run) {
+    (void) resultsFile;
+    (void) phase;
+    (void) run;
+}
+
+#endif
+
+#endif
@@ -0,0 +1,117 @@
+// RUNCONTROL.h - The header file for the run control of the solvers
+// A RunControl bounds a solver run from the outside: an absolute deadline, a target
+// length to stop at, and a cancel flag any thread may set. Solvers poll it between
+// units of work (every RUN_CHECK_INTERVAL moves for the cheap-move solvers, every trial
+// or generation for the others), always keep their best tour in the output, and leave
+// the reason they stopped and their statistics in the control.
+
+#ifndef RUNCONTROL_H
+#define RUNCONTROL_H
+
+#include <stdatomic.h>
+
+#define RUN_CHECK_INTERVAL 1024   // Moves between two polls, a power of two
+
+// Run status
+#define RUN_RUNNING 0
+#define RUN_COMPLETED 1   // The solver's own stopping rule ended the run
+#define RUN_DEADLINE 2
+#define RUN_TARGET 3      // A tour of at most targetLength was found
+#define RUN_CANCELLED 4
+
+const char *runStatusNames[] = {"running", "completed", "deadline", "target", "cancelled"};
+
+struct RunControl {
+    double deadline;          // Absolute currentTimeSeconds() to stop at (0 = none)
+    double targetLength;      // Stop once the best tour is this short (0 = none)
+    atomic_bool *cancel;      // Stop as soon as it is set (NULL = not cancellable)
+
+    atomic_int status;        // Results of the run
+    double bestLength;
+    double elapsed;           // Seconds
+    long long iterations;     // In the solver's own unit: moves, trials or generations
+    double startTime;
+};
+
+void runControlInit(struct RunControl *control) {
+    control->deadline = 0.0;
+    control->targetLength = 0.0;
+    control->cancel = NULL;
+    atomic_init(&control->status, RUN_RUNNING);
+    control->bestLength = 0.0;
+    control->elapsed = 0.0;
+    control->iterations = 0;
+    control->startTime = 0.0;
+}
+
+// Called by the solver when it starts. Does nothing when control is NULL, like the other
+// run functions, so solvers can call them unconditionally.
+void runBegin(struct RunControl *control) {
+    if (control == NULL) {
+        return;
+    }
+    atomic_store(&control->status, RUN_RUNNING);
+    control->startTime = currentTimeSeconds();
+    control->iterations = 0;
+}
+
+// Returns true if the run has to stop, recording why. The first reason found by any
+// thread of the run is kept.
+bool runShouldStop(struct RunControl *control, double bestLength) {
+    if (control == NULL) {
+        return false;
+    }
+    int status = atomic_load_explicit(&control->status, memory_order_relaxed);
+    if (status != RUN_RUNNING) {
+        return true;
+    }
+    if (control->cancel != NULL && atomic_load_explicit(control->cancel, memory_order_relaxed)) {
+        status = RUN_CANCELLED;
+    } else if (control->targetLength > 0.0 && bestLength <= control->targetLength) {
+        status = RUN_TARGET;
+    } else if (control->deadline > 0.0 && currentTimeSeconds() >= control->deadline) {
+        status = RUN_DEADLINE;
+    } else {
+        return false;
+    }
+    int running = RUN_RUNNING;
+    atomic_compare_exchange_strong(&control->status, &running, status);
+    return true;
+}
+
+// runShouldStop for loops of cheap moves: polls only every RUN_CHECK_INTERVAL-th call.
+// counter counts the moves.
+bool runShouldStopEvery(struct RunControl *control, long long counter, double bestLength) {
+    return control != NULL && (counter & (RUN_CHECK_INTERVAL - 1)) == 0 && runShouldStop(control, bestLength);
+}
+
+// Sets up phase to bound one phase of a run, such as building a population: it stops at
+// the earlier of the run's deadline and the solver's own (0 = none) and on the run's
+// cancel flag, but has its own status, so the phase just ends early and the run's next
+// poll records why. control may be NULL.
+void runPhaseBegin(struct RunControl *phase, struct RunControl *control, double deadline) {
+    runControlInit(phase);
+    phase->deadline = deadline;
+    if (control != NULL) {
+        if (control->deadline > 0.0 && (deadline == 0.0 || control->deadline < deadline)) {
+            phase->deadline = control->deadline;
+        }
+        phase->cancel = control->cancel;
+    }
+}
+
+// Called by the solver when it returns, with the length of the tour it returns. A solver
+// that stopped on its own time limit once the deadline had passed stopped for the deadline.
+void runEnd(struct RunControl *control, double bestLength, long long iterations) {
+    if (control == NULL) {
+        return;
+    }
+    int running = RUN_RUNNING;
+    bool late = control->deadline > 0.0 && currentTimeSeconds() >= control->deadline;
+    atomic_compare_exchange_strong(&control->status, &running, late ? RUN_DEADLINE : RUN_COMPLETED);
+    control->bestLength = bestLength;
+    control->iterations = iterations;
+    control->elapsed = currentTimeSeconds() - control->startTime;
+}
+
+#endif
@@ -8,9 +8,35 @@
 #define MIN_TEMPERATURE 0.01
 #define MAX_ITERATIONS 1000
 
-
+// Parameters, random stream and scratch tour of an SA run. A context is reused across
+// runs; concurrent runs need a context each.
+struct SAContext {
+    double initialTemperature;
+    double coolingRate;
+    double minTemperature;
+    int iterationsPerTemperature;
+    double timeLimit;          // Wall-clock budget in seconds, cooled over from start to end
+                               // (0 = the geometric schedule, until it is cold)
+    unsigned long long seed;   // The stream is reseeded from it at the start of every run
+    struct Trace *trace;       // Convergence trace (NULL = none)
+    struct RunControl *control;   // Deadline, target and cancellation (NULL = none)
+    struct Rng rng;
+    int current[MAX_NODES];
+};
+
+void saContextInit(struct SAContext *ctx) {
+    ctx->initialTemperature = INITIAL_TEMPERATURE;
+    ctx->coolingRate = COOLING_RATE;
+    ctx->minTemperature = MIN_TEMPERATURE;
+    ctx->iterationsPerTemperature = MAX_ITERATIONS;
+    ctx->timeLimit = 0.0;
+    ctx->seed = 1;
+    ctx->trace = NULL;
+    ctx->control = NULL;
+}
 
 void swapCities(int tour[], int i, int k) {
+    PERF_ADD(elementsSwapped, k > i ? k - i + 1 : 0);
     while (i < k) {
         int temp = tour[i];
         tour[i] = tour[k];
@@ -26,6 +52,7 @@ double twoOptDeltaEnergy(struct Graph *graph, int *tour, int i, int k) {
     int b = tour[(i + 1) % numNodes];
     int c = tour[k];
     int d = tour[(k + 1) % numNodes];
+    PERF_COUNT(deltaEvals);
 
     double originalEdge1 = calculateDistance(graph->nodes[a], graph->nodes[b]);
     double originalEdge2 = calculateDistance(graph->nodes[c], graph->nodes[d]);
@@ -35,27 +62,71 @@ double twoOptDeltaEnergy(struct Graph *graph, int *tour, int i, int k) {
     return (newEdge1 + newEdge2) - (originalEdge1 + originalEdge2);
 }
 
-void twoOpt(struct Graph *graph, int *tour) {
+// Anneals from the tour passed in and returns the best tour seen, so a good start tour
+// is never lost to the hot phase
+void twoOpt(struct SAContext *ctx, struct Graph *graph, int *tour) {
     int numNodes = graph->numNodes;
+    runBegin(ctx->control);
+    if (numNodes < 2) {
+        runEnd(ctx->control, 0.0, 0);
+        return;
+    }
     double initialTourLength = calculateTourLength(graph, tour);
-    double temperature = INITIAL_TEMPERATURE;
-
-    while (temperature > MIN_TEMPERATURE) {
-        for (int iter = 0; iter < MAX_ITERATIONS; iter++) {
-            int i = rand() % numNodes;
-            int k = rand() % numNodes;
+    double temperature = ctx->initialTemperature;
+    double currentLength = initialTourLength;
+    double bestLength = initialTourLength;
+    struct Rng *rng = &ctx->rng;
+    int *current = ctx->current;
+    rngSeed(rng, ctx->seed);
+    memcpy(current, tour, numNodes * sizeof(int));
+    double startTime = currentTimeSeconds();
+    double deadline = ctx->timeLimit > 0.0 ? startTime + ctx->timeLimit : 0.0;
+    long long moves = 0;
+    traceStart(ctx->trace, initialTourLength);
+    bool stopped = false;
+
+    while (!stopped && temperature > ctx->minTemperature && (deadline == 0.0 || currentTimeSeconds() < deadline)) {
+        for (int iter = 0; iter < ctx->iterationsPerTemperature; iter++, moves++) {
+            if (runShouldStopEvery(ctx->control, moves, bestLength)) {
+                stopped = true;
+                break;
+            }
+            int i = rngInt(rng, numNodes);
+            int k = rngInt(rng, numNodes);
             while (k == i)
-                k = rand() % numNodes;
-
-            double deltaEnergy = twoOptDeltaEnergy(graph, tour, i, k);
+                k = rngInt(rng, numNodes);
+            if (k < i) {
+                int temp = i;
+                i = k;
+                k = temp;
+            }
 
-            if (deltaEnergy < 0 || (rand() / (double)RAND_MAX) < exp(-deltaEnergy / temperature)) {
-                swapCities(tour, i + 1, k);
+            double deltaEnergy = twoOptDeltaEnergy(graph, current, i, k);
+
+            if (deltaEnergy < 0 || rngDouble(rng) < exp(-deltaEnergy / temperature)) {
+                PERF_COUNT(movesAccepted);
+                swapCities(current, i + 1, k);
+                currentLength += deltaEnergy;
+                if (currentLength < bestLength - 1e-9) {
+                    bestLength = currentLength;
+                    traceImprove(ctx->trace, bestLength, moves);
+                    memcpy(tour, current, numNodes * sizeof(int));
+                }
+            } else {
+                PERF_COUNT(movesRejected);
             }
         }
 
-        temperature *= COOLING_RATE;
+        if (deadline > 0.0) {
+            // A budgeted run cools geometrically in time, reaching minTemperature as the
+            // budget runs out, so a short budget still ends cold
+            double elapsed = fmin((currentTimeSeconds() - startTime) / ctx->timeLimit, 1.0);
+            temperature = ctx->initialTemperature * pow(ctx->minTemperature / ctx->initialTemperature, elapsed);
+        } else {
+            temperature *= ctx->coolingRate;
+        }
     }
+    runEnd(ctx->control, bestLength, moves);
 }
 
 
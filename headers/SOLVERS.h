@@ -0,0 +1,176 @@
+// SOLVERS.h - The header file for the common interface of the solvers
+// Every solver is driven through the same table of functions: its context is created
+// once and reused, configured with the common settings before every run, and run on a
+// graph from a start tour, which it improves in place. Batch mode, the benchmark and
+// the library (TSPSOLVER.h) all go through solvers[].
+
+#ifndef SOLVERS_H
+#define SOLVERS_H
+
+#include <strings.h>
+
+#define NUM_SOLVERS 5
+
+struct SolverSettings {
+    unsigned long long seed;
+    double timeLimit;             // Wall-clock budget in seconds, which also lifts the iteration
+                                  // limits (0 = the solver's own stopping rule)
+    int threads;                  // Threads of one run (0 = one per online core)
+    struct Trace *trace;          // Convergence trace (NULL = none)
+    struct RunControl *control;   // Deadline, target and cancellation (NULL = none)
+};
+
+struct Solver {
+    const char *name;
+    void *(*create)(void);
+    void (*destroy)(void *context);
+    void (*configure)(void *context, const struct SolverSettings *settings);
+    void (*solve)(void *context, struct Graph *graph, int *tour);
+};
+
+void solverSettingsInit(struct SolverSettings *settings) {
+    settings->seed = 1;
+    settings->timeLimit = 0.0;
+    settings->threads = 0;
+    settings->trace = NULL;
+    settings->control = NULL;
+}
+
+// LK has neither a seed nor a time limit of its own: only a control bounds it
+void *lkSolverCreate(void) {
+    struct LKContext *ctx = malloc(sizeof(struct LKContext));
+    lkContextInit(ctx);
+    return ctx;
+}
+
+void lkSolverDestroy(void *context) {
+    free(context);
+}
+
+void lkSolverConfigure(void *context, const struct SolverSettings *settings) {
+    struct LKContext *ctx = context;
+    ctx->trace = settings->trace;
+    ctx->control = settings->control;
+}
+
+void lkSolverSolve(void *context, struct Graph *graph, int *tour) {
+    lkhAlgorithm(context, graph, tour);
+}
+
+void *vnsSolverCreate(void) {
+    struct VNSContext *ctx = malloc(sizeof(struct VNSContext));
+    vnsContextInit(ctx);
+    return ctx;
+}
+
+void vnsSolverDestroy(void *context) {
+    vnsContextFree(context);
+    free(context);
+}
+
+void vnsSolverConfigure(void *context, const struct SolverSettings *settings) {
+    struct VNSContext *ctx = context;
+    ctx->seed = settings->seed;
+    ctx->timeLimit = settings->timeLimit;
+    ctx->maxIterations = settings->timeLimit > 0.0 ? INT_MAX : VNS_MAX_ITERATIONS;
+    ctx->numThreads = settings->threads;
+    ctx->trace = settings->trace;
+    ctx->control = settings->control;
+}
+
+void vnsSolverSolve(void *context, struct Graph *graph, int *tour) {
+    vnsAlgorithm(context, graph, tour);
+}
+
+void *gpxSolverCreate(void) {
+    struct GPXContext *ctx = malloc(sizeof(struct GPXContext));
+    gpxContextInit(ctx);
+    return ctx;
+}
+
+void gpxSolverDestroy(void *context) {
+    gpxContextFree(context);
+    free(context);
+}
+
+void gpxSolverConfigure(void *context, const struct SolverSettings *settings) {
+    struct GPXContext *ctx = context;
+    ctx->seed = settings->seed;
+    ctx->timeLimit = settings->timeLimit;
+    // A budgeted run evolves until the deadline or until it stagnates
+    ctx->maxGenerations = settings->timeLimit > 0.0 ? INT_MAX : MAX_GENERATIONS;
+    ctx->islands = settings->threads;
+    ctx->initThreads = settings->threads;
+    ctx->trace = settings->trace;
+    ctx->control = settings->control;
+}
+
+void gpxSolverSolve(void *context, struct Graph *graph, int *tour) {
+    gpcxAlgorithm(context, graph, tour);
+}
+
+void *saSolverCreate(void) {
+    struct SAContext *ctx = malloc(sizeof(struct SAContext));
+    saContextInit(ctx);
+    return ctx;
+}
+
+void saSolverDestroy(void *context) {
+    free(context);
+}
+
+void saSolverConfigure(void *context, const struct SolverSettings *settings) {
+    struct SAContext *ctx = context;
+    ctx->seed = settings->seed;
+    ctx->timeLimit = settings->timeLimit;
+    ctx->trace = settings->trace;
+    ctx->control = settings->control;
+}
+
+void saSolverSolve(void *context, struct Graph *graph, int *tour) {
+    twoOpt(context, graph, tour);
+}
+
+void *eaxSolverCreate(void) {
+    struct EAXContext *ctx = malloc(sizeof(struct EAXContext));
+    eaxContextInit(ctx);
+    return ctx;
+}
+
+void eaxSolverDestroy(void *context) {
+    eaxContextFree(context);
+    free(context);
+}
+
+void eaxSolverConfigure(void *context, const struct SolverSettings *settings) {
+    struct EAXContext *ctx = context;
+    ctx->seed = settings->seed;
+    ctx->timeLimit = settings->timeLimit;
+    ctx->initThreads = settings->threads;
+    ctx->trace = settings->trace;
+    ctx->control = settings->control;
+}
+
+void eaxSolverSolve(void *context, struct Graph *graph, int *tour) {
+    eaxAlgorithm(context, graph, tour);
+}
+
+const struct Solver solvers[NUM_SOLVERS] = {
+    {"LK", lkSolverCreate, lkSolverDestroy, lkSolverConfigure, lkSolverSolve},
+    {"VNS", vnsSolverCreate, vnsSolverDestroy, vnsSolverConfigure, vnsSolverSolve},
+    {"GPX", gpxSolverCreate, gpxSolverDestroy, gpxSolverConfigure, gpxSolverSolve},
+    {"SA2OPT", saSolverCreate, saSolverDestroy, saSolverConfigure, saSolverSolve},
+    {"EAX", eaxSolverCreate, eaxSolverDestroy, eaxSolverConfigure, eaxSolverSolve},
+};
+
+// Index of the solver called name, ignoring case, or -1
+int findSolver(const char *name) {
+    for (int s = 0; s < NUM_SOLVERS; s++) {
+        if (strcasecmp(solvers[s].name, name) == 0) {
+            return s;
+        }
+    }
+    return -1;
+}
+
+#endif
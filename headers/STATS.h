@@ -0,0 +1,82 @@
+// STATS.h - The header file for the distribution summaries of repeated runs
+// The samples of one (instance, algorithm) pair, one per seed, are reduced to their
+// extremes, mean, sample standard deviation and percentiles. Percentiles interpolate
+// linearly between the two nearest order statistics.
+
+#ifndef STATS_H
+#define STATS_H
+
+struct SampleSummary {
+    int count;
+    double min;
+    double max;
+    double mean;
+    double stdDev;   // Sample standard deviation (0 for a single sample)
+    double p10;
+    double p25;
+    double median;
+    double p75;
+    double p90;
+};
+
+int compareDoubles(const void *a, const void *b) {
+    double x = *(const double *) a, y = *(const double *) b;
+    return (x > y) - (x < y);
+}
+
+// q-quantile, 0 <= q <= 1, of count sorted samples
+double sortedPercentile(const double *sorted, int count, double q) {
+    double rank = q * (count - 1);
+    int lo = (int) rank;
+    if (lo >= count - 1) {
+        return sorted[count - 1];
+    }
+    double frac = rank - lo;
+    return sorted[lo] + frac * (sorted[lo + 1] - sorted[lo]);
+}
+
+// Summarizes count samples; the samples themselves are left in their order
+void summarizeSamples(const double *samples, int count, struct SampleSummary *summary) {
+    memset(summary, 0, sizeof(*summary));
+    summary->count = count;
+    if (count == 0) {
+        return;
+    }
+    double *sorted = malloc(count * sizeof(double));
+    memcpy(sorted, samples, count * sizeof(double));
+    qsort(sorted, count, sizeof(double), compareDoubles);
+
+    double sum = 0.0;
+    for (int i = 0; i < count; i++) {
+        sum += sorted[i];
+    }
+    summary->mean = sum / count;
+    // Two-pass variance: the lengths are large and close together
+    double squares = 0.0;
+    for (int i = 0; i < count; i++) {
+        squares += (sorted[i] - summary->mean) * (sorted[i] - summary->mean);
+    }
+    summary->stdDev = count > 1 ? sqrt(squares / (count - 1)) : 0.0;
+
+    summary->min = sorted[0];
+    summary->max = sorted[count - 1];
+    summary->p10 = sortedPercentile(sorted, count, 0.10);
+    summary->p25 = sortedPercentile(sorted, count, 0.25);
+    summary->median = sortedPercentile(sorted, count, 0.50);
+    summary->p75 = sortedPercentile(sorted, count, 0.75);
+    summary->p90 = sortedPercentile(sorted, count, 0.90);
+    free(sorted);
+}
+
+// Column names matching writeSummaryColumns, each prefixed by name
+void writeSummaryHeader(FILE *file, const char *name) {
+    fprintf(file, ",%s_min,%s_mean,%s_median,%s_std,%s_p10,%s_p25,%s_p75,%s_p90,%s_max", name, name, name, name, name, name, name,
+            name, name);
+}
+
+void writeSummaryColumns(FILE *file, const struct SampleSummary *summary) {
+    fprintf(file, ",%lf,%lf,%lf,%lf,%lf,%lf,%lf,%lf,%lf", summary->min, summary->mean, summary->median, summary->stdDev, summary->p10,
+            summary->p25, summary->p75, summary->p90, summary->max);
+}
+
+#endif
@@ -0,0 +1,55 @@
+// TOURHASH.h - The header file for tour hashing
+// A tour is hashed as the XOR of a 64-bit key per undirected edge (Zobrist hashing), so
+// the hash does not depend on the first city or the direction of the tour, and a move
+// that exchanges a few edges updates it in O(1) by toggling just those edges.
+
+#ifndef TOURHASH_H
+#define TOURHASH_H
+
+#define VISITED_CACHE_BITS 16   // The visited cache holds 2^16 hashes
+
+// Key of the undirected edge (a, b)
+unsigned long long edgeHash(int a, int b) {
+    unsigned long long lo = (unsigned long long) (a < b ? a : b);
+    unsigned long long hi = (unsigned long long) (a < b ? b : a);
+    unsigned long long z = (lo << 32 | hi) + 0x9E3779B97F4A7C15ULL;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+// Adds edge (a, b) to the hash if it is not in it, removes it otherwise. Does nothing
+// when hash is NULL, so moves can take an optional hash to maintain.
+void tourHashToggle(unsigned long long *hash, int a, int b) {
+    if (hash != NULL) {
+        *hash ^= edgeHash(a, b);
+    }
+}
+
+unsigned long long tourHash(int *tour, int numNodes) {
+    unsigned long long hash = 0;
+    for (int i = 0; i < numNodes; i++) {
+        hash ^= edgeHash(tour[i], tour[(i + 1) % numNodes]);
+    }
+    return hash;
+}
+
+// Direct-mapped cache of tour hashes: a new hash evicts whatever shared its slot, so the
+// cache remembers the most recent tours in constant memory. 0 marks an empty slot.
+struct TourHashSet {
+    unsigned long long keys[1 << VISITED_CACHE_BITS];
+};
+
+void tourHashSetClear(struct TourHashSet *set) {
+    memset(set->keys, 0, sizeof(set->keys));
+}
+
+bool tourHashSetContains(struct TourHashSet *set, unsigned long long hash) {
+    return hash != 0 && set->keys[hash & ((1 << VISITED_CACHE_BITS) - 1)] == hash;
+}
+
+void tourHashSetInsert(struct TourHashSet *set, unsigned long long hash) {
+    set->keys[hash & ((1 << VISITED_CACHE_BITS) - 1)] = hash;
+}
+
+#endif
@@ -0,0 +1,129 @@
+// TRACE.h - The header file for the convergence traces of the solvers
+// A solver reports every new best-so-far length to the trace of its context, if it has
+// one. Reports that do not beat the trace's best return after one atomic load; the
+// others, which are rare, swap in the new best with a compare-and-swap, claim the next
+// slot of a preallocated ring with a fetch-and-add and publish it through the slot's
+// sequence number, so no thread ever waits for another. A full ring overwrites its
+// oldest events.
+// The trace is read only after the run, and written to a CSV file next to the results.
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdatomic.h>
+
+#define TRACE_CAPACITY 4096   // Events kept per run, a power of two
+
+struct TraceEvent {
+    double time;           // Seconds since the start of the run
+    double length;
+    long long iteration;   // In the solver's own unit: moves, trials or generations
+};
+
+struct Trace {
+    _Atomic double best;
+    atomic_llong count;    // Slots claimed, overwritten ones included
+    double startTime;
+    struct TraceEvent events[TRACE_CAPACITY];
+    atomic_llong published[TRACE_CAPACITY];   // Index + 1 of the event in each slot, negated
+                                              // while it is being written
+};
+
+// Starts a run from a tour of the given length. Does nothing when trace is NULL, like
+// traceImprove, so solvers can report unconditionally.
+void traceStart(struct Trace *trace, double initialLength) {
+    if (trace == NULL) {
+        return;
+    }
+    trace->startTime = currentTimeSeconds();
+    for (int s = 1; s < TRACE_CAPACITY; s++) {
+        atomic_store_explicit(&trace->published[s], 0, memory_order_relaxed);
+    }
+    atomic_store(&trace->best, initialLength);
+    trace->events[0].time = 0.0;
+    trace->events[0].length = initialLength;
+    trace->events[0].iteration = 0;
+    atomic_store(&trace->published[0], 1);
+    atomic_store(&trace->count, 1);
+}
+
+// Records length if it beats the best so far
+void traceImprove(struct Trace *trace, double length, long long iteration) {
+    if (trace == NULL) {
+        return;
+    }
+    double best = atomic_load_explicit(&trace->best, memory_order_relaxed);
+    do {
+        if (length >= best - 1e-9) {
+            return;
+        }
+    } while (!atomic_compare_exchange_weak_explicit(&trace->best, &best, length, memory_order_relaxed,
+                                                    memory_order_relaxed));
+    long long slot = atomic_fetch_add_explicit(&trace->count, 1, memory_order_relaxed);
+    atomic_llong *published = &trace->published[slot & (TRACE_CAPACITY - 1)];
+    // Take the slot from its earlier occupant, marking it as being written. If that one
+    // is still being written, or a later lap has the slot already, the ring has lapped
+    // during a single write and the event is dropped.
+    long long previous = atomic_load_explicit(published, memory_order_relaxed);
+    do {
+        if (previous < 0 || previous > slot) {
+            return;
+        }
+    } while (!atomic_compare_exchange_weak_explicit(published, &previous, -(slot + 1), memory_order_acquire,
+                                                    memory_order_relaxed));
+    struct TraceEvent *event = &trace->events[slot & (TRACE_CAPACITY - 1)];
+    event->time = currentTimeSeconds() - trace->startTime;
+    event->length = length;
+    event->iteration = iteration;
+    atomic_store_explicit(published, slot + 1, memory_order_release);
+}
+
+// Copies the events still in the ring, oldest first, into events (room for
+// TRACE_CAPACITY) and returns how many. Slots claimed but not yet published are skipped.
+// Racing improvements may claim their slots out of order: an event already beaten by an
+// earlier one is dropped, and times are kept from going backwards.
+int traceEvents(struct Trace *trace, struct TraceEvent *events) {
+    long long count = atomic_load_explicit(&trace->count, memory_order_acquire);
+    long long first = count > TRACE_CAPACITY ? count - TRACE_CAPACITY : 0;
+    int numEvents = 0;
+    for (long long slot = first; slot < count; slot++) {
+        int s = (int) (slot & (TRACE_CAPACITY - 1));
+        if (atomic_load_explicit(&trace->published[s], memory_order_acquire) != slot + 1) {
+            continue;
+        }
+        struct TraceEvent event = trace->events[s];
+        if (numEvents > 0) {
+            if (event.length >= events[numEvents - 1].length) {
+                continue;
+            }
+            event.time = fmax(event.time, events[numEvents - 1].time);
+        }
+        events[numEvents++] = event;
+    }
+    return numEvents;
+}
+
+// Writes the trace to <outputFolder>/<algorithm>_<instance>_trace.csv, which the caller
+// makes sure exists (see writeOutput)
+void writeTrace(struct Trace *trace, const char *algorithmName, const char *inputFilename, const char *outputFolder) {
+    char name[MAX_FILENAME_LENGTH];
+    instanceName(inputFilename, name, sizeof(name));
+    char outputFilename[MAX_FILENAME_LENGTH + 64];
+    snprintf(outputFilename, sizeof(outputFilename), "%s/%s_%s_trace.csv", outputFolder, algorithmName, name);
+
+    FILE *file = fopen(outputFilename, "w");
+    if (file == NULL) {
+        printf("Failed to open the trace file.\n");
+        return;
+    }
+    fprintf(file, "time,length,iteration\n");
+    struct TraceEvent *events = malloc(TRACE_CAPACITY * sizeof(struct TraceEvent));
+    int numEvents = traceEvents(trace, events);
+    for (int e = 0; e < numEvents; e++) {
+        fprintf(file, "%lf,%lf,%lld\n", events[e].time, events[e].length, events[e].iteration);
+    }
+    free(events);
+    fclose(file);
+}
+
+#endif
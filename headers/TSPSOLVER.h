@@ -0,0 +1,102 @@
+// TSPSOLVER.h - The header file for the public API of the solver library
+// The only header of the library (tspsolver.c) meant for other programs: it declares
+// functions and may be included by any number of translation units. An instance is
+// loaded once and then read-only, so any number of threads can solve it at once; a
+// solver keeps its working memory from run to run and is used by one thread at a time.
+// Cities are numbered 0 .. n - 1 in input order (file lines or coordinate arrays), and
+// tours are given and returned in that numbering.
+
+#ifndef TSPSOLVER_H
+#define TSPSOLVER_H
+
+#include <stdatomic.h>
+
+#if defined(__GNUC__)
+#define TSP_API __attribute__((visibility("default")))
+#else
+#define TSP_API
+#endif
+
+// Return codes
+#define TSP_OK 0
+#define TSP_ERROR_FILE -1       // The instance file cannot be read
+#define TSP_ERROR_SIZE -2       // No cities, or more than the library supports
+#define TSP_ERROR_TOUR -3       // The start tour is not a permutation of the cities
+#define TSP_ERROR_CITY -4       // A dynamic tour has no city of that id, or has one already
+
+// Why a run stopped
+#define TSP_STATUS_COMPLETED 1  // The solver's own stopping rule
+#define TSP_STATUS_DEADLINE 2
+#define TSP_STATUS_TARGET 3
+#define TSP_STATUS_CANCELLED 4
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct TspInstance;
+struct TspSolver;
+struct TspDynamic;
+
+struct TspOptions {
+    double timeLimit;           // Wall-clock budget in seconds (0 = the solver's own stopping rule)
+    double targetLength;        // Stop once a tour this short is found (0 = none)
+    atomic_bool *cancel;        // Stop as soon as it is set, from any thread (NULL = none)
+    unsigned long long seed;
+    int threads;                // Threads of the run (0 = one per online core)
+    const int *startTour;       // Start tour (NULL = greedy edge tour)
+};
+
+struct TspResult {
+    int *tour;                  // Allocated by tspSolve, released by tspResultFree
+    int numNodes;
+    double length;
+    int status;                 // TSP_STATUS_*
+    double elapsed;             // Seconds
+    long long iterations;       // In the solver's own unit: moves, trials or generations
+};
+
+// Instances. Both return TSP_OK and set *instance, or an error code.
+TSP_API int tspInstanceLoad(const char *filename, struct TspInstance **instance);
+TSP_API int tspInstanceCreate(const double *x, const double *y, int numNodes, struct TspInstance **instance);
+TSP_API int tspInstanceSize(const struct TspInstance *instance);
+TSP_API void tspInstanceFree(struct TspInstance *instance);
+
+// Solvers, by name: "LK", "VNS", "GPX", "SA2OPT" or "EAX", in any case. NULL if unknown.
+TSP_API int tspSolverCount(void);
+TSP_API const char *tspSolverName(int index);
+TSP_API struct TspSolver *tspSolverCreate(const char *name);
+TSP_API void tspSolverFree(struct TspSolver *solver);
+
+// Reads the tour of a results file or a TSPLIB .tour file of the instance into tour
+// (tspInstanceSize entries), e.g. as startTour to continue from an earlier run. Returns
+// TSP_OK, TSP_ERROR_FILE if the file cannot be read, or TSP_ERROR_TOUR if it holds no
+// tour of these cities.
+TSP_API int tspTourLoad(const struct TspInstance *instance, const char *filename, int *tour);
+
+TSP_API void tspOptionsInit(struct TspOptions *options);
+// Returns TSP_OK and fills result, or an error code and leaves result untouched
+TSP_API int tspSolve(struct TspSolver *solver, const struct TspInstance *instance, const struct TspOptions *options,
+                     struct TspResult *result);
+TSP_API void tspResultFree(struct TspResult *result);
+TSP_API const char *tspStatusName(int status);
+
+// Dynamic tours: cities are added and removed while the tour is kept good by local
+// repairs around every change. Cities are named by ids, which start as the input
+// numbering of the instance; new ids are any other non-negative numbers.
+// The tour is a linked list and the repairs are Or-opt moves and 2-opt moves reversing
+// at most 100 cities, so an update costs time bounded by the change, not the tour size.
+TSP_API int tspDynamicCreate(const struct TspInstance *instance, const int *tour, struct TspDynamic **dynamic);
+TSP_API int tspDynamicInsert(struct TspDynamic *dynamic, int id, double x, double y);
+TSP_API int tspDynamicRemove(struct TspDynamic *dynamic, int id);
+TSP_API int tspDynamicSize(const struct TspDynamic *dynamic);
+TSP_API double tspDynamicLength(const struct TspDynamic *dynamic);
+// Writes the ids of the cities in tour order to ids, which holds tspDynamicSize entries
+TSP_API void tspDynamicTour(const struct TspDynamic *dynamic, int *ids);
+TSP_API void tspDynamicFree(struct TspDynamic *dynamic);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
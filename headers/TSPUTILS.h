@@ -4,6 +4,7 @@
 #include <stdio.h>
 #include <stdbool.h>
 #include <float.h>
+#include <limits.h>
 #include <stdlib.h>
 #include <sys/time.h>
 #include <math.h>
@@ -11,6 +12,9 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <string.h>
+#include <unistd.h>
+
+#include "PERF.h"
 
 #define MAX_ALGORITHM_NAME 10
 #define MAX_FILENAME_LENGTH 30
@@ -32,6 +36,7 @@ double calculateDistance(struct Node node1, struct Node node2) {
     double x_diff = node1.x - node2.x;
     double y_diff = node1.y - node2.y;
     double distanceSquared = x_diff * x_diff + y_diff * y_diff;
+    PERF_COUNT(distanceEvals);
 
     if (distanceSquared < 0) {
         printf("Warning: Negative value under sqrt in calculateDistance.\n");
@@ -41,6 +46,57 @@ double calculateDistance(struct Node node1, struct Node node2) {
     return sqrt(distanceSquared);
 }
 
+// Small per-owner random number generator (xorshift64*), so that threads can draw
+// from independent streams and a run can be replayed from its seed
+struct Rng {
+    unsigned long long state;
+};
+
+void rngSeed(struct Rng *rng, unsigned long long seed) {
+    // splitmix64 scrambling: nearby seeds still give unrelated streams
+    unsigned long long z = seed + 0x9E3779B97F4A7C15ULL;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    z ^= z >> 31;
+    rng->state = z != 0 ? z : 0x9E3779B97F4A7C15ULL;
+}
+
+unsigned long long rngNext(struct Rng *rng) {
+    unsigned long long x = rng->state;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    rng->state = x;
+    return x * 0x2545F4914F6CDD1DULL;
+}
+
+// Uniform integer in [0, n)
+int rngInt(struct Rng *rng, int n) {
+    return (int) ((rngNext(rng) >> 33) % (unsigned long long) n);
+}
+
+// Uniform double in [0, 1)
+double rngDouble(struct Rng *rng) {
+    return (double) (rngNext(rng) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+// Wall-clock time in seconds, for deadlines
+double currentTimeSeconds() {
+    struct timeval now;
+    gettimeofday(&now, NULL);
+    return now.tv_sec + now.tv_usec / 1000000.0;
+}
+
+// Number of online processor cores, at least 1
+int availableCores() {
+#ifdef _SC_NPROCESSORS_ONLN
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    return cores > 0 ? (int) cores : 1;
+#else
+    return 1;
+#endif
+}
+
 
 // Function to prompt the user to select a file from a directory
 void selectInputFile(char *filename) {
@@ -106,11 +162,12 @@ void selectInputFile(char *filename) {
     }
 }
 
-void readInput(struct Graph *graph, const char *filename) {
+// Reads the "id x y" lines of an instance file. Returns false if the file cannot be
+// opened, or has no cities or more than MAX_NODES.
+bool loadInput(struct Graph *graph, const char *filename) {
     FILE *file = fopen(filename, "r");
     if (file == NULL) {
-        printf("Failed to open the input file.\n");
-        exit(1);
+        return false;
     }
 
     int id;
@@ -118,6 +175,10 @@ void readInput(struct Graph *graph, const char *filename) {
     int count = 0;
 
     while (fscanf(file, "%d %lf %lf", &id, &x, &y) == 3) {
+        if (count == MAX_NODES) {
+            fclose(file);
+            return false;
+        }
         graph->nodes[count].id = id;
         graph->nodes[count].x = x;
         graph->nodes[count].y = y;
@@ -126,6 +187,31 @@ void readInput(struct Graph *graph, const char *filename) {
 
     graph->numNodes = count;
     fclose(file);
+    return count > 0;
+}
+
+void readInput(struct Graph *graph, const char *filename) {
+    if (!loadInput(graph, filename)) {
+        printf("Failed to read the input file.\n");
+        exit(1);
+    }
+}
+
+// Name of an instance: its file name without folder and extension
+void instanceName(const char *path, char *name, size_t size) {
+    const char *base = strrchr(path, '/') != NULL ? strrchr(path, '/') + 1 : path;
+    snprintf(name, size, "%s", base);
+    char *dot = strrchr(name, '.');
+    if (dot != NULL) {
+        *dot = '\0';
+    }
+}
+
+// Name of the results file writeOutput writes for the algorithm and instance
+void resultsFilename(char *name, size_t size, const char *outputFolder, const char *algorithmName, const char *inputFilename) {
+    char instance[MAX_FILENAME_LENGTH];
+    instanceName(inputFilename, instance, sizeof(instance));
+    snprintf(name, size, "%s/%s_%s_results.txt", outputFolder, algorithmName, instance);
 }
 
 void writeOutput(struct Graph *graph, int *tour, double tourLength, double mstLength, double mstTime, double executionTime, const char *algorithmName, const char *inputFilename, const char *outputFolder) {
@@ -137,23 +223,17 @@ void writeOutput(struct Graph *graph, int *tour, double tourLength, double mstLe
         inputFilenameOnly++;
     }
 
-    const char *dot = strrchr(inputFilenameOnly, '.');
-    if (dot == NULL) {
-        dot = inputFilenameOnly + strlen(inputFilenameOnly);
-    }
-
-    size_t length = dot - inputFilenameOnly;
-    char inputFileBaseName[length + 1];
-    strncpy(inputFileBaseName, inputFilenameOnly, length);
-    inputFileBaseName[length] = '\0';
-
     struct stat st = {0};
     if (stat(outputFolder, &st) == -1) {
+#ifdef _WIN32
         mkdir(outputFolder);
+#else
+        mkdir(outputFolder, 0755);
+#endif
     }
 
     char outputFilename[100];
-    snprintf(outputFilename, sizeof(outputFilename), "%s/%s_%s_results.txt", outputFolder, algorithmName, inputFileBaseName);
+    resultsFilename(outputFilename, sizeof(outputFilename), outputFolder, algorithmName, inputFilename);
 
     FILE *file = fopen(outputFilename, "w");
     if (file == NULL) {
@@ -200,6 +280,7 @@ double calculateTourLength(struct Graph *graph, int *tour) {
         return 0.0;
     }
 
+    PERF_COUNT(tourLengthEvals);
     double tourLength = 0.0;
     for (int i = 0; i < graph->numNodes; i++) {
         int currNode = tour[i];
@@ -216,11 +297,12 @@ double calculateTourLength(struct Graph *graph, int *tour) {
     return tourLength;
 }
 
-double calculateMST(struct Graph *graph) {
+// Prim's algorithm. parent[v] receives the MST neighbor of v on the way to city 0
+// (-1 for city 0). Returns the weight of the tree.
+double calculateMSTTree(struct Graph *graph, int *parent) {
     int n = graph->numNodes;
     double *key = malloc(n * sizeof(double));
     bool *inMST = malloc(n * sizeof(bool));
-    int *parent = malloc(n * sizeof(int));
     double totalWeight = 0.0;
 
     for (int i = 0; i < n; i++) {
@@ -261,11 +343,17 @@ double calculateMST(struct Graph *graph) {
 
     free(key);
     free(inMST);
-    free(parent);
 
     return totalWeight;
 }
 
+double calculateMST(struct Graph *graph) {
+    int *parent = malloc(graph->numNodes * sizeof(int));
+    double totalWeight = calculateMSTTree(graph, parent);
+    free(parent);
+    return totalWeight;
+}
+
 
 #endif
 
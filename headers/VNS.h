@@ -3,8 +3,18 @@
 #ifndef VNS_H
 #define VNS_H
 
-int kmax = 10;  // Maximum shaking intensity
-int maxIterations = 100; // Maximum number of iterations
+#include <pthread.h>
+#include <stdatomic.h>
+
+#define VNS_MAX_THREADS 64
+#define VNS_MAX_ITERATIONS 100   // Default k = 1..kmax sweeps of a run
+
+// VNS variants
+#define VNS_BASIC 0    // Shake, 2-opt local search, move on improvement
+#define VNS_REDUCED 1  // Shake only, no local search
+#define VNS_SKEWED 2   // Also move to slightly worse tours that are far from the incumbent
+#define VNS_GENERAL 3  // Local search is a 2-opt -> Or-opt descent (VND)
+
 
 void twoOptNeighborhoodChange(struct Graph *graph, int *tour, int i, int j) {
     if (i >= j || i < 0 || j >= graph->numNodes) {
@@ -12,6 +22,7 @@ void twoOptNeighborhoodChange(struct Graph *graph, int *tour, int i, int j) {
         return;
     }
 
+    PERF_ADD(elementsSwapped, j - i + 1);
     while (i < j) {
         int temp = tour[i];
         tour[i] = tour[j];
@@ -22,14 +33,14 @@ void twoOptNeighborhoodChange(struct Graph *graph, int *tour, int i, int j) {
 }
 
 
-void subMSTNeighborhoodChange(struct Graph *graph, int *tour, int k) {
+void subMSTNeighborhoodChange(struct Graph *graph, int *tour, int k, struct Rng *rng) {
     if (k <= 1 || k >= graph->numNodes) {
         // Invalid sub-MST size
         return;
     }
 
     // Generate a random starting index
-    int startIdx = rand() % graph->numNodes;
+    int startIdx = rngInt(rng, graph->numNodes);
 
     // Create a sub-MST of size k starting from the randomly selected index
     int subMST[MAX_NODES];
@@ -41,7 +52,7 @@ void subMSTNeighborhoodChange(struct Graph *graph, int *tour, int k) {
 
     // Rearrange the sub-MST nodes randomly
     for (int i = 0; i < count - 1; i++) {
-        int j = i + rand() % (count - i);
+        int j = i + rngInt(rng, count - i);
         int temp = subMST[i];
         subMST[i] = subMST[j];
         subMST[j] = temp;
@@ -54,21 +65,25 @@ void subMSTNeighborhoodChange(struct Graph *graph, int *tour, int k) {
 }
 
 // Shake the current tour to generate a new one
-void shake(struct Graph *graph, int *tour, int k, int numNodes) {
+void shake(struct Graph *graph, int *tour, int k, int numNodes, struct Rng *rng) {
+    if (numNodes < 4) {
+        return;
+    }
+
     // Implement the shaking operation (e.g., 2-opt or sub-MST).
-    int choice = rand() % 2; // Randomly choose between 2-opt and sub-MST
+    int choice = rngInt(rng, 2); // Randomly choose between 2-opt and sub-MST
 
     if (choice == 0) {
         // 2-opt neighborhood change
-        int i = rand() % numNodes;
+        int i = rngInt(rng, numNodes);
         int j;
         do {
-            j = rand() % numNodes;
+            j = rngInt(rng, numNodes);
         } while (abs(i - j) < 2);
         twoOptNeighborhoodChange(graph, tour, i, j);
     } else {
         // Sub-MST neighborhood change
-        subMSTNeighborhoodChange(graph, tour, k);
+        subMSTNeighborhoodChange(graph, tour, k, rng);
     }
 }
 
@@ -77,6 +92,7 @@ bool improveTour(struct Graph *graph, int *tour, int numNodes, int i, int j) {
         // printf("❌ improveTour out-of-bounds: i=%d, j=%d, numNodes=%d\n", i, j, numNodes);
         return false;
     }
+    PERF_COUNT(deltaEvals);
 
     double dist_before = calculateDistance(graph->nodes[tour[i]], graph->nodes[tour[i + 1]])
                        + calculateDistance(graph->nodes[tour[j]], graph->nodes[tour[j + 1]]);
@@ -93,6 +109,7 @@ void reverseSegment(int *tour, int i, int j, int numNodes) {
         return;
     }
 
+    PERF_ADD(elementsSwapped, j - i + 1);
     while (i < j) {
         int temp = tour[i];
         tour[i] = tour[j];
@@ -113,8 +130,11 @@ void twoOptLocalSearch(struct Graph *graph, int *tour, int numNodes) {
                 // Check if reversing the segment between indices i and j improves the tour
                 if (improveTour(graph, tour, numNodes, i, j)) {
                     // Reverse the segment
+                    PERF_COUNT(movesAccepted);
                     reverseSegment(tour, i + 1, j, numNodes - 1);
                     improved = true;
+                } else {
+                    PERF_COUNT(movesRejected);
                 }
             }
         }
@@ -122,43 +142,673 @@ void twoOptLocalSearch(struct Graph *graph, int *tour, int numNodes) {
 }
 
 
-void vnsAlgorithm(struct Graph *graph, int *tour, int kmax, int maxIterations) {
-    int k = 1;
-    int iteration = 0;
+// Records a city as touched by a shaking move, once
+void markTouched(int city, bool *isTouched, int *touched, int *numTouched) {
+    if (!isTouched[city]) {
+        isTouched[city] = true;
+        touched[(*numTouched)++] = city;
+    }
+}
+
+// Moves a segment of up to maxLength cities, starting at a random city, next to one of
+// that city's candidate neighbors (reversed half of the time). Returns the change of the
+// tour length.
+double segmentMoveShake(struct Graph *graph, int *tour, int *pos, struct CandidateList *candidates, int maxLength, struct Rng *rng,
+                        bool *isTouched, int *touched, int *numTouched, unsigned long long *hash) {
+    int n = graph->numNodes;
+    int length = 1 + rngInt(rng, maxLength);
+    int p = rngInt(rng, n);
+    int c = candidates->neighbors[tour[p]][rngInt(rng, candidates->count)];
+
+    int forward = (pos[c] - p + n) % n;
+    if (forward < length || forward == n - 1) {
+        return 0.0; // Neighbor inside the segment or right before it
+    }
+    bool reversed = rngInt(rng, 2) == 1;
+
+    int segmentFirst = tour[p];
+    int segmentLast = tour[(p + length - 1) % n];
+    int s0 = tour[(p - 1 + n) % n];
+    int s1 = tour[(p + length) % n];
+    int c2 = tour[(pos[c] + 1) % n];
+    if (edgeFixed(candidates, s0, segmentFirst) || edgeFixed(candidates, segmentLast, s1) || edgeFixed(candidates, c, c2)) {
+        return 0.0;
+    }
+    int first = reversed ? segmentLast : segmentFirst;
+    int last = reversed ? segmentFirst : segmentLast;
+
+    double delta = calculateDistance(graph->nodes[s0], graph->nodes[s1])
+                 + calculateDistance(graph->nodes[c], graph->nodes[first])
+                 + calculateDistance(graph->nodes[last], graph->nodes[c2])
+                 - calculateDistance(graph->nodes[s0], graph->nodes[segmentFirst])
+                 - calculateDistance(graph->nodes[segmentLast], graph->nodes[s1])
+                 - calculateDistance(graph->nodes[c], graph->nodes[c2]);
+
+    moveSegmentAfter(tour, pos, n, p, length, c, reversed);
+    tourHashToggle(hash, s0, segmentFirst);
+    tourHashToggle(hash, segmentLast, s1);
+    tourHashToggle(hash, c, c2);
+    tourHashToggle(hash, s0, s1);
+    tourHashToggle(hash, c, first);
+    tourHashToggle(hash, last, c2);
+
+    int ends[6] = {s0, s1, c, c2, segmentFirst, segmentLast};
+    for (int e = 0; e < 6; e++) {
+        markTouched(ends[e], isTouched, touched, numTouched);
+    }
+    return delta;
+}
+
+// Double-bridge move whose three cut points sit at a random city and two of its candidate
+// neighbors: A B C D -> A C B D, with the longest of the three arcs left in place.
+// Returns the change of the tour length.
+double localDoubleBridgeShake(struct Graph *graph, int *tour, int *pos, struct CandidateList *candidates, struct Rng *rng,
+                              bool *isTouched, int *touched, int *numTouched, unsigned long long *hash) {
+    int n = graph->numNodes;
+    int a = rngInt(rng, n);
+    int b = candidates->neighbors[a][rngInt(rng, candidates->count)];
+    int c = candidates->neighbors[a][rngInt(rng, candidates->count)];
+    int x = pos[a], y = pos[b], z = pos[c];
+    if (x == y || y == z || x == z) {
+        return 0.0;
+    }
+
+    // Sort the cut positions, then rotate them so the largest gap wraps around
+    int cuts[3] = {x, y, z};
+    for (int i = 0; i < 2; i++) {
+        for (int j = i + 1; j < 3; j++) {
+            if (cuts[j] < cuts[i]) {
+                int temp = cuts[i];
+                cuts[i] = cuts[j];
+                cuts[j] = temp;
+            }
+        }
+    }
+    int gaps[3] = {cuts[1] - cuts[0], cuts[2] - cuts[1], n - cuts[2] + cuts[0]};
+    int largest = gaps[0] >= gaps[1] && gaps[0] >= gaps[2] ? 0 : (gaps[1] >= gaps[2] ? 1 : 2);
+    int u = cuts[(largest + 1) % 3];
+    int v = cuts[(largest + 2) % 3];
+    int w = cuts[largest];
+    if (v < u) v += n;
+    if (w < v) w += n;
+
+    int u0 = tour[u % n], u1 = tour[(u + 1) % n];
+    int v0 = tour[v % n], v1 = tour[(v + 1) % n];
+    int w0 = tour[w % n], w1 = tour[(w + 1) % n];
+    if (w1 == u0 || edgeFixed(candidates, u0, u1) || edgeFixed(candidates, v0, v1) || edgeFixed(candidates, w0, w1)) {
+        return 0.0;
+    }
+
+    double delta = calculateDistance(graph->nodes[u0], graph->nodes[v1])
+                 + calculateDistance(graph->nodes[w0], graph->nodes[u1])
+                 + calculateDistance(graph->nodes[v0], graph->nodes[w1])
+                 - calculateDistance(graph->nodes[u0], graph->nodes[u1])
+                 - calculateDistance(graph->nodes[v0], graph->nodes[v1])
+                 - calculateDistance(graph->nodes[w0], graph->nodes[w1]);
+
+    // Block B = (u, v], block C = (v, w]; write C then B
+    int window[MAX_NODES];
+    int size = 0;
+    for (int i = v + 1; i <= w; i++) {
+        window[size++] = tour[i % n];
+    }
+    for (int i = u + 1; i <= v; i++) {
+        window[size++] = tour[i % n];
+    }
+    for (int i = 0; i < size; i++) {
+        int idx = (u + 1 + i) % n;
+        tour[idx] = window[i];
+        pos[window[i]] = idx;
+    }
+    tourHashToggle(hash, u0, u1);
+    tourHashToggle(hash, v0, v1);
+    tourHashToggle(hash, w0, w1);
+    tourHashToggle(hash, u0, v1);
+    tourHashToggle(hash, w0, u1);
+    tourHashToggle(hash, v0, w1);
+
+    int ends[6] = {u0, u1, v0, v1, w0, w1};
+    for (int e = 0; e < 6; e++) {
+        markTouched(ends[e], isTouched, touched, numTouched);
+    }
+    return delta;
+}
+
+// Applies k spatially local perturbations and re-optimizes only around the cities they
+// touched (2-opt for basic/skewed VNS, 2-opt -> Or-opt for general VNS, nothing for
+// reduced VNS). hash is kept up to date. If the perturbed tour is in 'visited' (when not
+// NULL), it was searched before and led nowhere, so the repair is skipped and *known is
+// set. Returns the change of the tour length.
+double localizedShake(struct Graph *graph, int *tour, int *pos, struct CandidateList *candidates, int k, int variant, struct Rng *rng,
+                      unsigned long long *hash, struct TourHashSet *visited, bool *known) {
+    int touched[MAX_NODES];
+    bool isTouched[MAX_NODES];
+    int numTouched = 0;
+    for (int i = 0; i < graph->numNodes; i++) {
+        isTouched[i] = false;
+    }
+
+    double delta = 0.0;
+    for (int move = 0; move < k; move++) {
+        if (rngInt(rng, 2) == 0) {
+            delta += segmentMoveShake(graph, tour, pos, candidates, 3, rng, isTouched, touched, &numTouched, hash);
+        } else {
+            delta += localDoubleBridgeShake(graph, tour, pos, candidates, rng, isTouched, touched, &numTouched, hash);
+        }
+    }
+
+    *known = visited != NULL && tourHashSetContains(visited, *hash);
+    if (*known || variant == VNS_REDUCED) {
+        return delta;
+    }
+    if (visited != NULL) {
+        tourHashSetInsert(visited, *hash);
+    }
+    delta += neighborLocalSearch(graph, tour, pos, candidates, touched, numTouched, variant == VNS_GENERAL, hash, NULL);
+    if (visited != NULL) {
+        tourHashSetInsert(visited, *hash);
+    }
+    return delta;
+}
+
+// Builds the candidate lists used by localized shaking into grid / candidates and brings
+// the start tour to a candidate local optimum, so later repairs only have to look at
+// touched cities. Returns candidates, or NULL when localized shaking is off or the
+// instance is too small.
+struct CandidateList *vnsPrepareLocalSearch(struct Graph *graph, int *tour, int *pos, int variant, bool localShaking,
+                                            struct SpatialGrid *grid, struct CandidateList *candidates) {
+    int n = graph->numNodes;
+    for (int i = 0; i < n; i++) {
+        pos[tour[i]] = i;
+    }
+    if (!localShaking || n < 8) {
+        return NULL;
+    }
+
+    buildSpatialGrid(graph, grid);
+    buildCandidateList(graph, grid, candidates, 8);
+
+    int all[MAX_NODES];
+    for (int i = 0; i < n; i++) {
+        all[i] = tour[i];
+    }
+    neighborLocalSearch(graph, tour, pos, candidates, all, n, variant == VNS_GENERAL, NULL, NULL);
+    return candidates;
+}
+
+// One VNS trial on a private copy of the incumbent: shake with intensity k and run the
+// variant's local search. hash comes in as the hash of the incumbent and goes out as the
+// hash of the trial tour. Returns the length of the resulting tour, or DBL_MAX if
+// 'visited' shows the shaken tour was searched before.
+double vnsTrial(struct Graph *graph, int *trialTour, int *trialPos, struct CandidateList *candidates, int k, int variant,
+                double baseLength, struct Rng *rng, unsigned long long *hash, struct TourHashSet *visited) {
     int numNodes = graph->numNodes;
+    bool known = false;
+    if (candidates != NULL) {
+        double delta = localizedShake(graph, trialTour, trialPos, candidates, k, variant, rng, hash, visited, &known);
+        return known ? DBL_MAX : baseLength + delta;
+    }
 
-    while (iteration < maxIterations) {
-        while (k <= kmax) {
-            int currentTour[MAX_NODES];
-            for (int i = 0; i < numNodes; i++) {
-                currentTour[i] = tour[i];
+    shake(graph, trialTour, k, numNodes, rng);
+    *hash = tourHash(trialTour, numNodes);
+    if (visited != NULL) {
+        if (tourHashSetContains(visited, *hash)) {
+            return DBL_MAX;
+        }
+        tourHashSetInsert(visited, *hash);
+    }
+
+    // Perform local search on the shaken tour using 2-opt
+    // 2-opt is a common local search algorithm for TSP
+    if (variant != VNS_REDUCED) {
+        twoOptLocalSearch(graph, trialTour, numNodes);
+        *hash = tourHash(trialTour, numNodes);
+        if (visited != NULL) {
+            tourHashSetInsert(visited, *hash);
+        }
+    }
+    for (int i = 0; i < numNodes; i++) {
+        trialPos[trialTour[i]] = i;
+    }
+    return calculateTourLength(graph, trialTour);
+}
+
+// Number of edges of the trial tour that are not in the reference tour (refPos is the
+// inverse of the reference)
+int tourEdgeDistance(int *trialTour, int *refPos, int numNodes) {
+    int distance = 0;
+    for (int i = 0; i < numNodes; i++) {
+        int gap = abs(refPos[trialTour[i]] - refPos[trialTour[(i + 1) % numNodes]]);
+        if (gap != 1 && gap != numNodes - 1) {
+            distance++;
+        }
+    }
+    return distance;
+}
+
+// Acceptance test of the VNS variants. Skewed VNS moves to a worse tour if the length
+// it loses is paid for by how far the tour is from the incumbent.
+bool vnsAccept(int variant, double skewAlpha, double trialLength, double incumbentLength, int *trialTour, int *incumbentPos,
+               int numNodes) {
+    if (trialLength < incumbentLength - 1e-9) {
+        return true;
+    }
+    // At most numNodes edges can differ, so anything worse than that can never pass
+    if (variant != VNS_SKEWED || trialLength - incumbentLength > skewAlpha * incumbentLength) {
+        return false;
+    }
+    double credit = skewAlpha * incumbentLength / numNodes;
+    return trialLength - credit * tourEdgeDistance(trialTour, incumbentPos, numNodes) < incumbentLength - 1e-9;
+}
+
+// Shared state of a VNS run. tour always holds the best tour found so far (anytime
+// result). Workers race on bestLength with compare-and-swap and take the lock only to
+// copy or install a tour.
+struct VNSShared {
+    struct Graph *graph;
+    struct CandidateList *candidates; // NULL when shaking the whole tour
+    int *tour;                        // Best tour so far, guarded by lock
+    int pos[MAX_NODES];               // Inverse of the best tour, guarded by lock
+    double installedLength;           // Length of the tour currently in tour[], guarded by lock
+    unsigned long long installedHash; // Hash of the tour currently in tour[], guarded by lock
+    _Atomic double bestLength;        // Best length published so far
+    pthread_mutex_t lock;
+    atomic_int sweepsLeft;            // Remaining k = 1..kmax sweeps (free-running mode)
+    atomic_llong trials;
+    atomic_llong cachedTrials;
+    int kmax;
+    int variant;
+    double skewAlpha;
+    bool visitedCache;
+    int numThreads;
+    double deadline;                  // Absolute wall-clock time to stop at (0 = none)
+    unsigned long long seed;
+    struct Trace *trace;
+    struct RunControl *control;
+
+    // Deterministic mode: synchronous rounds, all workers shake the same incumbent with
+    // the same k and the best trial (ties to the lowest worker id) wins the round
+    pthread_cond_t roundCond;
+    int arrived;
+    int roundGeneration;
+    int roundK;
+    int sweepsDone;
+    int maxSweeps;
+    int roundWinner;
+    bool finished;
+    double roundLengths[VNS_MAX_THREADS];
+    int incumbent[MAX_NODES];         // Differs from the best tour only for skewed VNS
+    int incumbentPos[MAX_NODES];
+    double incumbentLength;
+    unsigned long long incumbentHash;
+};
+
+struct VNSWorker {
+    struct VNSShared *shared;
+    int id;
+    int incumbent[MAX_NODES];         // The worker's own incumbent (free-running mode)
+    int incumbentPos[MAX_NODES];
+    int currentTour[MAX_NODES];
+    int currentPos[MAX_NODES];
+    unsigned long long incumbentHash;
+    unsigned long long currentHash;
+    struct TourHashSet visited;       // Tours this worker has already searched
+};
+
+// Time limit or run control: checked once per trial
+bool vnsShouldStop(struct VNSShared *shared) {
+    return (shared->deadline > 0.0 && currentTimeSeconds() >= shared->deadline) ||
+           runShouldStop(shared->control, atomic_load_explicit(&shared->bestLength, memory_order_relaxed));
+}
+
+// Mixes the base seed, a round number and a worker id into one stream seed
+unsigned long long vnsStreamSeed(unsigned long long seed, long long round, int worker) {
+    return seed ^ ((unsigned long long) round * 0xD1B54A32D192ED03ULL) ^ ((unsigned long long) (worker + 1) * 0x9E3779B97F4A7C15ULL);
+}
+
+// Publishes a candidate tour if it beats the best length; returns true if it did
+bool vnsPublish(struct VNSShared *shared, int *candidate, int *candidatePos, double candidateLength, unsigned long long candidateHash) {
+    double observed = atomic_load(&shared->bestLength);
+    while (candidateLength < observed - 1e-9) {
+        if (atomic_compare_exchange_weak(&shared->bestLength, &observed, candidateLength)) {
+            // A later, better winner may have installed already, so re-check under the lock
+            pthread_mutex_lock(&shared->lock);
+            if (candidateLength < shared->installedLength) {
+                int numNodes = shared->graph->numNodes;
+                memcpy(shared->tour, candidate, numNodes * sizeof(int));
+                memcpy(shared->pos, candidatePos, numNodes * sizeof(int));
+                shared->installedLength = candidateLength;
+                shared->installedHash = candidateHash;
             }
+            pthread_mutex_unlock(&shared->lock);
+            traceImprove(shared->trace, candidateLength, atomic_load_explicit(&shared->trials, memory_order_relaxed));
+            return true;
+        }
+    }
+    return false;
+}
 
-            // Shake the tour
-            shake(graph, currentTour, k, numNodes);
+// Replaces the worker's incumbent with the shared best tour; returns its length
+double vnsFetchBest(struct VNSShared *shared, struct VNSWorker *worker) {
+    int numNodes = shared->graph->numNodes;
+    pthread_mutex_lock(&shared->lock);
+    memcpy(worker->incumbent, shared->tour, numNodes * sizeof(int));
+    memcpy(worker->incumbentPos, shared->pos, numNodes * sizeof(int));
+    double length = shared->installedLength;
+    worker->incumbentHash = shared->installedHash;
+    pthread_mutex_unlock(&shared->lock);
+    return length;
+}
 
-            // Perform local search on the shaken tour using 2-opt
-            // 2-opt is a common local search algorithm for TSP
-            twoOptLocalSearch(graph, currentTour, numNodes);
+// Free-running worker. Each worker walks from its own incumbent and picks up the shared
+// best whenever another worker has published a better tour (for skewed VNS only at the
+// start of a sweep, so the skewed walk is not cut short).
+void *vnsFreeWorker(void *arg) {
+    struct VNSWorker *worker = arg;
+    struct VNSShared *shared = worker->shared;
+    int numNodes = shared->graph->numNodes;
+
+    struct Rng rng;
+    rngSeed(&rng, vnsStreamSeed(shared->seed, 0, worker->id));
+    struct TourHashSet *visited = shared->visitedCache ? &worker->visited : NULL;
+    if (visited != NULL) {
+        tourHashSetClear(visited);
+    }
+    double incumbentLength = vnsFetchBest(shared, worker);
 
-            // Update the tour if a better solution is found
-            double currentLength = calculateTourLength(graph, currentTour);
-            double bestLength = calculateTourLength(graph, tour);
+    while (!vnsShouldStop(shared) && atomic_fetch_sub(&shared->sweepsLeft, 1) > 0) {
+        if (atomic_load(&shared->bestLength) < incumbentLength - 1e-9) {
+            incumbentLength = vnsFetchBest(shared, worker);
+        }
+
+        int k = 1;
+        while (k <= shared->kmax && !vnsShouldStop(shared)) {
+            if (shared->variant != VNS_SKEWED && atomic_load(&shared->bestLength) < incumbentLength - 1e-9) {
+                incumbentLength = vnsFetchBest(shared, worker);
+            }
 
-            if (currentLength < bestLength) {
-                for (int i = 0; i < numNodes; i++) {
-                    tour[i] = currentTour[i];
+            memcpy(worker->currentTour, worker->incumbent, numNodes * sizeof(int));
+            memcpy(worker->currentPos, worker->incumbentPos, numNodes * sizeof(int));
+            worker->currentHash = worker->incumbentHash;
+
+            double currentLength = vnsTrial(shared->graph, worker->currentTour, worker->currentPos, shared->candidates,
+                                            k, shared->variant, incumbentLength, &rng, &worker->currentHash, visited);
+            atomic_fetch_add(&shared->trials, 1);
+            if (currentLength == DBL_MAX) {
+                atomic_fetch_add(&shared->cachedTrials, 1);
+            }
+
+            if (vnsAccept(shared->variant, shared->skewAlpha, currentLength, incumbentLength, worker->currentTour, worker->incumbentPos, numNodes)) {
+                bool improved = currentLength < incumbentLength - 1e-9;
+                memcpy(worker->incumbent, worker->currentTour, numNodes * sizeof(int));
+                memcpy(worker->incumbentPos, worker->currentPos, numNodes * sizeof(int));
+                incumbentLength = currentLength;
+                worker->incumbentHash = worker->currentHash;
+                vnsPublish(shared, worker->currentTour, worker->currentPos, currentLength, worker->currentHash);
+                k = improved ? 1 : k + 1;
+            } else {
+                k++;
+            }
+        }
+    }
+    return NULL;
+}
+
+void *vnsDeterministicWorker(void *arg) {
+    struct VNSWorker *worker = arg;
+    struct VNSShared *shared = worker->shared;
+    int numNodes = shared->graph->numNodes;
+    long long round = 0;
+    struct TourHashSet *visited = shared->visitedCache ? &worker->visited : NULL;
+    if (visited != NULL) {
+        tourHashSetClear(visited);
+    }
+
+    while (true) {
+        // The incumbent only changes between rounds, so no lock is needed to read it
+        memcpy(worker->currentTour, shared->incumbent, numNodes * sizeof(int));
+        memcpy(worker->currentPos, shared->incumbentPos, numNodes * sizeof(int));
+        worker->currentHash = shared->incumbentHash;
+
+        struct Rng rng;
+        rngSeed(&rng, vnsStreamSeed(shared->seed, round, worker->id));
+        shared->roundLengths[worker->id] = vnsTrial(shared->graph, worker->currentTour, worker->currentPos, shared->candidates,
+                                                    shared->roundK, shared->variant, shared->incumbentLength, &rng,
+                                                    &worker->currentHash, visited);
+        atomic_fetch_add(&shared->trials, 1);
+        if (shared->roundLengths[worker->id] == DBL_MAX) {
+            atomic_fetch_add(&shared->cachedTrials, 1);
+        }
+
+        // Barrier: the last worker to arrive decides the round
+        pthread_mutex_lock(&shared->lock);
+        int generation = shared->roundGeneration;
+        shared->arrived++;
+        if (shared->arrived == shared->numThreads) {
+            int winner = 0;
+            for (int w = 1; w < shared->numThreads; w++) {
+                if (shared->roundLengths[w] < shared->roundLengths[winner]) {
+                    winner = w;
                 }
-                k = 1; // Reset k
+            }
+            shared->roundWinner = -1;
+            if (shared->roundLengths[winner] < shared->incumbentLength - 1e-9) {
+                shared->roundWinner = winner;
+                shared->roundK = 1;
             } else {
-                k++; // Increment k
+                // Only skewed VNS can accept a non-improving trial, the winner checks it below
+                shared->roundWinner = shared->variant == VNS_SKEWED ? winner : -1;
+                if (++shared->roundK > shared->kmax) {
+                    shared->roundK = 1;
+                    if (++shared->sweepsDone >= shared->maxSweeps) {
+                        shared->finished = true;
+                    }
+                }
+            }
+            if (vnsShouldStop(shared)) {
+                shared->finished = true;
+            }
+            shared->arrived = 0;
+            shared->roundGeneration++;
+            pthread_cond_broadcast(&shared->roundCond);
+        } else {
+            while (generation == shared->roundGeneration) {
+                pthread_cond_wait(&shared->roundCond, &shared->lock);
+            }
+        }
+        int winner = shared->roundWinner;
+        bool finished = shared->finished;
+        pthread_mutex_unlock(&shared->lock);
+
+        // The winner installs its own tour while the others wait at the second barrier
+        if (winner == worker->id) {
+            double length = shared->roundLengths[winner];
+            if (vnsAccept(shared->variant, shared->skewAlpha, length, shared->incumbentLength, worker->currentTour, shared->incumbentPos, numNodes)) {
+                memcpy(shared->incumbent, worker->currentTour, numNodes * sizeof(int));
+                memcpy(shared->incumbentPos, worker->currentPos, numNodes * sizeof(int));
+                shared->incumbentLength = length;
+                shared->incumbentHash = worker->currentHash;
+                if (length < shared->installedLength - 1e-9) {
+                    memcpy(shared->tour, worker->currentTour, numNodes * sizeof(int));
+                    memcpy(shared->pos, worker->currentPos, numNodes * sizeof(int));
+                    shared->installedLength = length;
+                    shared->installedHash = worker->currentHash;
+                    atomic_store(&shared->bestLength, length);
+                    traceImprove(shared->trace, length, atomic_load_explicit(&shared->trials, memory_order_relaxed));
+                }
             }
         }
 
-        iteration++;
+        pthread_mutex_lock(&shared->lock);
+        generation = shared->roundGeneration;
+        if (++shared->arrived == shared->numThreads) {
+            shared->arrived = 0;
+            shared->roundGeneration++;
+            pthread_cond_broadcast(&shared->roundCond);
+        } else {
+            while (generation == shared->roundGeneration) {
+                pthread_cond_wait(&shared->roundCond, &shared->lock);
+            }
+        }
+        pthread_mutex_unlock(&shared->lock);
+
+        if (finished) {
+            break;
+        }
+        round++;
     }
+    return NULL;
 }
 
+// Parameters, random seed and scratch space of VNS runs. vnsContextInit allocates the
+// shared state and candidate lists once; worker slots grow on demand, so a context is
+// reused across runs and instances without reallocating. Concurrent runs need a context
+// each.
+struct VNSContext {
+    int kmax;               // Maximum shaking intensity
+    int maxIterations;      // k = 1..kmax sweeps over all workers together
+    int numThreads;         // Worker threads (0 = one per online core, 1 = on the calling thread)
+    int variant;
+    bool deterministic;     // Replay mode: synchronous rounds, results depend only on seed and thread count
+    bool localShaking;      // Shake among candidate neighbors and repair only around the touched cities
+    bool visitedCache;      // Skip the repair of perturbed tours that were already searched (not
+                            // with VNS_SKEWED, whose acceptance may take a revisited tour)
+    double timeLimit;       // Wall-clock budget in seconds (0 = iterations only)
+    double skewAlpha;       // Skewed VNS: credit per differing edge, as a fraction of the average edge length
+    unsigned long long seed;   // Base seed of the worker RNG streams
+    struct Trace *trace;       // Convergence trace (NULL = none), iterations counted in trials
+    struct RunControl *control;   // Deadline, target and cancellation (NULL = none)
+
+    long long trialCount;   // Shake + local search trials performed by the last run
+    long long cachedTrials; // Trials of the last run answered by the visited cache
+
+    struct VNSShared *shared;
+    struct VNSWorker *workers;
+    pthread_t *threads;
+    int workerCapacity;
+    struct SpatialGrid *grid;
+    struct CandidateList *candidates;
+};
+
+void vnsContextInit(struct VNSContext *ctx) {
+    ctx->kmax = 10;
+    ctx->maxIterations = VNS_MAX_ITERATIONS;
+    ctx->numThreads = 0;
+    ctx->variant = VNS_BASIC;
+    ctx->deterministic = false;
+    ctx->localShaking = true;
+    ctx->visitedCache = true;
+    ctx->timeLimit = 0.0;
+    ctx->skewAlpha = 0.05;
+    ctx->seed = 1;
+    ctx->trace = NULL;
+    ctx->control = NULL;
+    ctx->trialCount = 0;
+    ctx->cachedTrials = 0;
+    ctx->shared = malloc(sizeof(struct VNSShared));
+    ctx->workers = NULL;
+    ctx->threads = NULL;
+    ctx->workerCapacity = 0;
+    ctx->grid = malloc(sizeof(struct SpatialGrid));
+    ctx->candidates = malloc(sizeof(struct CandidateList));
+}
 
-#endif
+void vnsContextFree(struct VNSContext *ctx) {
+    free(ctx->candidates);
+    free(ctx->grid);
+    free(ctx->threads);
+    free(ctx->workers);
+    free(ctx->shared);
+}
 
+// Runs VNS with ctx->numThreads workers. Every worker runs independent (shake, local
+// search) trials on private copies; ctx->maxIterations counts k = 1..kmax sweeps over
+// all workers together and ctx->timeLimit bounds the wall-clock time. tour receives the
+// best tour found, also when the time limit cuts the run short.
+void vnsAlgorithm(struct VNSContext *ctx, struct Graph *graph, int *tour) {
+    int numThreads = ctx->numThreads;
+    if (numThreads <= 0) {
+        numThreads = availableCores();
+    }
+    if (numThreads > VNS_MAX_THREADS) {
+        numThreads = VNS_MAX_THREADS;
+    }
+    if (numThreads > ctx->workerCapacity) {
+        free(ctx->workers);
+        free(ctx->threads);
+        ctx->workers = malloc(numThreads * sizeof(struct VNSWorker));
+        ctx->threads = malloc(numThreads * sizeof(pthread_t));
+        ctx->workerCapacity = numThreads;
+    }
+    double startTime = currentTimeSeconds();
+    traceStart(ctx->trace, calculateTourLength(graph, tour));
+    runBegin(ctx->control);
+
+    struct VNSShared *shared = ctx->shared;
+    struct VNSWorker *workers = ctx->workers;
+    pthread_t *threads = ctx->threads;
+    int numNodes = graph->numNodes;
+    int maxIterations = ctx->maxIterations;
+
+    shared->graph = graph;
+    shared->candidates = vnsPrepareLocalSearch(graph, tour, shared->pos, ctx->variant, ctx->localShaking, ctx->grid, ctx->candidates);
+    shared->tour = tour;
+    shared->installedLength = calculateTourLength(graph, tour);
+    shared->installedHash = tourHash(tour, numNodes);
+    atomic_init(&shared->bestLength, shared->installedLength);
+    pthread_mutex_init(&shared->lock, NULL);
+    pthread_cond_init(&shared->roundCond, NULL);
+    atomic_init(&shared->sweepsLeft, maxIterations);
+    atomic_init(&shared->trials, 0);
+    atomic_init(&shared->cachedTrials, 0);
+    shared->kmax = ctx->kmax;
+    shared->variant = ctx->variant;
+    shared->skewAlpha = ctx->skewAlpha;
+    // A cache hit stands for a rejected tour, which the skewed acceptance may still take
+    shared->visitedCache = ctx->visitedCache && ctx->variant != VNS_SKEWED;
+    shared->numThreads = numThreads;
+    shared->deadline = ctx->timeLimit > 0.0 ? startTime + ctx->timeLimit : 0.0;
+    shared->seed = ctx->seed;
+    shared->trace = ctx->trace;
+    shared->control = ctx->control;
+    traceImprove(ctx->trace, shared->installedLength, 0);
+    shared->arrived = 0;
+    shared->roundGeneration = 0;
+    shared->roundK = 1;
+    shared->sweepsDone = 0;
+    shared->maxSweeps = maxIterations;
+    shared->roundWinner = -1;
+    shared->finished = maxIterations <= 0 || numNodes < 4;
+    memcpy(shared->incumbent, tour, numNodes * sizeof(int));
+    memcpy(shared->incumbentPos, shared->pos, numNodes * sizeof(int));
+    shared->incumbentLength = shared->installedLength;
+    shared->incumbentHash = shared->installedHash;
+
+    void *(*workerMain)(void *) = ctx->deterministic ? vnsDeterministicWorker : vnsFreeWorker;
+    if (!shared->finished) {
+        for (int t = 0; t < numThreads; t++) {
+            workers[t].shared = shared;
+            workers[t].id = t;
+        }
+        if (numThreads == 1) {
+            workerMain(&workers[0]);
+        } else {
+            for (int t = 0; t < numThreads; t++) {
+                perfThreadCreate(&threads[t], NULL, workerMain, &workers[t]);
+            }
+            for (int t = 0; t < numThreads; t++) {
+                pthread_join(threads[t], NULL);
+            }
+        }
+    }
+
+    ctx->trialCount = atomic_load(&shared->trials);
+    runEnd(ctx->control, shared->installedLength, ctx->trialCount);
+    ctx->cachedTrials = atomic_load(&shared->cachedTrials);
+
+    pthread_mutex_destroy(&shared->lock);
+    pthread_cond_destroy(&shared->roundCond);
+}
+
+
+#endif
@@ -0,0 +1,70 @@
+// WARMSTART.h - The header file for warm starts from previous tours
+// Reads the tour of an earlier run, either the ---Final Tour--- section of a results file
+// written by writeOutput or the TOUR_SECTION of a TSPLIB .tour file, so a solver can
+// continue from it instead of from a constructed tour. Both list node ids, which are
+// mapped back to the indices of the graph; ids move with their cities in renumberGraph,
+// so the tour comes out in the numbering of whichever graph is passed.
+
+#ifndef WARMSTART_H
+#define WARMSTART_H
+
+struct IdIndex {
+    int id;
+    int index;
+};
+
+int compareIdIndex(const void *a, const void *b) {
+    const struct IdIndex *ia = a, *ib = b;
+    return (ia->id > ib->id) - (ia->id < ib->id);
+}
+
+// Reads the tour of a results file or a TSPLIB .tour file into tour, as indices of
+// graph. Returns false if the file cannot be opened, has no tour section, or its tour
+// is not a permutation of the cities of graph.
+bool loadTourFile(struct Graph *graph, const char *filename, int *tour) {
+    FILE *file = fopen(filename, "r");
+    if (file == NULL) {
+        return false;
+    }
+
+    // Skip to the tour section; the ids follow, on one line or one per line
+    char line[256];
+    bool found = false;
+    while (!found && fgets(line, sizeof(line), file) != NULL) {
+        found = strstr(line, "---Final Tour---") != NULL || strncmp(line, "TOUR_SECTION", 12) == 0;
+    }
+
+    int n = graph->numNodes;
+    int ids[MAX_NODES + 1];
+    int count = 0;
+    int id;
+    // A results file repeats the first city at the end, a .tour file ends with -1
+    while (found && count <= n && fscanf(file, "%d", &id) == 1 && id != -1) {
+        ids[count++] = id;
+    }
+    fclose(file);
+    if (count == n + 1 && ids[n] == ids[0]) {
+        count = n;
+    }
+    if (!found || n == 0 || count != n) {
+        return false;
+    }
+
+    struct IdIndex *byId = malloc(n * sizeof(struct IdIndex));
+    for (int i = 0; i < n; i++) {
+        byId[i].id = graph->nodes[i].id;
+        byId[i].index = i;
+    }
+    qsort(byId, n, sizeof(struct IdIndex), compareIdIndex);
+    bool valid = true;
+    for (int i = 0; i < n && valid; i++) {
+        struct IdIndex key = {ids[i], 0};
+        struct IdIndex *match = bsearch(&key, byId, n, sizeof(struct IdIndex), compareIdIndex);
+        valid = match != NULL;
+        tour[i] = valid ? match->index : -1;
+    }
+    free(byId);
+    return valid && isTourPermutation(tour, n);
+}
+
+#endif
@@ -7,15 +7,32 @@
 #include <dirent.h>
 
 #include "headers/TSPUTILS.h"
+#include "headers/TOURHASH.h"
+#include "headers/TRACE.h"
+#include "headers/RUNCONTROL.h"
+#include "headers/NEIGHBORS.h"
+#include "headers/MATCHING.h"
+#include "headers/CONSTRUCT.h"
+#include "headers/WARMSTART.h"
 #include "headers/LK.h"
 #include "headers/VNS.h"
+#include "headers/BACKBONE.h"
+#include "headers/MERGE.h"
 #include "headers/GPX.h"
+#include "headers/EAX.h"
 #include "headers/SA2OPT.h"
+#include "headers/SOLVERS.h"
+#include "headers/STATS.h"
+#include "headers/BATCH.h"
 
 int main() {
     struct Graph graph;
+    struct Graph inputGraph;
+    struct CityOrder order;
     char inputFilename[MAX_FILENAME_LENGTH];
     int tour[MAX_NODES];
+    int outputTour[MAX_NODES];
+    int mstParent[MAX_NODES];
     int choice;
     char algorithmName[MAX_ALGORITHM_NAME];
 
@@ -26,64 +43,15 @@ int main() {
     scanf("%d", &choice);
 
     if (choice == 2) {
-        // Batch mode
-        const char *instanceFolder = "input_problems/";
-        const char *algorithms[] = {"LK", "VNS", "GPX", "SA2OPT"};
-        const int numAlgorithms = 4;
-
-        struct dirent *entry;
-        DIR *dp = opendir(instanceFolder);
-        if (dp == NULL) {
-            perror("Failed to open input_problems folder");
-            return 1;
-        }
-
-        while ((entry = readdir(dp))) {
-            if (strstr(entry->d_name, ".tsp")) {
-                char fullPath[MAX_FILENAME_LENGTH];
-                snprintf(fullPath, sizeof(fullPath), "%s%s", instanceFolder, entry->d_name);
-
-                readInput(&graph, fullPath);
-                printf("\nLoaded instance: %s\n", fullPath);
-                printf("Number of nodes: %d\n", graph.numNodes);
-
-                struct timeval mstStart, mstEnd;
-                gettimeofday(&mstStart, NULL);
-                double mstLength = calculateMST(&graph);
-                gettimeofday(&mstEnd, NULL);
-                double mstTime = (mstEnd.tv_sec - mstStart.tv_sec) + (mstEnd.tv_usec - mstStart.tv_usec) / 1000000.0;
-
-                for (int a = 0; a < numAlgorithms; a++) {
-                    for (int i = 0; i < graph.numNodes; i++) {
-                        tour[i] = i;
-                    }
-
-                    struct timeval start, end;
-                    gettimeofday(&start, NULL);
-
-                    if (strcmp(algorithms[a], "LK") == 0) {
-                        lkhAlgorithm(&graph, tour);
-                    } else if (strcmp(algorithms[a], "VNS") == 0) {
-                        vnsAlgorithm(&graph, tour, kmax, maxIterations);
-                    } else if (strcmp(algorithms[a], "GPX") == 0) {
-                        gpcxAlgorithm(&graph, tour);
-                    } else if (strcmp(algorithms[a], "SA2OPT") == 0) {
-                        twoOpt(&graph, tour);
-                    }
-
-                    gettimeofday(&end, NULL);
-                    double executionTime = (end.tv_sec - start.tv_sec) + (end.tv_usec - start.tv_usec) / 1000000.0;
-                    double finalTourLength = calculateTourLength(&graph, tour);
-
-                    writeOutput(&graph, tour, finalTourLength, mstLength, mstTime, executionTime, algorithms[a], fullPath, "results");
-
-                    printf("%s on %s completed in %.6f seconds\n", algorithms[a], entry->d_name, executionTime);
-                }
-            }
-        }
-
-        closedir(dp);
-        return 0;
+        // Batch mode: every (instance, algorithm, seed) triple is a job for the worker pool
+        printf("Insert the number of seeded runs per algorithm and instance and press Enter: ");
+        scanf("%d", &batchSeeds);
+        printf("Insert the seed of the first run and press Enter: ");
+        scanf("%llu", &batchBaseSeed);
+        printf("Continue from the tours of the previous results files (1 = yes, 0 = no) and press Enter: ");
+        scanf("%d", &choice);
+        batchWarmStart = choice == 1;
+        return runBatch("input_problems/");
     }
 
     // Manual mode
@@ -94,17 +62,15 @@ int main() {
         return 1;
     }
 
-    readInput(&graph, inputFilename);
+    readInput(&inputGraph, inputFilename);
+    graph = inputGraph;
+    renumberGraph(&graph, &order);
     printf("\nInstance loaded: %s\n", inputFilename);
     printf("Number of nodes: %d\n", graph.numNodes);
 
-    if (graph.numNodes < 100) {
-        printf("Warning: Small instance detected (<100 nodes). VNS may be unstable without proper parameter tuning.\n");
-    }
-
     struct timeval mstStart, mstEnd;
     gettimeofday(&mstStart, NULL);
-    double mstLength = calculateMST(&graph);
+    double mstLength = calculateMSTTree(&graph, mstParent);
     gettimeofday(&mstEnd, NULL);
     double mstTime = (mstEnd.tv_sec - mstStart.tv_sec) + (mstEnd.tv_usec - mstStart.tv_usec) / 1000000.0;
 
@@ -116,47 +82,130 @@ int main() {
     printf("  2. Variable Neighborhood Search (VNS)\n");
     printf("  3. Generalized Partition Crossover (GPX)\n");
     printf("  4. Simulated Annealing on 2-Opt Algorithm (SA2OPT)\n");
-    printf("Insert your choice (1-4) and press Enter: ");
+    printf("  5. Edge Assembly Crossover (EAX)\n");
+    printf("Insert your choice (1-5) and press Enter: ");
 
     scanf("%d", &choice);
 
+    int startChoice;
+    printf("\nSelect the start tour:\n");
+    printf("  1. Input order\n");
+    printf("  2. Nearest neighbor\n");
+    printf("  3. Greedy edge\n");
+    printf("  4. Space-filling curve\n");
+    printf("  5. MST doubling\n");
+    printf("  6. Christofides\n");
+    printf("  7. Previous tour (results file or TSPLIB .tour file)\n");
+    printf("Insert your choice (1-7) and press Enter: ");
+    scanf("%d", &startChoice);
+    if (startChoice >= 1 && startChoice <= 6) {
+        startMethod = startChoice - 1;
+    }
+    char tourFilename[100];
+    if (startChoice == 7) {
+        printf("Insert the path of the tour file (e.g. results/EAX_kroA150_results.txt) and press Enter: ");
+        scanf("%99s", tourFilename);
+    }
+
+    struct PerfRun constructionPerf, solverPerf;
+    perfRunBegin(&constructionPerf);
+    if (startChoice != 7 || !loadTourFile(&graph, tourFilename, tour)) {
+        if (startChoice == 7) {
+            printf("No tour of this instance in %s, starting from the greedy edge tour.\n", tourFilename);
+        }
+        constructTour(&graph, startMethod, mstParent, &order, tour);
+    }
+    perfRunEnd(&constructionPerf);
+    printf("Start tour length: %.2f\n", calculateTourLength(&graph, tour));
+
     // Εκτέλεση ενός μόνο αλγορίθμου
+    struct Trace *trace = malloc(sizeof(struct Trace));   // Convergence trace of the run
     struct timeval start, end;
+    perfRunBegin(&solverPerf);
     switch (choice) {
-        case 1:
+        case 1: {
+            struct LKContext lk;
+            lkContextInit(&lk);
+            lk.trace = trace;
             strncpy(algorithmName, "LK", MAX_ALGORITHM_NAME);
             gettimeofday(&start, NULL);
-            lkhAlgorithm(&graph, tour);
+            lkhAlgorithm(&lk, &graph, tour);
             gettimeofday(&end, NULL);
             break;
-        case 2:
+        }
+        case 2: {
+            struct VNSContext vns;
+            vnsContextInit(&vns);
+            vns.trace = trace;
             strncpy(algorithmName, "VNS", MAX_ALGORITHM_NAME);
-            srand(time(NULL));
+            printf("\nSelect the VNS variant:\n");
+            printf("  1. Basic VNS\n");
+            printf("  2. Reduced VNS (no local search)\n");
+            printf("  3. Skewed VNS\n");
+            printf("  4. General VNS (2-opt -> Or-opt descent)\n");
+            printf("Insert your choice (1-4) and press Enter: ");
+            scanf("%d", &vns.variant);
+            vns.variant = (vns.variant >= 1 && vns.variant <= 4) ? vns.variant - 1 : VNS_BASIC;
+            printf("Insert the time limit in seconds (0 for none) and press Enter: ");
+            scanf("%lf", &vns.timeLimit);
+            vns.seed = (unsigned long long) time(NULL);
+            printf("Seed: %llu\n", vns.seed);
             gettimeofday(&start, NULL);
-            vnsAlgorithm(&graph, tour, kmax, maxIterations);
+            vnsAlgorithm(&vns, &graph, tour);
             gettimeofday(&end, NULL);
+            vnsContextFree(&vns);
             break;
-        case 3:
+        }
+        case 3: {
+            struct GPXContext gpx;
+            gpxContextInit(&gpx);
+            gpx.trace = trace;
             strncpy(algorithmName, "GPX", MAX_ALGORITHM_NAME);
             gettimeofday(&start, NULL);
-            gpcxAlgorithm(&graph, tour);
+            gpcxAlgorithm(&gpx, &graph, tour);
             gettimeofday(&end, NULL);
+            gpxContextFree(&gpx);
             break;
-        case 4:
+        }
+        case 4: {
+            struct SAContext sa;
+            saContextInit(&sa);
+            sa.trace = trace;
             strncpy(algorithmName, "SA2OPT", MAX_ALGORITHM_NAME);
             gettimeofday(&start, NULL);
-            twoOpt(&graph, tour);
+            twoOpt(&sa, &graph, tour);
             gettimeofday(&end, NULL);
             break;
+        }
+        case 5: {
+            struct EAXContext eax;
+            eaxContextInit(&eax);
+            eax.trace = trace;
+            strncpy(algorithmName, "EAX", MAX_ALGORITHM_NAME);
+            gettimeofday(&start, NULL);
+            eaxAlgorithm(&eax, &graph, tour);
+            gettimeofday(&end, NULL);
+            eaxContextFree(&eax);
+            break;
+        }
         default:
             printf("Invalid choice. Exiting...\n");
             return 1;
     }
 
+    perfRunEnd(&solverPerf);
+
     double executionTime = (end.tv_sec - start.tv_sec) + (end.tv_usec - start.tv_usec) / 1000000.0;
     double finalTourLength = calculateTourLength(&graph, tour);
 
-    writeOutput(&graph, tour, finalTourLength, mstLength, mstTime, executionTime, algorithmName, inputFilename, "results");
+    mapTour(order.original, graph.numNodes, tour, outputTour);
+    writeOutput(&inputGraph, outputTour, finalTourLength, mstLength, mstTime, executionTime, algorithmName, inputFilename, "results");
+    writeTrace(trace, algorithmName, inputFilename, "results");
+    char resultsFile[100];
+    resultsFilename(resultsFile, sizeof(resultsFile), "results", algorithmName, inputFilename);
+    appendPerfCounters(resultsFile, "construction", &constructionPerf);
+    appendPerfCounters(resultsFile, "solver", &solverPerf);
+    free(trace);
 
     printf("\n%s executed successfully, with execution time: %.6f seconds\n", algorithmName, executionTime);
 
@@ -0,0 +1,79 @@
+// CHECK.h - The header file for the checks run by ctest
+// Every test program includes the solver headers through this file, checks conditions
+// with CHECK, which reports a failure and carries on, and returns checkResult() from
+// main, so one run lists every failed check. Test data is generated from fixed seeds;
+// files go to a fresh folder under /tmp.
+
+#ifndef CHECK_H
+#define CHECK_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+#include <sys/time.h>
+#include <string.h>
+#include <dirent.h>
+
+#include "../headers/TSPUTILS.h"
+#include "../headers/TOURHASH.h"
+#include "../headers/TRACE.h"
+#include "../headers/RUNCONTROL.h"
+#include "../headers/NEIGHBORS.h"
+#include "../headers/MATCHING.h"
+#include "../headers/CONSTRUCT.h"
+#include "../headers/WARMSTART.h"
+#include "../headers/LK.h"
+#include "../headers/VNS.h"
+#include "../headers/BACKBONE.h"
+#include "../headers/MERGE.h"
+#include "../headers/GPX.h"
+#include "../headers/EAX.h"
+#include "../headers/SA2OPT.h"
+#include "../headers/SOLVERS.h"
+#include "../headers/DYNAMIC.h"
+#include "../headers/STATS.h"
+#include "../headers/BATCH.h"
+
+int checkFailures = 0;
+
+#define CHECK(condition)                                                          \
+    do {                                                                          \
+        if (!(condition)) {                                                       \
+            printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+            checkFailures++;                                                      \
+        }                                                                         \
+    } while (0)
+
+// Exit code of a test program: 0 if every check passed
+int checkResult(const char *name) {
+    if (checkFailures > 0) {
+        printf("%s: %d checks failed\n", name, checkFailures);
+        return 1;
+    }
+    printf("%s: all checks passed\n", name);
+    return 0;
+}
+
+// n cities with ids 1 .. n, uniform in a size x size square
+void randomGraph(struct Graph *graph, int n, double size, unsigned long long seed) {
+    struct Rng rng;
+    rngSeed(&rng, seed);
+    for (int i = 0; i < n; i++) {
+        graph->nodes[i].id = i + 1;
+        graph->nodes[i].x = rngDouble(&rng) * size;
+        graph->nodes[i].y = rngDouble(&rng) * size;
+    }
+    graph->numNodes = n;
+}
+
+// Makes a fresh folder under /tmp for the files of a test into folder
+void checkTempFolder(char *folder, size_t size) {
+    snprintf(folder, size, "/tmp/tsp_check_XXXXXX");
+    if (mkdtemp(folder) == NULL) {
+        perror("mkdtemp");
+        exit(1);
+    }
+}
+
+#endif
@@ -0,0 +1,131 @@
+// Checks of the batch scheduler's work-stealing deques (BATCH.h): the owner takes its
+// newest job, thieves the oldest, and with an owner and thieves racing every job is
+// taken exactly once, the last one of a deque included.
+
+#include "CHECK.h"
+
+#define BATCH_THIEVES 3
+#define BATCH_JOBS 100000
+#define BATCH_ROUNDS 2000
+
+struct DequeRace {
+    struct WorkDeque deque;
+    int numJobs;
+    bool ownerPushes;        // The owner pushes while the thieves steal, instead of before
+    atomic_int taken[BATCH_JOBS];
+    atomic_int numTaken;
+    atomic_int numStrays;    // Values that are neither a job nor DEQUE_EMPTY
+    atomic_bool started;
+};
+
+struct DequeRace race;
+
+void takeJob(int job) {
+    if (job >= 0 && job < race.numJobs) {
+        atomic_fetch_add(&race.taken[job], 1);
+        atomic_fetch_add(&race.numTaken, 1);
+    } else if (job != DEQUE_EMPTY) {
+        atomic_fetch_add(&race.numStrays, 1);
+    }
+}
+
+void *ownerThread(void *arg) {
+    (void) arg;
+    while (!atomic_load(&race.started)) {
+    }
+    if (race.ownerPushes) {
+        // A pop after each push, so every pop races the thieves for the last job
+        for (int job = 0; job < race.numJobs; job++) {
+            dequePush(&race.deque, job);
+            takeJob(dequePop(&race.deque));
+        }
+    }
+    int job;
+    while ((job = dequePop(&race.deque)) != DEQUE_EMPTY) {
+        takeJob(job);
+    }
+    return NULL;
+}
+
+void *thiefThread(void *arg) {
+    (void) arg;
+    while (!atomic_load(&race.started)) {
+    }
+    // Until every job is taken, as the owner may still push
+    while (atomic_load(&race.numTaken) < race.numJobs) {
+        int job = dequeSteal(&race.deque);
+        if (job != DEQUE_ABORT) {
+            takeJob(job);
+        }
+    }
+    return NULL;
+}
+
+// One owner and BATCH_THIEVES thieves take numJobs jobs; every job must be taken once
+void runRace(int numJobs, bool ownerPushes) {
+    dequeInit(&race.deque, numJobs);
+    race.numJobs = numJobs;
+    race.ownerPushes = ownerPushes;
+    for (int job = 0; job < numJobs; job++) {
+        atomic_init(&race.taken[job], 0);
+        if (!ownerPushes) {
+            dequePush(&race.deque, job);
+        }
+    }
+    atomic_init(&race.numTaken, 0);
+    atomic_init(&race.numStrays, 0);
+    atomic_init(&race.started, false);
+
+    pthread_t owner, thieves[BATCH_THIEVES];
+    pthread_create(&owner, NULL, ownerThread, NULL);
+    for (int t = 0; t < BATCH_THIEVES; t++) {
+        pthread_create(&thieves[t], NULL, thiefThread, NULL);
+    }
+    atomic_store(&race.started, true);
+    pthread_join(owner, NULL);
+    for (int t = 0; t < BATCH_THIEVES; t++) {
+        pthread_join(thieves[t], NULL);
+    }
+
+    int wrong = 0;
+    for (int job = 0; job < numJobs; job++) {
+        wrong += atomic_load(&race.taken[job]) != 1;
+    }
+    CHECK(wrong == 0);
+    CHECK(atomic_load(&race.numTaken) == numJobs);
+    CHECK(atomic_load(&race.numStrays) == 0);
+    free(race.deque.slots);
+}
+
+void checkOrder(void) {
+    struct WorkDeque deque;
+    dequeInit(&deque, 5);
+    CHECK(dequePop(&deque) == DEQUE_EMPTY);
+    CHECK(dequeSteal(&deque) == DEQUE_EMPTY);
+    for (int job = 0; job < 5; job++) {
+        dequePush(&deque, job);
+    }
+    CHECK(dequePop(&deque) == 4);
+    CHECK(dequeSteal(&deque) == 0);
+    CHECK(dequeSteal(&deque) == 1);
+    CHECK(dequePop(&deque) == 3);
+    CHECK(dequePop(&deque) == 2);
+    CHECK(dequePop(&deque) == DEQUE_EMPTY);
+    CHECK(dequeSteal(&deque) == DEQUE_EMPTY);
+    free(deque.slots);
+}
+
+void checkRaces(void) {
+    runRace(BATCH_JOBS, false);
+    runRace(BATCH_JOBS, true);
+    // Many short races, where the owner and the thieves meet at the last job
+    for (int round = 0; round < BATCH_ROUNDS; round++) {
+        runRace(1 + round % 4, round % 2 == 1);
+    }
+}
+
+int main(void) {
+    checkOrder();
+    checkRaces();
+    return checkResult("batch");
+}
@@ -0,0 +1,197 @@
+// Checks of the daemon (DAEMON.h): request parsing; the instance cache, with hits and
+// misses, a file and the same cities sent inline sharing one entry, LRU eviction of
+// unused entries only, and instances served without a free slot; and a daemon on a
+// socket serving pipelined requests in order while an idle client holds no worker.
+
+#include "CHECK.h"
+#include "../headers/DAEMON.h"
+
+struct DaemonCache cache;
+
+// A request for n cities drawn from seed, as the daemon builds it
+struct CacheEntry *makeRequest(int n, unsigned long long seed) {
+    struct CacheEntry *request = malloc(sizeof(struct CacheEntry));
+    snprintf(request->instance.path, sizeof(request->instance.path), "check");
+    randomGraph(&request->instance.inputGraph, n, 100.0, seed);
+    return request;
+}
+
+struct CacheEntry *acquire(int n, unsigned long long seed, bool expectHit) {
+    bool hit;
+    struct CacheEntry *entry = cacheAcquire(&cache, makeRequest(n, seed), &hit);
+    CHECK(hit == expectHit);
+    CHECK(isTourPermutation(entry->instance.startTour, n));
+    return entry;
+}
+
+void checkParse(void) {
+    struct Graph *graph = malloc(sizeof(struct Graph));
+    char line[256];
+    const char *requests[][2] = {
+            {"", "missing instance"},
+            {"COORDS 0", "invalid number of cities"},
+            {"COORDS x", "invalid number of cities"},
+            {"COORDS 2 1 1 2", "missing coordinates"},
+            {"SHAPES 1 1 1", "unknown instance kind"},
+            {"FILE /nonexistent/cities.txt", "cannot read the instance file"},
+    };
+    for (int r = 0; r < (int) (sizeof(requests) / sizeof(requests[0])); r++) {
+        snprintf(line, sizeof(line), "%s", requests[r][0]);
+        const char *error = parseRequestInstance(line, graph);
+        if (error == NULL || strcmp(error, requests[r][1]) != 0) {
+            printf("\"%s\" gave \"%s\"\n", requests[r][0], error != NULL ? error : "no error");
+            checkFailures++;
+        }
+    }
+
+    snprintf(line, sizeof(line), "COORDS 3 0 0 1.5 0 0 2\n");
+    CHECK(parseRequestInstance(line, graph) == NULL);
+    CHECK(graph->numNodes == 3);
+    CHECK(graph->nodes[2].id == 3 && graph->nodes[1].x == 1.5 && graph->nodes[2].y == 2.0);
+    free(graph);
+}
+
+// The cities of an instance file and the same cities sent inline are one instance
+void checkFileMatchesCoords(void) {
+    char folder[64], path[128], line[256];
+    checkTempFolder(folder, sizeof(folder));
+    snprintf(path, sizeof(path), "%s/three.txt", folder);
+    FILE *file = fopen(path, "w");
+    fprintf(file, "1 0 0\n2 1.5 0\n3 0 2\n");
+    fclose(file);
+
+    struct Graph *fromFile = malloc(sizeof(struct Graph));
+    struct Graph *fromCoords = malloc(sizeof(struct Graph));
+    snprintf(line, sizeof(line), "FILE %s\n", path);
+    CHECK(parseRequestInstance(line, fromFile) == NULL);
+    snprintf(line, sizeof(line), "COORDS 3 0 0 1.5 0 0 2\n");
+    CHECK(parseRequestInstance(line, fromCoords) == NULL);
+    CHECK(graphHash(fromFile) == graphHash(fromCoords));
+    CHECK(sameGraph(fromFile, fromCoords));
+    fromCoords->nodes[1].x = 1.25;
+    CHECK(!sameGraph(fromFile, fromCoords));
+
+    remove(path);
+    rmdir(folder);
+    free(fromCoords);
+    free(fromFile);
+}
+
+void checkCache(void) {
+    pthread_mutex_init(&cache.lock, NULL);
+    daemonCacheSize = 2;
+
+    struct CacheEntry *a = acquire(20, 1, false);
+    cacheRelease(&cache, a);
+    CHECK(acquire(20, 1, true) == a);
+    cacheRelease(&cache, a);
+    struct CacheEntry *b = acquire(25, 2, false);
+    cacheRelease(&cache, b);
+    CHECK(cache.numEntries == 2 && cache.hits == 1 && cache.misses == 2);
+
+    // A third instance evicts the least recently used one, a
+    struct CacheEntry *c = acquire(30, 3, false);
+    cacheRelease(&cache, c);
+    CHECK(cache.numEntries == 2 && cache.evictions == 1);
+    CHECK(cacheFind(&cache, b->hash, &b->instance.inputGraph) == b);
+    CHECK(cacheFind(&cache, c->hash, &c->instance.inputGraph) == c);
+
+    // With both entries in use there is nothing to evict: the new instance is served
+    // uncached and freed on release
+    b = acquire(25, 2, true);
+    c = acquire(30, 3, true);
+    struct CacheEntry *d = acquire(20, 1, false);
+    CHECK(!d->cached && d->refs == 1);
+    CHECK(cache.numEntries == 2 && cache.evictions == 1);
+    cacheRelease(&cache, d);
+    cacheRelease(&cache, b);
+    cacheRelease(&cache, c);
+    CHECK(b->refs == 0 && c->refs == 0);
+    CHECK(cache.solves == 7);
+
+    for (int e = 0; e < cache.numEntries; e++) {
+        free(cache.entries[e]);
+    }
+    pthread_mutex_destroy(&cache.lock);
+}
+
+void *daemonThread(void *arg) {
+    runDaemon(arg);
+    return NULL;
+}
+
+// Connects to the daemon once it listens, with a receive timeout so a missing response
+// fails the check instead of hanging it
+int connectDaemon(const char *path) {
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    snprintf(address.sun_path, sizeof(address.sun_path), "%s", path);
+    for (int attempt = 0; attempt < 500; attempt++) {
+        int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (connect(fd, (struct sockaddr *) &address, sizeof(address)) == 0) {
+            struct timeval timeout = {5, 0};
+            setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+            return fd;
+        }
+        close(fd);
+        usleep(10000);
+    }
+    printf("Cannot connect to %s\n", path);
+    exit(1);
+}
+
+// Reads one response line into line, without its end. Returns false on a timeout or EOF.
+bool readLine(int fd, char *line, size_t size) {
+    size_t length = 0;
+    char c;
+    while (read(fd, &c, 1) == 1) {
+        if (c == '\n') {
+            line[length] = '\0';
+            return true;
+        }
+        if (length + 1 < size) {
+            line[length++] = c;
+        }
+    }
+    return false;
+}
+
+void checkServing(void) {
+    char folder[64], path[128], line[256];
+    checkTempFolder(folder, sizeof(folder));
+    snprintf(path, sizeof(path), "%s/daemon.sock", folder);
+    daemonWorkers = 1;
+    daemonCacheSize = 4;
+    pthread_t thread;
+    pthread_create(&thread, NULL, daemonThread, path);
+
+    // A client that connects and sends nothing must not hold the only worker
+    int idle = connectDaemon(path);
+    int client = connectDaemon(path);
+    dprintf(client, "STATS\n");
+    CHECK(readLine(client, line, sizeof(line)) && strncmp(line, "OK ", 3) == 0);
+
+    // Requests sent together are answered in order, the last one even without a line end
+    dprintf(client, "STATS\nBOGUS\nSOLVE LK 0 1 COORDS 4 0 0 1 0 1 1 0 1");
+    shutdown(client, SHUT_WR);
+    CHECK(readLine(client, line, sizeof(line)) && strncmp(line, "OK ", 3) == 0);
+    CHECK(readLine(client, line, sizeof(line)) && strcmp(line, "ERROR unknown request") == 0);
+    CHECK(readLine(client, line, sizeof(line)) && strncmp(line, "OK 4.000000 ", 12) == 0);
+    // and the daemon closes the connection after the last response
+    CHECK(!readLine(client, line, sizeof(line)));
+    close(client);
+    close(idle);
+
+    pthread_kill(thread, SIGTERM);
+    pthread_join(thread, NULL);
+    rmdir(folder);
+}
+
+int main(void) {
+    checkParse();
+    checkFileMatchesCoords();
+    checkCache();
+    checkServing();
+    return checkResult("daemon");
+}
@@ -0,0 +1,232 @@
+// Checks of the dynamic tours (DYNAMIC.h): after every batch of random insertions and
+// removals the linked tour, its length, the id table, the quadtree and the candidate
+// lists with their reverse lists must all agree with a recomputation from scratch.
+
+#include "CHECK.h"
+
+// Checks the subtree of node and returns how many cities it holds
+int checkQuadNode(struct DynamicTour *dyn, int node, int parent, int *numNodes) {
+    struct DynamicQuadtree *tree = &dyn->tree;
+    struct QuadNode *q = &tree->nodes[node];
+    CHECK(q->parent == parent);
+    (*numNodes)++;
+    int count = 0;
+    if (q->child[0] >= 0) {
+        CHECK(q->head < 0 && q->count > DYNAMIC_LEAF_CITIES / 2);
+        for (int c = 0; c < 4; c++) {
+            struct QuadNode *child = &tree->nodes[q->child[c]];
+            CHECK(2.0 * child->size == q->size);
+            count += checkQuadNode(dyn, q->child[c], node, numNodes);
+        }
+    }
+    double slack = 1e-9 * (1.0 + q->size + fabs(q->minX) + fabs(q->minY));
+    for (int city = q->head; city >= 0; city = tree->next[city]) {
+        struct Node *at = &dyn->graph.nodes[city];
+        CHECK(tree->leaf[city] == node);
+        CHECK(at->x >= q->minX - slack && at->x <= q->minX + q->size + slack);
+        CHECK(at->y >= q->minY - slack && at->y <= q->minY + q->size + slack);
+        count++;
+    }
+    CHECK(count == q->count);
+    return count;
+}
+
+// Everything the updates keep incrementally, recomputed
+void checkConsistent(struct DynamicTour *dyn) {
+    int n = dyn->graph.numNodes;
+    int tour[MAX_NODES];
+    for (int i = 0, city = 0; i < n; i++, city = dyn->succ[city]) {
+        tour[i] = city;
+        CHECK(dyn->pred[dyn->succ[city]] == city);
+    }
+    CHECK(n == 0 || (isTourPermutation(tour, n) && dyn->succ[tour[n - 1]] == 0));
+    double length = n > 1 ? calculateTourLength(&dyn->graph, tour) : 0.0;
+    CHECK(fabs(length - dyn->length) <= 1e-6 * fmax(1.0, length));
+
+    for (int i = 0; i < n; i++) {
+        CHECK(dynamicCity(dyn, dyn->graph.nodes[i].id) == i);
+    }
+
+    // Every city in the leaf covering it, counts adding up, no internal node under half a
+    // leaf of cities
+    int numNodes = 0;
+    CHECK(checkQuadNode(dyn, dyn->tree.root, -1, &numNodes) == n);
+
+    struct CandidateList *candidates = &dyn->candidates;
+    CHECK(candidates->count == (n - 1 < DYNAMIC_CANDIDATES ? (n > 1 ? n - 1 : 0) : DYNAMIC_CANDIDATES));
+    for (int u = 0; u < n; u++) {
+        for (int m = 0; m < candidates->count; m++) {
+            int w = candidates->neighbors[u][m];
+            CHECK(w >= 0 && w < n && w != u);
+            bool listed = false;
+            for (int r = 0; w >= 0 && w < n && r < dyn->listedBy[w].count; r++) {
+                listed |= dyn->listedBy[w].cities[r] == u;
+            }
+            CHECK(listed);
+        }
+        for (int r = 0; r < dyn->listedBy[u].count; r++) {
+            int by = dyn->listedBy[u].cities[r];
+            bool holds = false;
+            for (int m = 0; by >= 0 && by < n && m < candidates->count; m++) {
+                holds |= candidates->neighbors[by][m] == u;
+            }
+            CHECK(holds);
+        }
+    }
+}
+
+// The quadtree's nearest cities against a scan of all of them
+void checkNearest(struct DynamicTour *dyn, struct Rng *rng) {
+    int n = dyn->graph.numNodes;
+    for (int q = 0; q < 200; q++) {
+        struct Node query = {-1, rngDouble(rng) * 1200.0 - 100.0, rngDouble(rng) * 1200.0 - 100.0};
+        int near[DYNAMIC_CANDIDATES];
+        double nearDist[DYNAMIC_CANDIDATES];
+        int found = quadNearest(&dyn->tree, &dyn->graph, query.x, query.y, 0, DYNAMIC_CANDIDATES, near, nearDist);
+        CHECK(found == DYNAMIC_CANDIDATES);
+        int closer = 0;
+        for (int i = 1; i < n; i++) {
+            closer += calculateDistance(query, dyn->graph.nodes[i]) < nearDist[found - 1];
+        }
+        CHECK(closer < found);
+        for (int m = 0; m < found; m++) {
+            CHECK(near[m] != 0 && nearDist[m] == calculateDistance(query, dyn->graph.nodes[near[m]]));
+        }
+    }
+}
+
+// 20000 random updates on a tour of 300 to 1300 cities
+void checkRandomUpdates(void) {
+    struct Graph *graph = malloc(sizeof(struct Graph));
+    randomGraph(graph, 600, 1000.0, 1);
+    int tour[MAX_NODES];
+    constructTour(graph, START_GREEDY_EDGE, NULL, NULL, tour);
+    struct DynamicTour *dyn = malloc(sizeof(struct DynamicTour));
+    dynamicTourInit(dyn, graph, tour);
+    checkConsistent(dyn);
+
+    struct Rng rng;
+    rngSeed(&rng, 2);
+    int nextId = 1000;
+    for (int op = 1; op <= 20000; op++) {
+        int n = dyn->graph.numNodes;
+        bool insert = n < 300 || (n < 1300 && rngInt(&rng, 2) == 0);
+        if (insert) {
+            CHECK(dynamicInsert(dyn, nextId++, rngDouble(&rng) * 1000.0, rngDouble(&rng) * 1000.0));
+        } else {
+            CHECK(dynamicRemove(dyn, dyn->graph.nodes[rngInt(&rng, n)].id));
+        }
+        if (op % 500 == 0) {
+            checkConsistent(dyn);
+        }
+    }
+    checkNearest(dyn, &rng);
+    dynamicTourFree(dyn);
+    free(dyn);
+    free(graph);
+}
+
+void checkIds(void) {
+    struct Graph *graph = malloc(sizeof(struct Graph));
+    randomGraph(graph, 50, 100.0, 3);
+    int tour[MAX_NODES];
+    constructTour(graph, START_INPUT_ORDER, NULL, NULL, tour);
+    struct DynamicTour *dyn = malloc(sizeof(struct DynamicTour));
+    dynamicTourInit(dyn, graph, tour);
+
+    CHECK(!dynamicInsert(dyn, 7, 1.0, 1.0));   // Taken
+    CHECK(!dynamicRemove(dyn, 51));            // Unknown
+    CHECK(dynamicRemove(dyn, 7));
+    CHECK(dynamicCity(dyn, 7) == -1);
+    CHECK(!dynamicRemove(dyn, 7));
+    CHECK(dynamicInsert(dyn, 7, 1.0, 1.0));
+    CHECK(dynamicCity(dyn, 7) >= 0);
+    CHECK(dyn->graph.numNodes == 50);
+    checkConsistent(dyn);
+    dynamicTourFree(dyn);
+    free(dyn);
+    free(graph);
+}
+
+// Down to no city and back, through the sizes where the candidate lists are rebuilt
+void checkShrinkAndGrow(void) {
+    struct Graph *graph = malloc(sizeof(struct Graph));
+    randomGraph(graph, 40, 100.0, 4);
+    int tour[MAX_NODES];
+    constructTour(graph, START_GREEDY_EDGE, NULL, NULL, tour);
+    struct DynamicTour *dyn = malloc(sizeof(struct DynamicTour));
+    dynamicTourInit(dyn, graph, tour);
+
+    struct Rng rng;
+    rngSeed(&rng, 5);
+    while (dyn->graph.numNodes > 0) {
+        CHECK(dynamicRemove(dyn, dyn->graph.nodes[rngInt(&rng, dyn->graph.numNodes)].id));
+        checkConsistent(dyn);
+    }
+    CHECK(dyn->length == 0.0);
+    for (int id = 1; id <= 40; id++) {
+        CHECK(dynamicInsert(dyn, id, rngDouble(&rng) * 100.0, rngDouble(&rng) * 100.0));
+        checkConsistent(dyn);
+    }
+    dynamicTourFree(dyn);
+    free(dyn);
+    free(graph);
+}
+
+// A tour started in a unit box and grown far outside it, then emptied, keeps a tree that
+// fits its cities
+void checkTreeFollowsTour(void) {
+    struct Graph *graph = malloc(sizeof(struct Graph));
+    randomGraph(graph, 10, 1.0, 6);
+    int tour[MAX_NODES];
+    constructTour(graph, START_INPUT_ORDER, NULL, NULL, tour);
+    struct DynamicTour *dyn = malloc(sizeof(struct DynamicTour));
+    dynamicTourInit(dyn, graph, tour);
+
+    struct Rng rng;
+    rngSeed(&rng, 7);
+    for (int id = 11; id <= 1000; id++) {
+        double x = rngDouble(&rng) * 1000.0 - 500.0, y = rngDouble(&rng) * 1000.0 - 500.0;
+        CHECK(dynamicInsert(dyn, id, x, y));
+        CHECK(quadContains(&dyn->tree.nodes[dyn->tree.root], x, y));
+    }
+    checkConsistent(dyn);
+    for (int id = 1; id <= 1000; id++) {
+        CHECK(dynamicRemove(dyn, id));
+    }
+    int numNodes = 0;
+    CHECK(checkQuadNode(dyn, dyn->tree.root, -1, &numNodes) == 0 && numNodes == 1);
+    dynamicTourFree(dyn);
+    free(dyn);
+    free(graph);
+}
+
+// Cities at one point cannot be split apart and share a leaf
+void checkCoincident(void) {
+    struct Graph *graph = malloc(sizeof(struct Graph));
+    randomGraph(graph, 20, 100.0, 8);
+    int tour[MAX_NODES];
+    constructTour(graph, START_INPUT_ORDER, NULL, NULL, tour);
+    struct DynamicTour *dyn = malloc(sizeof(struct DynamicTour));
+    dynamicTourInit(dyn, graph, tour);
+    for (int id = 100; id < 140; id++) {
+        CHECK(dynamicInsert(dyn, id, 50.0, 50.0));
+    }
+    checkConsistent(dyn);
+    for (int id = 100; id < 140; id += 2) {
+        CHECK(dynamicRemove(dyn, id));
+    }
+    checkConsistent(dyn);
+    dynamicTourFree(dyn);
+    free(dyn);
+    free(graph);
+}
+
+int main(void) {
+    checkRandomUpdates();
+    checkIds();
+    checkShrinkAndGrow();
+    checkTreeFollowsTour();
+    checkCoincident();
+    return checkResult("dynamic");
+}
@@ -0,0 +1,109 @@
+// Checks of the partition crossover (GPX.h): the offspring of any two tours is a tour
+// of the same cities and never longer than the better parent, and parents that differ
+// in a few places split into partitions.
+
+#include "CHECK.h"
+
+// Reverses count random stretches of up to 10 cities
+void perturbTour(int *tour, int n, int count, struct Rng *rng) {
+    for (int r = 0; r < count; r++) {
+        int i = rngInt(rng, n - 10);
+        int j = i + 2 + rngInt(rng, 8);
+        for (; i < j; i++, j--) {
+            int swap = tour[i];
+            tour[i] = tour[j];
+            tour[j] = swap;
+        }
+    }
+}
+
+// Crosses the parents both ways round; returns the partitions found
+int checkOffspring(struct Graph *graph, int *parent1, int *parent2) {
+    int n = graph->numNodes;
+    int offspring[MAX_NODES];
+    double better = fmin(calculateTourLength(graph, parent1), calculateTourLength(graph, parent2));
+    int partitions = gpcxCrossover(graph, parent1, parent2, offspring);
+    CHECK(isTourPermutation(offspring, n));
+    CHECK(calculateTourLength(graph, offspring) <= better + 1e-9 * better);
+    CHECK(gpcxCrossover(graph, parent2, parent1, offspring) == partitions);
+    CHECK(isTourPermutation(offspring, n));
+    CHECK(calculateTourLength(graph, offspring) <= better + 1e-9 * better);
+    return partitions;
+}
+
+void checkConstructedParents(void) {
+    struct Graph *graph = malloc(sizeof(struct Graph));
+    int methods[] = {START_GREEDY_EDGE, START_NEAREST_NEIGHBOR, START_SPACE_FILLING_CURVE, START_CHRISTOFIDES};
+    for (unsigned long long seed = 1; seed <= 5; seed++) {
+        randomGraph(graph, 100 + 200 * (int) seed, 1000.0, seed);
+        int tours[4][MAX_NODES];
+        for (int m = 0; m < 4; m++) {
+            constructTour(graph, methods[m], NULL, NULL, tours[m]);
+        }
+        for (int a = 0; a < 4; a++) {
+            for (int b = a + 1; b < 4; b++) {
+                checkOffspring(graph, tours[a], tours[b]);
+            }
+        }
+    }
+    free(graph);
+}
+
+// A tour and a copy with a few stretches reversed differ in separate places, each of
+// which is a partition the crossover can take from the shorter parent
+void checkNearbyParents(void) {
+    struct Graph *graph = malloc(sizeof(struct Graph));
+    randomGraph(graph, 500, 1000.0, 6);
+    struct Rng rng;
+    rngSeed(&rng, 7);
+    int parent1[MAX_NODES], parent2[MAX_NODES];
+    constructTour(graph, START_GREEDY_EDGE, NULL, NULL, parent1);
+    for (int trial = 0; trial < 20; trial++) {
+        memcpy(parent2, parent1, sizeof(parent1));
+        perturbTour(parent2, 500, 5, &rng);
+        CHECK(checkOffspring(graph, parent1, parent2) > 0);
+    }
+    free(graph);
+}
+
+// Identical parents give the same tour back; unrelated ones and tiny instances still
+// give a valid offspring
+void checkDegenerateParents(void) {
+    struct Graph *graph = malloc(sizeof(struct Graph));
+    randomGraph(graph, 200, 1000.0, 8);
+    int parent1[MAX_NODES], parent2[MAX_NODES], offspring[MAX_NODES];
+    constructTour(graph, START_GREEDY_EDGE, NULL, NULL, parent1);
+    CHECK(gpcxCrossover(graph, parent1, parent1, offspring) == 0);
+    CHECK(fabs(calculateTourLength(graph, offspring) - calculateTourLength(graph, parent1)) < 1e-9);
+
+    struct Rng rng;
+    rngSeed(&rng, 9);
+    for (int i = 0; i < 200; i++) {
+        parent2[i] = i;
+    }
+    for (int i = 199; i > 0; i--) {
+        int j = rngInt(&rng, i + 1);
+        int swap = parent2[i];
+        parent2[i] = parent2[j];
+        parent2[j] = swap;
+    }
+    checkOffspring(graph, parent1, parent2);
+
+    for (int n = 1; n <= 4; n++) {
+        randomGraph(graph, n, 10.0, 10 + n);
+        for (int i = 0; i < n; i++) {
+            parent1[i] = i;
+            parent2[i] = n - 1 - i;
+        }
+        gpcxCrossover(graph, parent1, parent2, offspring);
+        CHECK(isTourPermutation(offspring, n));
+    }
+    free(graph);
+}
+
+int main(void) {
+    checkConstructedParents();
+    checkNearbyParents();
+    checkDegenerateParents();
+    return checkResult("gpx");
+}
@@ -0,0 +1,184 @@
+// Checks of the matchings (MATCHING.h): every matching of the cities is perfect, the
+// blossom algorithm finds the best matching an exhaustive search finds, and the
+// Christofides tour built on it is a tour no longer than the tree plus the matching.
+
+#include "CHECK.h"
+
+#define SMALL_VERTICES 12
+
+// Length of the matching mate of vertices[0 .. count), checking it is perfect
+double checkPerfect(struct Graph *graph, int *vertices, int count, int *mate) {
+    double length = 0.0;
+    for (int i = 0; i < count; i++) {
+        CHECK(mate[i] >= 0 && mate[i] < count && mate[i] != i && mate[mate[i]] == i);
+        if (mate[i] > i && mate[i] < count) {
+            length += calculateDistance(graph->nodes[vertices[i]], graph->nodes[vertices[mate[i]]]);
+        }
+    }
+    return length;
+}
+
+int lowestVertex(int mask) {
+    int i = 0;
+    while ((mask >> i & 1) == 0) {
+        i++;
+    }
+    return i;
+}
+
+// Shortest perfect matching of the first count cities, over all of them
+double exhaustiveMinimum(struct Graph *graph, int count) {
+    static double best[1 << SMALL_VERTICES];
+    best[0] = 0.0;
+    for (int mask = 1; mask < 1 << count; mask++) {
+        best[mask] = DBL_MAX;
+        int i = lowestVertex(mask);
+        for (int j = i + 1; j < count; j++) {
+            int rest = mask & ~(1 << i) & ~(1 << j);
+            if ((mask >> j & 1) && best[rest] < DBL_MAX) {
+                best[mask] = fmin(best[mask], best[rest] + calculateDistance(graph->nodes[i], graph->nodes[j]));
+            }
+        }
+    }
+    return best[(1 << count) - 1];
+}
+
+// Heaviest matching of n vertices under w (0 = no edge), vertices may stay unmatched
+long long exhaustiveMaximum(int n, const long long *w) {
+    static long long best[1 << SMALL_VERTICES];
+    best[0] = 0;
+    for (int mask = 1; mask < 1 << n; mask++) {
+        int i = lowestVertex(mask);
+        best[mask] = best[mask & ~(1 << i)];
+        for (int j = i + 1; j < n; j++) {
+            if ((mask >> j & 1) && w[i * n + j] > 0) {
+                long long weight = best[mask & ~(1 << i) & ~(1 << j)] + w[i * n + j];
+                best[mask] = weight > best[mask] ? weight : best[mask];
+            }
+        }
+    }
+    return best[(1 << n) - 1];
+}
+
+// Up to SMALL_VERTICES cities the candidate graph is complete, so the blossom matching
+// is the shortest perfect matching
+void checkBlossomShortest(void) {
+    struct Graph *graph = malloc(sizeof(struct Graph));
+    int vertices[SMALL_VERTICES], mate[SMALL_VERTICES];
+    for (int i = 0; i < SMALL_VERTICES; i++) {
+        vertices[i] = i;
+    }
+    for (unsigned long long seed = 1; seed <= 60; seed++) {
+        int count = 2 + 2 * (int) (seed % 5);
+        randomGraph(graph, count, 100.0, seed);
+        minimumWeightMatching(graph, vertices, count, MATCHING_BLOSSOM, mate);
+        double length = checkPerfect(graph, vertices, count, mate);
+        CHECK(fabs(length - exhaustiveMinimum(graph, count)) < 1e-6);
+    }
+    free(graph);
+}
+
+// The weighted blossom algorithm on sparse random weights, where odd cycles abound
+void checkBlossomWeights(void) {
+    struct Rng rng;
+    rngSeed(&rng, 2);
+    long long w[SMALL_VERTICES * SMALL_VERTICES];
+    int mate[SMALL_VERTICES];
+    for (int trial = 0; trial < 300; trial++) {
+        int n = 1 + rngInt(&rng, SMALL_VERTICES);
+        for (int i = 0; i < n; i++) {
+            w[i * n + i] = 0;
+            for (int j = i + 1; j < n; j++) {
+                w[i * n + j] = w[j * n + i] = rngInt(&rng, 3) == 0 ? 0 : 1 + rngInt(&rng, 100);
+            }
+        }
+        blossomMatching(n, w, mate);
+        long long weight = 0;
+        for (int i = 0; i < n; i++) {
+            if (mate[i] >= 0) {
+                CHECK(mate[i] < n && mate[mate[i]] == i && w[i * n + mate[i]] > 0);
+                weight += mate[i] > i ? w[i * n + mate[i]] : 0;
+            }
+        }
+        CHECK(weight == exhaustiveMaximum(n, w));
+    }
+}
+
+// On larger sets both methods match everything, the blossom one no longer than greedy
+void checkLargeSets(void) {
+    struct Graph *graph = malloc(sizeof(struct Graph));
+    int vertices[MAX_NODES], mate[MAX_NODES];
+    int sizes[] = {2, 50, 400, BLOSSOM_MAX_VERTICES + 100};
+    for (int s = 0; s < 4; s++) {
+        int count = sizes[s];
+        randomGraph(graph, count + 20, 1000.0, 10 + s);
+        for (int i = 0; i < count; i++) {
+            vertices[i] = i + 20;
+        }
+        minimumWeightMatching(graph, vertices, count, MATCHING_GREEDY, mate);
+        double greedy = checkPerfect(graph, vertices, count, mate);
+        minimumWeightMatching(graph, vertices, count, MATCHING_BLOSSOM, mate);
+        double blossom = checkPerfect(graph, vertices, count, mate);
+        CHECK(blossom <= greedy + 1e-9 * greedy);
+    }
+
+    // Four far apart clusters of 15 cities: the candidate graph stays inside the clusters
+    // and cannot match them all, so one city of each is paired across
+    for (int i = 0; i < 60; i++) {
+        graph->nodes[i].id = i + 1;
+        graph->nodes[i].x = (i / 15) * 1e4 + (i % 15);
+        graph->nodes[i].y = 0.0;
+        vertices[i] = i;
+    }
+    graph->numNodes = 60;
+    for (int method = MATCHING_BLOSSOM; method <= MATCHING_GREEDY; method++) {
+        minimumWeightMatching(graph, vertices, 60, method, mate);
+        checkPerfect(graph, vertices, 60, mate);
+    }
+    free(graph);
+}
+
+// Shortcutting the Euler tour of the tree plus the matching never lengthens it
+void checkChristofides(void) {
+    struct Graph *graph = malloc(sizeof(struct Graph));
+    for (int method = MATCHING_BLOSSOM; method <= MATCHING_GREEDY; method++) {
+        matchingMethod = method;
+        for (unsigned long long seed = 1; seed <= 4; seed++) {
+            int n = 50 + 300 * (int) seed;
+            randomGraph(graph, n, 1000.0, 20 + seed);
+            int parent[MAX_NODES], tour[MAX_NODES];
+            calculateMSTTree(graph, parent);
+            christofidesTour(graph, parent, tour);
+            CHECK(isTourPermutation(tour, n));
+
+            int degree[MAX_NODES] = {0}, odd[MAX_NODES], mate[MAX_NODES];
+            double tree = 0.0;
+            for (int v = 0; v < n; v++) {
+                if (parent[v] >= 0) {
+                    degree[v]++;
+                    degree[parent[v]]++;
+                    tree += calculateDistance(graph->nodes[v], graph->nodes[parent[v]]);
+                }
+            }
+            int numOdd = 0;
+            for (int v = 0; v < n; v++) {
+                if (degree[v] % 2 == 1) {
+                    odd[numOdd++] = v;
+                }
+            }
+            minimumWeightMatching(graph, odd, numOdd, method, mate);
+            double matching = checkPerfect(graph, odd, numOdd, mate);
+            CHECK(calculateTourLength(graph, tour) <= (tree + matching) * (1.0 + 1e-9));
+        }
+    }
+    matchingMethod = MATCHING_BLOSSOM;
+    free(graph);
+}
+
+int main(void) {
+    checkBlossomShortest();
+    checkBlossomWeights();
+    checkLargeSets();
+    checkChristofides();
+    return checkResult("matching");
+}
@@ -0,0 +1,189 @@
+// Checks of tour merging (MERGE.h): the merged tour is a tour of the same cities, uses
+// only edges of the tours merged and is no longer than the best of them, and on small
+// instances it is the shortest such tour keeping their shared edges that an exhaustive
+// search finds.
+
+#include "CHECK.h"
+
+#define SMALL_CITIES 9
+
+int (*tours)[MAX_NODES];
+
+// Reverses count random stretches of up to 10 cities
+void perturbTour(int *tour, int n, int count, struct Rng *rng) {
+    for (int r = 0; r < count; r++) {
+        int i = rngInt(rng, n - 10);
+        int j = i + 2 + rngInt(rng, 8);
+        for (; i < j; i++, j--) {
+            int swap = tour[i];
+            tour[i] = tour[j];
+            tour[j] = swap;
+        }
+    }
+}
+
+bool tourHasEdge(int *tour, int n, int a, int b) {
+    for (int i = 0; i < n; i++) {
+        int u = tour[i], v = tour[(i + 1) % n];
+        if ((u == a && v == b) || (u == b && v == a)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Merges the tours, the best first; returns whether the dynamic program solved it
+bool checkMerge(struct Graph *graph, int numTours, double *merged) {
+    int n = graph->numNodes;
+    int best = 0;
+    for (int t = 1; t < numTours; t++) {
+        if (calculateTourLength(graph, tours[t]) < calculateTourLength(graph, tours[best])) {
+            best = t;
+        }
+    }
+    int swap[MAX_NODES];
+    memcpy(swap, tours[0], sizeof(swap));
+    memcpy(tours[0], tours[best], sizeof(swap));
+    memcpy(tours[best], swap, sizeof(swap));
+
+    int tour[MAX_NODES];
+    bool solved = mergeTours(graph, tours, numTours, tour, 0, 1, NULL);
+    CHECK(isTourPermutation(tour, n));
+    *merged = calculateTourLength(graph, tour);
+    CHECK(*merged <= calculateTourLength(graph, tours[0]) * (1.0 + 1e-9));
+    if (solved) {
+        int unknown = 0;
+        for (int i = 0; i < n; i++) {
+            bool known = false;
+            for (int t = 0; t < numTours && !known; t++) {
+                known = tourHasEdge(tours[t], n, tour[i], tour[(i + 1) % n]);
+            }
+            unknown += !known;
+        }
+        CHECK(unknown == 0);
+    }
+    return solved;
+}
+
+// A tour and copies of it with a few stretches reversed: the frontier stays narrow, so
+// the dynamic program solves the merge
+void checkNearbyTours(void) {
+    struct Graph *graph = malloc(sizeof(struct Graph));
+    struct Rng rng;
+    rngSeed(&rng, 1);
+    for (unsigned long long seed = 1; seed <= 4; seed++) {
+        int n = 200 + 300 * (int) seed;
+        randomGraph(graph, n, 1000.0, seed);
+        constructTour(graph, START_GREEDY_EDGE, NULL, NULL, tours[0]);
+        for (int t = 1; t < 5; t++) {
+            memcpy(tours[t], tours[0], sizeof(tours[0]));
+            perturbTour(tours[t], n, 10, &rng);
+        }
+        double merged;
+        CHECK(checkMerge(graph, 5, &merged));
+    }
+    free(graph);
+}
+
+// Tours from different constructions share less; the merge may fall back to the
+// reduced search but never gets longer than the best tour
+void checkConstructedTours(void) {
+    struct Graph *graph = malloc(sizeof(struct Graph));
+    int methods[] = {START_GREEDY_EDGE, START_NEAREST_NEIGHBOR, START_SPACE_FILLING_CURVE, START_CHRISTOFIDES};
+    randomGraph(graph, 300, 1000.0, 5);
+    for (int m = 0; m < 4; m++) {
+        constructTour(graph, methods[m], NULL, NULL, tours[m]);
+    }
+    double merged;
+    checkMerge(graph, 4, &merged);
+
+    // The same tour any number of times is its own merge
+    constructTour(graph, START_GREEDY_EDGE, NULL, NULL, tours[0]);
+    double length = calculateTourLength(graph, tours[0]);
+    for (int t = 1; t < 3; t++) {
+        memcpy(tours[t], tours[0], sizeof(tours[0]));
+    }
+    CHECK(checkMerge(graph, 3, &merged));
+    CHECK(fabs(merged - length) < 1e-9 * length);
+    free(graph);
+}
+
+// Shortest tour that continues path with edges of the tours only (times[a][b] > 0 of
+// numTours) and keeps the numShared edges of all of them
+double exhaustiveShortest(struct Graph *graph, int (*times)[SMALL_CITIES], int numTours, int numShared, int *path,
+                          int count, bool *used, double length) {
+    int n = graph->numNodes;
+    int last = path[count - 1];
+    if (count == n) {
+        int kept = 0;
+        for (int i = 0; i < n; i++) {
+            kept += times[path[i]][path[(i + 1) % n]] == numTours;
+        }
+        return times[last][path[0]] > 0 && kept == numShared
+                       ? length + calculateDistance(graph->nodes[last], graph->nodes[path[0]])
+                       : DBL_MAX;
+    }
+    double best = DBL_MAX;
+    for (int v = 1; v < n; v++) {
+        if (!used[v] && times[last][v] > 0) {
+            used[v] = true;
+            path[count] = v;
+            best = fmin(best, exhaustiveShortest(graph, times, numTours, numShared, path, count + 1, used,
+                                                 length + calculateDistance(graph->nodes[last], graph->nodes[v])));
+            used[v] = false;
+        }
+    }
+    return best;
+}
+
+// Random tours of a few cities: their union is dense, and the merge must find the
+// shortest tour in it that keeps the shared edges
+void checkSmallExact(void) {
+    struct Graph *graph = malloc(sizeof(struct Graph));
+    struct Rng rng;
+    rngSeed(&rng, 2);
+    for (unsigned long long seed = 1; seed <= 40; seed++) {
+        int n = 5 + (int) (seed % (SMALL_CITIES - 4));
+        int numTours = 2 + (int) (seed % 3);
+        randomGraph(graph, n, 100.0, 10 + seed);
+        int times[SMALL_CITIES][SMALL_CITIES] = {{0}};
+        for (int t = 0; t < numTours; t++) {
+            for (int i = 0; i < n; i++) {
+                tours[t][i] = i;
+            }
+            for (int i = n - 1; i > 0; i--) {
+                int j = rngInt(&rng, i + 1);
+                int swap = tours[t][i];
+                tours[t][i] = tours[t][j];
+                tours[t][j] = swap;
+            }
+            for (int i = 0; i < n; i++) {
+                times[tours[t][i]][tours[t][(i + 1) % n]]++;
+                times[tours[t][(i + 1) % n]][tours[t][i]]++;
+            }
+        }
+        int numShared = 0;
+        for (int a = 0; a < n; a++) {
+            for (int b = a + 1; b < n; b++) {
+                numShared += times[a][b] == numTours;
+            }
+        }
+        double merged;
+        if (checkMerge(graph, numTours, &merged)) {
+            int path[SMALL_CITIES] = {0};
+            bool used[SMALL_CITIES] = {true};
+            double shortest = exhaustiveShortest(graph, times, numTours, numShared, path, 1, used, 0.0);
+            CHECK(fabs(merged - shortest) < 1e-9 * merged);
+        }
+    }
+    free(graph);
+}
+
+int main(void) {
+    tours = malloc(MERGE_MAX_TOURS * sizeof(*tours));
+    checkNearbyTours();
+    checkConstructedTours();
+    checkSmallExact();
+    free(tours);
+    return checkResult("merge");
+}
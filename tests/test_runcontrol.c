@@ -0,0 +1,199 @@
+// Checks of the run control (RUNCONTROL.h): the first reason to stop is kept, phases
+// stop at the earlier deadline, and every solver stops near its deadline, on the
+// cancel flag and at the target length, returning a tour in each case.
+
+#include "CHECK.h"
+
+#define RUN_CITIES 1000
+#define RUN_BUDGET 0.3
+#define RUN_MARGIN 1.0   // Seconds a solver may overrun its deadline, for a busy machine
+
+void checkStopOrder(void) {
+    CHECK(!runShouldStop(NULL, 1.0));
+    CHECK(!runShouldStopEvery(NULL, 0, 1.0));
+    runBegin(NULL);
+    runEnd(NULL, 1.0, 1);
+
+    struct RunControl control;
+    atomic_bool cancel;
+    atomic_init(&cancel, false);
+    runControlInit(&control);
+    control.deadline = currentTimeSeconds() + 100.0;
+    control.targetLength = 10.0;
+    control.cancel = &cancel;
+    runBegin(&control);
+    CHECK(!runShouldStop(&control, 20.0));
+    CHECK(runShouldStop(&control, 10.0));
+    CHECK(atomic_load(&control.status) == RUN_TARGET);
+    // A later reason does not replace the first, nor does the end of the run
+    atomic_store(&cancel, true);
+    CHECK(runShouldStop(&control, 20.0));
+    CHECK(atomic_load(&control.status) == RUN_TARGET);
+    runEnd(&control, 10.0, 7);
+    CHECK(atomic_load(&control.status) == RUN_TARGET);
+    CHECK(control.bestLength == 10.0 && control.iterations == 7 && control.elapsed >= 0.0);
+
+    // Cancelling comes before the target, and the target before the deadline
+    runBegin(&control);
+    control.deadline = currentTimeSeconds() - 1.0;
+    CHECK(runShouldStop(&control, 10.0));
+    CHECK(atomic_load(&control.status) == RUN_CANCELLED);
+    atomic_store(&cancel, false);
+    runBegin(&control);
+    CHECK(runShouldStop(&control, 10.0));
+    CHECK(atomic_load(&control.status) == RUN_TARGET);
+    runBegin(&control);
+    CHECK(runShouldStop(&control, 20.0));
+    CHECK(atomic_load(&control.status) == RUN_DEADLINE);
+
+    // Only every RUN_CHECK_INTERVAL-th move polls
+    runBegin(&control);
+    CHECK(!runShouldStopEvery(&control, 1, 20.0));
+    CHECK(!runShouldStopEvery(&control, RUN_CHECK_INTERVAL - 1, 20.0));
+    CHECK(atomic_load(&control.status) == RUN_RUNNING);
+    CHECK(runShouldStopEvery(&control, RUN_CHECK_INTERVAL, 20.0));
+    CHECK(atomic_load(&control.status) == RUN_DEADLINE);
+
+    // A run ending on its own completes, unless it ends past the deadline
+    runBegin(&control);
+    control.deadline = 0.0;
+    runEnd(&control, 20.0, 1);
+    CHECK(atomic_load(&control.status) == RUN_COMPLETED);
+    runBegin(&control);
+    control.deadline = currentTimeSeconds() - 1.0;
+    runEnd(&control, 20.0, 1);
+    CHECK(atomic_load(&control.status) == RUN_DEADLINE);
+}
+
+void checkPhases(void) {
+    struct RunControl control, phase;
+    atomic_bool cancel;
+    atomic_init(&cancel, false);
+    runControlInit(&control);
+    control.cancel = &cancel;
+
+    // The earlier deadline bounds the phase, 0 being none
+    runPhaseBegin(&phase, NULL, 5.0);
+    CHECK(phase.deadline == 5.0 && phase.cancel == NULL);
+    control.deadline = 3.0;
+    runPhaseBegin(&phase, &control, 5.0);
+    CHECK(phase.deadline == 3.0 && phase.cancel == &cancel);
+    runPhaseBegin(&phase, &control, 2.0);
+    CHECK(phase.deadline == 2.0);
+    runPhaseBegin(&phase, &control, 0.0);
+    CHECK(phase.deadline == 3.0);
+    control.deadline = 0.0;
+    runPhaseBegin(&phase, &control, 2.0);
+    CHECK(phase.deadline == 2.0);
+    runPhaseBegin(&phase, &control, 0.0);
+    CHECK(phase.deadline == 0.0);
+
+    // The phase sees the run's cancel flag but stops with a status of its own
+    runBegin(&control);
+    runPhaseBegin(&phase, &control, 0.0);
+    atomic_store(&cancel, true);
+    CHECK(runShouldStop(&phase, 1.0));
+    CHECK(atomic_load(&phase.status) == RUN_CANCELLED);
+    CHECK(atomic_load(&control.status) == RUN_RUNNING);
+}
+
+// Runs solver s from a space-filling curve tour; returns the seconds it took
+double runSolver(int s, struct Graph *graph, struct RunControl *control, double timeLimit, int *tour) {
+    constructTour(graph, START_SPACE_FILLING_CURVE, NULL, NULL, tour);
+    void *context = solvers[s].create();
+    struct SolverSettings settings;
+    solverSettingsInit(&settings);
+    settings.seed = 1;
+    settings.timeLimit = timeLimit;
+    settings.threads = 1;
+    settings.control = control;
+    solvers[s].configure(context, &settings);
+    double start = currentTimeSeconds();
+    solvers[s].solve(context, graph, tour);
+    double elapsed = currentTimeSeconds() - start;
+    solvers[s].destroy(context);
+    CHECK(isTourPermutation(tour, graph->numNodes));
+    return elapsed;
+}
+
+struct DelayedCancel {
+    atomic_bool *cancel;
+    double delay;
+};
+
+void *cancelThread(void *arg) {
+    struct DelayedCancel *delayed = arg;
+    double start = currentTimeSeconds();
+    while (currentTimeSeconds() < start + delayed->delay) {
+        usleep(1000);
+    }
+    atomic_store(delayed->cancel, true);
+    return NULL;
+}
+
+// Each solver stops at the control's deadline, on a cancel flag set before or during
+// the run and once it reaches a target length
+void checkSolverStops(void) {
+    struct Graph *graph = malloc(sizeof(struct Graph));
+    randomGraph(graph, RUN_CITIES, 1000.0, 1);
+    int tour[MAX_NODES];
+    for (int s = 0; s < NUM_SOLVERS; s++) {
+        // A budgeted run, which some solvers end on their own rule first
+        struct RunControl control;
+        runControlInit(&control);
+        control.deadline = currentTimeSeconds() + RUN_BUDGET;
+        double elapsed = runSolver(s, graph, &control, RUN_BUDGET, tour);
+        int status = atomic_load(&control.status);
+        CHECK(elapsed < RUN_BUDGET + RUN_MARGIN);
+        CHECK(status == RUN_DEADLINE || status == RUN_COMPLETED);
+        CHECK(fabs(control.bestLength - calculateTourLength(graph, tour)) < 1e-6 * control.bestLength);
+
+        // A deadline already passed stops every solver at its first poll
+        runControlInit(&control);
+        control.deadline = currentTimeSeconds() - 1.0;
+        elapsed = runSolver(s, graph, &control, 0.0, tour);
+        CHECK(elapsed < RUN_MARGIN);
+        CHECK(atomic_load(&control.status) == RUN_DEADLINE);
+
+        // A long budget cut short by the cancel flag
+        atomic_bool cancel;
+        atomic_init(&cancel, false);
+        runControlInit(&control);
+        control.deadline = currentTimeSeconds() + 100.0;
+        control.cancel = &cancel;
+        struct DelayedCancel delayed = {&cancel, RUN_BUDGET};
+        pthread_t thread;
+        pthread_create(&thread, NULL, cancelThread, &delayed);
+        elapsed = runSolver(s, graph, &control, 100.0, tour);
+        pthread_join(thread, NULL);
+        status = atomic_load(&control.status);
+        CHECK(elapsed < RUN_BUDGET + RUN_MARGIN);
+        CHECK(status == RUN_CANCELLED || status == RUN_COMPLETED);
+
+        // A cancelled run still returns a tour
+        runControlInit(&control);
+        control.cancel = &cancel;
+        runSolver(s, graph, &control, 100.0, tour);
+        CHECK(atomic_load(&control.status) == RUN_CANCELLED);
+
+        // The starting tour's length as the target: reached at the first poll, after the
+        // population for the genetic solvers
+        int start[MAX_NODES];
+        constructTour(graph, START_SPACE_FILLING_CURVE, NULL, NULL, start);
+        runControlInit(&control);
+        control.deadline = currentTimeSeconds() + 100.0;
+        control.targetLength = calculateTourLength(graph, start);
+        elapsed = runSolver(s, graph, &control, 100.0, tour);
+        CHECK(elapsed < RUN_MARGIN);
+        CHECK(atomic_load(&control.status) == RUN_TARGET);
+        CHECK(calculateTourLength(graph, tour) <= control.targetLength * (1.0 + 1e-9));
+    }
+    free(graph);
+}
+
+int main(void) {
+    checkStopOrder();
+    checkPhases();
+    checkSolverStops();
+    return checkResult("runcontrol");
+}
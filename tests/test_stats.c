@@ -0,0 +1,52 @@
+// Checks of the sample summaries (STATS.h) against values worked out by hand.
+
+#include "CHECK.h"
+
+#define CLOSE(a, b) (fabs((a) - (b)) < 1e-9)
+
+void checkFiveSamples(void) {
+    double samples[5] = {4.0, 1.0, 3.0, 5.0, 2.0};
+    struct SampleSummary summary;
+    summarizeSamples(samples, 5, &summary);
+    CHECK(summary.count == 5);
+    CHECK(summary.min == 1.0 && summary.max == 5.0);
+    CHECK(CLOSE(summary.mean, 3.0));
+    CHECK(CLOSE(summary.stdDev, sqrt(2.5)));
+    CHECK(CLOSE(summary.p10, 1.4));
+    CHECK(CLOSE(summary.p25, 2.0));
+    CHECK(CLOSE(summary.median, 3.0));
+    CHECK(CLOSE(summary.p75, 4.0));
+    CHECK(CLOSE(summary.p90, 4.6));
+    // The samples keep their order
+    CHECK(samples[0] == 4.0 && samples[1] == 1.0 && samples[4] == 2.0);
+}
+
+void checkEvenCount(void) {
+    double samples[4] = {10.0, 40.0, 20.0, 30.0};
+    struct SampleSummary summary;
+    summarizeSamples(samples, 4, &summary);
+    CHECK(CLOSE(summary.median, 25.0));
+    CHECK(CLOSE(summary.p25, 17.5));
+    CHECK(CLOSE(summary.p75, 32.5));
+}
+
+void checkFewSamples(void) {
+    double one = 7.0;
+    struct SampleSummary summary;
+    summarizeSamples(&one, 1, &summary);
+    CHECK(summary.count == 1);
+    CHECK(summary.min == 7.0 && summary.max == 7.0 && summary.mean == 7.0);
+    CHECK(summary.stdDev == 0.0);
+    CHECK(summary.p10 == 7.0 && summary.median == 7.0 && summary.p90 == 7.0);
+
+    summarizeSamples(NULL, 0, &summary);
+    CHECK(summary.count == 0);
+    CHECK(summary.mean == 0.0 && summary.stdDev == 0.0 && summary.median == 0.0);
+}
+
+int main(void) {
+    checkFiveSamples();
+    checkEvenCount();
+    checkFewSamples();
+    return checkResult("stats");
+}
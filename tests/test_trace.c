@@ -0,0 +1,90 @@
+// Checks of the convergence traces (TRACE.h): only improvements are recorded, the ring
+// keeps the newest TRACE_CAPACITY events, slots not yet published are skipped, and
+// threads racing to improve leave the events in order.
+
+#include <pthread.h>
+
+#include "CHECK.h"
+
+#define TRACE_THREADS 4
+#define TRACE_STEPS 200000
+
+struct Trace trace;
+struct TraceEvent events[TRACE_CAPACITY];
+
+// Events from oldest to newest must improve strictly and never go back in time
+void checkOrdered(int numEvents) {
+    int unordered = 0;
+    for (int e = 1; e < numEvents; e++) {
+        unordered += events[e].length >= events[e - 1].length || events[e].time < events[e - 1].time;
+    }
+    CHECK(unordered == 0);
+}
+
+void checkImprovements(void) {
+    traceImprove(NULL, 1.0, 1);
+    traceStart(&trace, 100.0);
+    traceImprove(&trace, 90.0, 1);
+    traceImprove(&trace, 95.0, 2);
+    traceImprove(&trace, 90.0, 3);
+    traceImprove(&trace, 80.0, 4);
+    CHECK(traceEvents(&trace, events) == 3);
+    CHECK(events[0].length == 100.0 && events[0].iteration == 0);
+    CHECK(events[1].length == 90.0 && events[1].iteration == 1);
+    CHECK(events[2].length == 80.0 && events[2].iteration == 4);
+}
+
+// A slot claimed by a thread that has not written it yet is left out
+void checkUnpublished(void) {
+    traceStart(&trace, 100.0);
+    traceImprove(&trace, 90.0, 1);
+    atomic_fetch_add(&trace.count, 1);
+    traceImprove(&trace, 80.0, 3);
+    CHECK(traceEvents(&trace, events) == 3);
+    CHECK(events[1].length == 90.0 && events[2].length == 80.0);
+}
+
+void checkRingWraps(void) {
+    traceStart(&trace, 1e9);
+    for (int i = 1; i <= TRACE_CAPACITY + 100; i++) {
+        traceImprove(&trace, 1e9 - i, i);
+    }
+    int numEvents = traceEvents(&trace, events);
+    CHECK(numEvents == TRACE_CAPACITY);
+    CHECK(events[0].iteration == 101);
+    CHECK(events[numEvents - 1].iteration == TRACE_CAPACITY + 100);
+    checkOrdered(numEvents);
+}
+
+void *improveThread(void *arg) {
+    int thread = *(int *) arg;
+    for (int step = TRACE_STEPS; step > 0; step--) {
+        traceImprove(&trace, step * TRACE_THREADS + thread, step);
+    }
+    return NULL;
+}
+
+void checkConcurrent(void) {
+    traceStart(&trace, 1e9);
+    pthread_t threads[TRACE_THREADS];
+    int ids[TRACE_THREADS];
+    for (int t = 0; t < TRACE_THREADS; t++) {
+        ids[t] = t;
+        pthread_create(&threads[t], NULL, improveThread, &ids[t]);
+    }
+    for (int t = 0; t < TRACE_THREADS; t++) {
+        pthread_join(threads[t], NULL);
+    }
+    int numEvents = traceEvents(&trace, events);
+    checkOrdered(numEvents);
+    CHECK(atomic_load(&trace.best) == TRACE_THREADS);
+    CHECK(numEvents > 0 && events[numEvents - 1].length == TRACE_THREADS);
+}
+
+int main(void) {
+    checkImprovements();
+    checkUnpublished();
+    checkRingWraps();
+    checkConcurrent();
+    return checkResult("trace");
+}
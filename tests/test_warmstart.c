@@ -0,0 +1,94 @@
+// Checks of the warm starts (WARMSTART.h): a results file written by writeOutput and a
+// TSPLIB .tour file read back to the same tour, in the numbering of the graph passed,
+// and every file that does not hold a tour of the graph rejected.
+
+#include "CHECK.h"
+
+char folder[64];
+
+// Writes text to <folder>/<name>, and its path into path
+void writeTestFile(const char *name, const char *text, char *path, size_t size) {
+    snprintf(path, size, "%s/%s", folder, name);
+    FILE *file = fopen(path, "w");
+    if (file == NULL) {
+        perror(path);
+        exit(1);
+    }
+    fputs(text, file);
+    fclose(file);
+}
+
+void checkResultsFile(void) {
+    struct Graph *graph = malloc(sizeof(struct Graph));
+    randomGraph(graph, 30, 100.0, 1);
+    int tour[MAX_NODES], loaded[MAX_NODES];
+    constructTour(graph, START_GREEDY_EDGE, NULL, NULL, tour);
+    writeOutput(graph, tour, calculateTourLength(graph, tour), 1.0, 0.0, 0.0, "CHECK", "cities.txt", folder);
+    char path[128];
+    resultsFilename(path, sizeof(path), folder, "CHECK", "cities.txt");
+
+    CHECK(loadTourFile(graph, path, loaded));
+    CHECK(memcmp(loaded, tour, 30 * sizeof(int)) == 0);
+
+    // The same file read into the renumbered graph names the same cities
+    struct Graph *renumbered = malloc(sizeof(struct Graph));
+    *renumbered = *graph;
+    struct CityOrder order;
+    renumberCities = true;
+    renumberGraph(renumbered, &order);
+    CHECK(loadTourFile(renumbered, path, loaded));
+    for (int i = 0; i < 30; i++) {
+        CHECK(loaded[i] == order.internal[tour[i]]);
+    }
+    remove(path);
+    free(renumbered);
+    free(graph);
+}
+
+void checkTsplibFile(void) {
+    struct Graph *graph = malloc(sizeof(struct Graph));
+    randomGraph(graph, 5, 10.0, 2);
+    int loaded[MAX_NODES];
+    char path[128];
+    writeTestFile("five.tour", "NAME : five\nTYPE : TOUR\nDIMENSION : 5\nTOUR_SECTION\n3\n1\n5\n2\n4\n-1\nEOF\n",
+                  path, sizeof(path));
+    CHECK(loadTourFile(graph, path, loaded));
+    int expected[5] = {2, 0, 4, 1, 3};
+    CHECK(memcmp(loaded, expected, sizeof(expected)) == 0);
+    remove(path);
+    free(graph);
+}
+
+void checkRejected(void) {
+    struct Graph *graph = malloc(sizeof(struct Graph));
+    randomGraph(graph, 5, 10.0, 3);
+    int loaded[MAX_NODES];
+    char path[128];
+    const char *files[][2] = {
+            {"short.tour", "TOUR_SECTION\n1 2 3 4 -1\n"},
+            {"long.tour", "TOUR_SECTION\n1 2 3 4 5 2 -1\n"},
+            {"repeated.tour", "TOUR_SECTION\n1 2 3 3 5 -1\n"},
+            {"unknown.tour", "TOUR_SECTION\n1 2 3 4 9 -1\n"},
+            {"nosection.tour", "1 2 3 4 5\n"},
+    };
+    for (int f = 0; f < (int) (sizeof(files) / sizeof(files[0])); f++) {
+        writeTestFile(files[f][0], files[f][1], path, sizeof(path));
+        if (loadTourFile(graph, path, loaded)) {
+            printf("%s was accepted\n", files[f][0]);
+            checkFailures++;
+        }
+        remove(path);
+    }
+    snprintf(path, sizeof(path), "%s/missing.tour", folder);
+    CHECK(!loadTourFile(graph, path, loaded));
+    free(graph);
+}
+
+int main(void) {
+    checkTempFolder(folder, sizeof(folder));
+    checkResultsFile();
+    checkTsplibFile();
+    checkRejected();
+    rmdir(folder);
+    return checkResult("warmstart");
+}
@@ -0,0 +1,248 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+#include <sys/time.h>
+#include <string.h>
+#include <dirent.h>
+
+#include "headers/TSPUTILS.h"
+#include "headers/TOURHASH.h"
+#include "headers/TRACE.h"
+#include "headers/RUNCONTROL.h"
+#include "headers/NEIGHBORS.h"
+#include "headers/MATCHING.h"
+#include "headers/CONSTRUCT.h"
+#include "headers/WARMSTART.h"
+#include "headers/LK.h"
+#include "headers/VNS.h"
+#include "headers/BACKBONE.h"
+#include "headers/MERGE.h"
+#include "headers/GPX.h"
+#include "headers/EAX.h"
+#include "headers/SA2OPT.h"
+#include "headers/SOLVERS.h"
+#include "headers/DYNAMIC.h"
+#include "headers/TSPSOLVER.h"
+
+_Static_assert(TSP_STATUS_COMPLETED == RUN_COMPLETED && TSP_STATUS_DEADLINE == RUN_DEADLINE &&
+               TSP_STATUS_TARGET == RUN_TARGET && TSP_STATUS_CANCELLED == RUN_CANCELLED,
+               "TSP_STATUS_* must match the RUN_* codes of RUNCONTROL.h");
+
+// The graph is renumbered for the solvers; order maps it back to input order
+struct TspInstance {
+    struct Graph graph;
+    struct CityOrder order;
+};
+
+struct TspSolver {
+    int index;       // In solvers[]
+    void *context;
+};
+
+struct TspDynamic {
+    struct DynamicTour tour;
+};
+
+int tspInstanceFinish(struct TspInstance *instance, struct TspInstance **result) {
+    if (instance->graph.numNodes < 1) {
+        free(instance);
+        return TSP_ERROR_SIZE;
+    }
+    renumberGraph(&instance->graph, &instance->order);
+    *result = instance;
+    return TSP_OK;
+}
+
+TSP_API int tspInstanceLoad(const char *filename, struct TspInstance **instance) {
+    struct TspInstance *loaded = malloc(sizeof(struct TspInstance));
+    if (!loadInput(&loaded->graph, filename)) {
+        free(loaded);
+        return TSP_ERROR_FILE;
+    }
+    return tspInstanceFinish(loaded, instance);
+}
+
+TSP_API int tspInstanceCreate(const double *x, const double *y, int numNodes, struct TspInstance **instance) {
+    if (numNodes < 1 || numNodes > MAX_NODES) {
+        return TSP_ERROR_SIZE;
+    }
+    struct TspInstance *created = malloc(sizeof(struct TspInstance));
+    for (int i = 0; i < numNodes; i++) {
+        created->graph.nodes[i].id = i + 1;
+        created->graph.nodes[i].x = x[i];
+        created->graph.nodes[i].y = y[i];
+    }
+    created->graph.numNodes = numNodes;
+    return tspInstanceFinish(created, instance);
+}
+
+TSP_API int tspInstanceSize(const struct TspInstance *instance) {
+    return instance->graph.numNodes;
+}
+
+TSP_API void tspInstanceFree(struct TspInstance *instance) {
+    free(instance);
+}
+
+TSP_API int tspSolverCount(void) {
+    return NUM_SOLVERS;
+}
+
+TSP_API const char *tspSolverName(int index) {
+    return index >= 0 && index < NUM_SOLVERS ? solvers[index].name : NULL;
+}
+
+TSP_API struct TspSolver *tspSolverCreate(const char *name) {
+    int index = findSolver(name);
+    if (index < 0) {
+        return NULL;
+    }
+    struct TspSolver *solver = malloc(sizeof(struct TspSolver));
+    solver->index = index;
+    solver->context = solvers[index].create();
+    return solver;
+}
+
+TSP_API void tspSolverFree(struct TspSolver *solver) {
+    if (solver != NULL) {
+        solvers[solver->index].destroy(solver->context);
+        free(solver);
+    }
+}
+
+TSP_API int tspTourLoad(const struct TspInstance *instance, const char *filename, int *tour) {
+    FILE *file = fopen(filename, "r");
+    if (file == NULL) {
+        return TSP_ERROR_FILE;
+    }
+    fclose(file);
+    int internal[MAX_NODES];
+    if (!loadTourFile((struct Graph *) &instance->graph, filename, internal)) {
+        return TSP_ERROR_TOUR;
+    }
+    mapTour(instance->order.original, instance->graph.numNodes, internal, tour);
+    return TSP_OK;
+}
+
+TSP_API void tspOptionsInit(struct TspOptions *options) {
+    options->timeLimit = 0.0;
+    options->targetLength = 0.0;
+    options->cancel = NULL;
+    options->seed = 1;
+    options->threads = 0;
+    options->startTour = NULL;
+}
+
+TSP_API int tspSolve(struct TspSolver *solver, const struct TspInstance *instance, const struct TspOptions *options,
+                     struct TspResult *result) {
+    // The solvers only read the graph and the order
+    struct Graph *graph = (struct Graph *) &instance->graph;
+    struct CityOrder *order = (struct CityOrder *) &instance->order;
+    int n = graph->numNodes;
+    int tour[MAX_NODES];
+    if (options->startTour != NULL) {
+        if (!isTourPermutation(options->startTour, n)) {
+            return TSP_ERROR_TOUR;
+        }
+        mapTour(order->internal, n, options->startTour, tour);
+    } else {
+        constructTour(graph, START_GREEDY_EDGE, NULL, order, tour);
+    }
+
+    // The control enforces the time limit on LK too, which has none of its own
+    struct RunControl control;
+    runControlInit(&control);
+    control.deadline = options->timeLimit > 0.0 ? currentTimeSeconds() + options->timeLimit : 0.0;
+    control.targetLength = options->targetLength;
+    control.cancel = options->cancel;
+
+    struct SolverSettings settings;
+    solverSettingsInit(&settings);
+    settings.seed = options->seed;
+    settings.timeLimit = options->timeLimit;
+    settings.threads = options->threads;
+    settings.control = &control;
+    solvers[solver->index].configure(solver->context, &settings);
+    solvers[solver->index].solve(solver->context, graph, tour);
+
+    result->tour = malloc(n * sizeof(int));
+    mapTour(order->original, n, tour, result->tour);
+    result->numNodes = n;
+    result->length = calculateTourLength(graph, tour);
+    result->status = atomic_load(&control.status);
+    result->elapsed = control.elapsed;
+    result->iterations = control.iterations;
+    return TSP_OK;
+}
+
+TSP_API void tspResultFree(struct TspResult *result) {
+    free(result->tour);
+    result->tour = NULL;
+}
+
+TSP_API const char *tspStatusName(int status) {
+    return status >= RUN_RUNNING && status <= RUN_CANCELLED ? runStatusNames[status] : "unknown";
+}
+
+// The dynamic tour works on the cities in input order, with the input indices as ids
+TSP_API int tspDynamicCreate(const struct TspInstance *instance, const int *tour, struct TspDynamic **dynamic) {
+    const struct Graph *graph = &instance->graph;
+    const struct CityOrder *order = &instance->order;
+    int n = graph->numNodes;
+    int start[MAX_NODES];
+    if (tour != NULL) {
+        if (!isTourPermutation(tour, n)) {
+            return TSP_ERROR_TOUR;
+        }
+        memcpy(start, tour, n * sizeof(int));
+    } else {
+        int internal[MAX_NODES];
+        constructTour((struct Graph *) graph, START_GREEDY_EDGE, NULL, (struct CityOrder *) order, internal);
+        mapTour(order->original, n, internal, start);
+    }
+
+    struct Graph *cities = malloc(sizeof(struct Graph));
+    for (int i = 0; i < n; i++) {
+        cities->nodes[i] = graph->nodes[order->internal[i]];
+        cities->nodes[i].id = i;
+    }
+    cities->numNodes = n;
+    struct TspDynamic *created = malloc(sizeof(struct TspDynamic));
+    dynamicTourInit(&created->tour, cities, start);
+    free(cities);
+    *dynamic = created;
+    return TSP_OK;
+}
+
+TSP_API int tspDynamicInsert(struct TspDynamic *dynamic, int id, double x, double y) {
+    if (dynamic->tour.graph.numNodes == MAX_NODES) {
+        return TSP_ERROR_SIZE;
+    }
+    return id >= 0 && dynamicInsert(&dynamic->tour, id, x, y) ? TSP_OK : TSP_ERROR_CITY;
+}
+
+TSP_API int tspDynamicRemove(struct TspDynamic *dynamic, int id) {
+    return dynamicRemove(&dynamic->tour, id) ? TSP_OK : TSP_ERROR_CITY;
+}
+
+TSP_API int tspDynamicSize(const struct TspDynamic *dynamic) {
+    return dynamic->tour.graph.numNodes;
+}
+
+TSP_API double tspDynamicLength(const struct TspDynamic *dynamic) {
+    return dynamic->tour.length;
+}
+
+TSP_API void tspDynamicTour(const struct TspDynamic *dynamic, int *ids) {
+    for (int i = 0, city = 0; i < dynamic->tour.graph.numNodes; i++, city = dynamic->tour.succ[city]) {
+        ids[i] = dynamic->tour.graph.nodes[city].id;
+    }
+}
+
+TSP_API void tspDynamicFree(struct TspDynamic *dynamic) {
+    if (dynamic != NULL) {
+        dynamicTourFree(&dynamic->tour);
+        free(dynamic);
+    }
+}